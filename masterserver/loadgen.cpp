@@ -0,0 +1,475 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Zandronum Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: loadgen.cpp
+//
+// Description: Simulates a large number of servers and launchers talking to a master server, to measure how many launcher queries it can answer per second and how long it takes.
+//
+//-----------------------------------------------------------------------------
+
+#include "../src/networkheaders.h"
+#include "../src/networkshared.h"
+#include "../src/huffman/huffman.h"
+#include "version.h"
+#include <poll.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+//*****************************************************************************
+//	DEFINES
+
+// The simulated servers and launchers use addresses from these loopback networks,
+// so that the master server's per-IP limits don't apply.
+#define	LOADGEN_SERVER_NET			1
+#define	LOADGEN_LAUNCHER_NET		2
+
+// How often the simulated servers tell the master server that they're still there (seconds).
+#define	LOADGEN_HEARTBEAT_INTERVAL	20
+
+// How long we wait for the answer to a query before considering it lost (ms).
+#define	LOADGEN_QUERY_TIMEOUT		2000
+
+//*****************************************************************************
+//	STRUCTURES
+
+typedef std::chrono::steady_clock Clock;
+
+struct LOADGENSERVER_s
+{
+	SOCKET				Socket;
+	std::string			VerificationString;
+	Clock::time_point	LastHeartbeat;
+};
+
+struct LOADGENQUERY_s
+{
+	SOCKET				Socket;
+	Clock::time_point	StartTime;
+	unsigned int		ulNumPacketsReceived;
+	int					iNumPackets; // -1 until we received the last packet.
+	unsigned int		ulNumServers;
+};
+
+//*****************************************************************************
+//	VARIABLES
+
+static	NETADDRESS_s	g_MasterAddress;
+static	NETBUFFER_s		g_OutBuffer;
+static	NETBUFFER_s		g_InBuffer;
+static	BYTE			g_abHuffmanBuffer[MAX_UDP_PACKET * 4];
+static	unsigned int	g_ulNextLauncherAddress = 0;
+
+//*****************************************************************************
+//	FUNCTIONS
+
+static SOCKET loadgen_OpenSocket( int iNet, unsigned int ulIndex, USHORT usPort )
+{
+	SOCKET Socket = socket( PF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if ( Socket == INVALID_SOCKET )
+		return INVALID_SOCKET;
+
+	struct sockaddr_in address;
+	memset( &address, 0, sizeof( address ));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(( 127u << 24 ) | ( iNet << 16 ) | (( ulIndex / 254 ) % 256 << 8 ) | ( ulIndex % 254 + 1 ));
+	address.sin_port = htons( usPort );
+
+	ULONG ulArg = true;
+	if (( bind( Socket, (sockaddr *)&address, sizeof( address )) == SOCKET_ERROR ) || ( ioctlsocket( Socket, FIONBIO, &ulArg ) == -1 ))
+	{
+		closesocket( Socket );
+		return INVALID_SOCKET;
+	}
+
+	return Socket;
+}
+
+//*****************************************************************************
+//
+// Returns false if the packet couldn't be sent.
+static bool loadgen_Send( SOCKET Socket, NETBUFFER_s &Buffer )
+{
+	int iNumBytesOut = sizeof( g_abHuffmanBuffer );
+	struct sockaddr_in SocketAddress;
+
+	Buffer.ulCurrentSize = Buffer.CalcSize();
+	HUFFMAN_Encode( Buffer.pbData, g_abHuffmanBuffer, Buffer.ulCurrentSize, &iNumBytesOut );
+	g_MasterAddress.ToSocketAddress( reinterpret_cast<sockaddr&>( SocketAddress ));
+	return ( sendto( Socket, (const char *)g_abHuffmanBuffer, iNumBytesOut, 0, reinterpret_cast<sockaddr*>( &SocketAddress ), sizeof( SocketAddress )) >= 0 );
+}
+
+//*****************************************************************************
+//
+// Reads the next packet from the socket into g_InBuffer. Returns false if there is none.
+static bool loadgen_Receive( SOCKET Socket )
+{
+	const int iNumBytes = recv( Socket, (char *)g_abHuffmanBuffer, sizeof( g_abHuffmanBuffer ), 0 );
+	if ( iNumBytes <= 0 )
+		return false;
+
+	int iDecodedNumBytes = g_InBuffer.ulMaxSize;
+	HUFFMAN_Decode( g_abHuffmanBuffer, g_InBuffer.pbData, iNumBytes, &iDecodedNumBytes );
+	g_InBuffer.ulCurrentSize = iDecodedNumBytes;
+	g_InBuffer.ByteStream.pbStream = g_InBuffer.pbData;
+	g_InBuffer.ByteStream.pbStreamEnd = g_InBuffer.pbData + iDecodedNumBytes;
+	return true;
+}
+
+//*****************************************************************************
+//
+static void loadgen_SendHeartbeat( LOADGENSERVER_s &Server )
+{
+	g_OutBuffer.Clear();
+	g_OutBuffer.ByteStream.WriteLong( SERVER_MASTER_CHALLENGE );
+	g_OutBuffer.ByteStream.WriteString( Server.VerificationString.c_str() );
+	g_OutBuffer.ByteStream.WriteByte( 1 ); // We enforce the master bans.
+	g_OutBuffer.ByteStream.WriteLong( GetRevisionNumber() );
+	loadgen_Send( Server.Socket, g_OutBuffer );
+	Server.LastHeartbeat = Clock::now();
+}
+
+//*****************************************************************************
+//
+static void loadgen_ServerReceive( LOADGENSERVER_s &Server )
+{
+	while ( loadgen_Receive( Server.Socket ))
+	{
+		BYTESTREAM_s *pByteStream = &g_InBuffer.ByteStream;
+
+		switch ( pByteStream->ReadByte() )
+		{
+		case MASTER_SERVER_VERIFICATION:
+			{
+				const std::string VerificationString = pByteStream->ReadString();
+				const LONG lVerificationInt = pByteStream->ReadLong();
+
+				g_OutBuffer.Clear();
+				g_OutBuffer.ByteStream.WriteLong( SERVER_MASTER_VERIFICATION );
+				g_OutBuffer.ByteStream.WriteString( VerificationString.c_str() );
+				g_OutBuffer.ByteStream.WriteLong( lVerificationInt );
+				loadgen_Send( Server.Socket, g_OutBuffer );
+			}
+			break;
+
+		case MASTER_SERVER_BANLISTPART:
+			{
+				const std::string VerificationString = pByteStream->ReadString();
+
+				// Skip the packet number and bans, we only need to know if this is the last part.
+				pByteStream->ReadByte();
+				int iEntryType;
+				while ((( iEntryType = pByteStream->ReadByte() ) == MSB_BAN ) || ( iEntryType == MSB_BANEXEMPTION ))
+					pByteStream->ReadString();
+
+				if ( iEntryType == MSB_ENDBANLIST )
+				{
+					g_OutBuffer.Clear();
+					g_OutBuffer.ByteStream.WriteLong( SERVER_MASTER_BANLIST_RECEIPT );
+					g_OutBuffer.ByteStream.WriteString( VerificationString.c_str() );
+					loadgen_Send( Server.Socket, g_OutBuffer );
+				}
+			}
+			break;
+		}
+	}
+}
+
+//*****************************************************************************
+//
+static bool loadgen_StartQuery( LOADGENQUERY_s &Query )
+{
+	// Use a new address for every query, the master server ignores launchers asking too often.
+	Query.Socket = loadgen_OpenSocket( LOADGEN_LAUNCHER_NET, g_ulNextLauncherAddress, 0 );
+	g_ulNextLauncherAddress = ( g_ulNextLauncherAddress + 1 ) % ( 254 * 256 );
+	if ( Query.Socket == INVALID_SOCKET )
+		return false;
+
+	Query.ulNumPacketsReceived = 0;
+	Query.iNumPackets = -1;
+	Query.ulNumServers = 0;
+
+	g_OutBuffer.Clear();
+	g_OutBuffer.ByteStream.WriteLong( LAUNCHER_MASTER_CHALLENGE );
+	g_OutBuffer.ByteStream.WriteShort( MASTER_SERVER_VERSION );
+	if ( loadgen_Send( Query.Socket, g_OutBuffer ) == false )
+	{
+		closesocket( Query.Socket );
+		Query.Socket = INVALID_SOCKET;
+		return false;
+	}
+
+	// The latency is measured from here, so only start the clock once the query is out.
+	Query.StartTime = Clock::now();
+	return true;
+}
+
+//*****************************************************************************
+//
+// Returns -1 if the master server refused to answer, 1 if the server list is complete and 0 otherwise.
+static int loadgen_QueryReceive( LOADGENQUERY_s &Query )
+{
+	while ( loadgen_Receive( Query.Socket ))
+	{
+		BYTESTREAM_s *pByteStream = &g_InBuffer.ByteStream;
+
+		if ( pByteStream->ReadLong() != MSC_BEGINSERVERLISTPART )
+			return -1;
+
+		const int iPacketNum = pByteStream->ReadByte();
+		Query.ulNumPacketsReceived++;
+
+		int iCommand;
+		while (( iCommand = pByteStream->ReadByte() ) == MSC_SERVERBLOCK )
+		{
+			int iNumPorts;
+			while (( iNumPorts = pByteStream->ReadByte() ) > 0 )
+			{
+				NETADDRESS_s Address;
+				Address.ReadFromStream( pByteStream, false );
+				for ( int i = 0; i < iNumPorts; ++i )
+					pByteStream->ReadShort();
+				Query.ulNumServers += iNumPorts;
+			}
+		}
+
+		if ( iCommand == MSC_ENDSERVERLIST )
+			Query.iNumPackets = iPacketNum + 1;
+	}
+
+	return ( static_cast<int>( Query.ulNumPacketsReceived ) == Query.iNumPackets ) ? 1 : 0;
+}
+
+//*****************************************************************************
+//
+static void loadgen_PrintUsage( void )
+{
+	printf( "Usage: master-loadgen [-master <ip:port>] [-servers <num>] [-launchers <num>] [-duration <seconds>]\n" );
+	printf( "  -master     Address of the master server (default 127.0.0.1:%d).\n", DEFAULT_MASTER_PORT );
+	printf( "  -servers    Number of simulated servers (default 1000).\n" );
+	printf( "  -launchers  Number of simulated launchers querying at the same time (default 32).\n" );
+	printf( "  -duration   How long the launchers query the master server (default 10).\n" );
+}
+
+//*****************************************************************************
+//
+int main( int argc, char **argv )
+{
+	unsigned int ulNumServers = 1000;
+	unsigned int ulNumLaunchers = 32;
+	unsigned int ulDuration = 10;
+	const char *pszMaster = "127.0.0.1";
+
+	for ( int i = 1; i + 1 < argc; i += 2 )
+	{
+		if ( stricmp( argv[i], "-master" ) == 0 )
+			pszMaster = argv[i+1];
+		else if ( stricmp( argv[i], "-servers" ) == 0 )
+			ulNumServers = atoi( argv[i+1] );
+		else if ( stricmp( argv[i], "-launchers" ) == 0 )
+			ulNumLaunchers = std::max( atoi( argv[i+1] ), 1 );
+		else if ( stricmp( argv[i], "-duration" ) == 0 )
+			ulDuration = atoi( argv[i+1] );
+		else
+		{
+			loadgen_PrintUsage( );
+			return 1;
+		}
+	}
+	if ( argc % 2 == 0 )
+	{
+		loadgen_PrintUsage( );
+		return 1;
+	}
+
+	if ( g_MasterAddress.LoadFromString( pszMaster ) == false )
+	{
+		printf( "Invalid master server address %s.\n", pszMaster );
+		return 1;
+	}
+	if ( g_MasterAddress.usPort == 0 )
+		g_MasterAddress.usPort = htons( DEFAULT_MASTER_PORT );
+
+	// Every simulated server and launcher needs its own socket.
+	struct rlimit limit;
+	if ( getrlimit( RLIMIT_NOFILE, &limit ) == 0 )
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit( RLIMIT_NOFILE, &limit );
+	}
+
+	HUFFMAN_Construct( );
+	g_OutBuffer.Init( MAX_UDP_PACKET, BUFFERTYPE_WRITE );
+	g_InBuffer.Init( MAX_UDP_PACKET * 4, BUFFERTYPE_READ );
+
+	// Register the servers.
+	std::vector<LOADGENSERVER_s> servers;
+	for ( unsigned int i = 0; i < ulNumServers; ++i )
+	{
+		LOADGENSERVER_s server;
+		server.Socket = loadgen_OpenSocket( LOADGEN_SERVER_NET, i, DEFAULT_SERVER_PORT );
+		if ( server.Socket == INVALID_SOCKET )
+		{
+			printf( "Couldn't open a socket for server %u: %s\n", i, strerror( errno ));
+			break;
+		}
+
+		char szVerificationString[32];
+		snprintf( szVerificationString, sizeof( szVerificationString ), "loadgen%u", i );
+		server.VerificationString = szVerificationString;
+
+		// Spread the registrations over two seconds, the master server would drop many of
+		// them if they all arrived at once.
+		server.LastHeartbeat = Clock::now() - std::chrono::seconds( LOADGEN_HEARTBEAT_INTERVAL ) + std::chrono::milliseconds( 2000 * i / std::max( ulNumServers, 1u ));
+		servers.push_back( server );
+	}
+
+	printf( "Registering %u servers at %s...\n", static_cast<unsigned int>( servers.size() ), g_MasterAddress.ToString() );
+
+	std::vector<LOADGENQUERY_s> queries( ulNumLaunchers );
+	std::vector<double> latencies;
+	std::vector<pollfd> pollfds;
+	unsigned int ulNumRefused = 0;
+	unsigned int ulNumTimeouts = 0;
+	unsigned int ulNumServersListed = 0;
+
+	const Clock::time_point registrationEnd = Clock::now() + std::chrono::seconds( 3 );
+	const Clock::time_point queryEnd = registrationEnd + std::chrono::seconds( ulDuration );
+	bool bQuerying = false;
+
+	while ( 1 )
+	{
+		const Clock::time_point now = Clock::now();
+
+		// Start querying once the servers had some time to register.
+		if (( bQuerying == false ) && ( now >= registrationEnd ))
+		{
+			bQuerying = true;
+			printf( "Querying with %u launchers for %u seconds...\n", ulNumLaunchers, ulDuration );
+			for ( unsigned int i = 0; i < queries.size(); ++i )
+				loadgen_StartQuery( queries[i] );
+		}
+
+		if ( now >= queryEnd )
+			break;
+
+		for ( unsigned int i = 0; i < servers.size(); ++i )
+		{
+			if ( now - servers[i].LastHeartbeat >= std::chrono::seconds( LOADGEN_HEARTBEAT_INTERVAL ))
+				loadgen_SendHeartbeat( servers[i] );
+		}
+
+		pollfds.resize( servers.size() + ( bQuerying ? queries.size() : 0 ));
+		for ( unsigned int i = 0; i < pollfds.size(); ++i )
+		{
+			pollfds[i].fd = ( i < servers.size() ) ? servers[i].Socket : queries[i - servers.size()].Socket;
+			pollfds[i].events = POLLIN;
+			pollfds[i].revents = 0;
+		}
+
+		if ( poll( pollfds.data(), pollfds.size(), 10 ) < 0 )
+			continue;
+
+		for ( unsigned int i = 0; i < servers.size(); ++i )
+		{
+			if ( pollfds[i].revents & POLLIN )
+				loadgen_ServerReceive( servers[i] );
+		}
+
+		if ( bQuerying == false )
+			continue;
+
+		for ( unsigned int i = 0; i < queries.size(); ++i )
+		{
+			LOADGENQUERY_s &query = queries[i];
+
+			// Starting this query failed, so there is nothing to measure yet. Try again.
+			if ( query.Socket == INVALID_SOCKET )
+			{
+				loadgen_StartQuery( query );
+				continue;
+			}
+
+			const int iResult = ( pollfds[servers.size() + i].revents & POLLIN ) ? loadgen_QueryReceive( query ) : 0;
+			const double dLatency = std::chrono::duration<double, std::milli>( Clock::now() - query.StartTime ).count();
+
+			if ( iResult == 1 )
+			{
+				latencies.push_back( dLatency );
+				ulNumServersListed = query.ulNumServers;
+			}
+			else if ( iResult == -1 )
+				ulNumRefused++;
+			else if ( dLatency >= LOADGEN_QUERY_TIMEOUT )
+				ulNumTimeouts++;
+			else
+				continue;
+
+			closesocket( query.Socket );
+			loadgen_StartQuery( query );
+		}
+	}
+
+	// Print the results.
+	printf( "\n%u queries answered, %.1f queries/s, %u refused, %u timed out.\n", static_cast<unsigned int>( latencies.size() ),
+		latencies.size() / static_cast<double>( std::max( ulDuration, 1u )), ulNumRefused, ulNumTimeouts );
+	printf( "The last server list contained %u of %u servers.\n", ulNumServersListed, static_cast<unsigned int>( servers.size() ));
+
+	if ( latencies.size() > 0 )
+	{
+		std::sort( latencies.begin(), latencies.end() );
+		double dSum = 0;
+		for ( unsigned int i = 0; i < latencies.size(); ++i )
+			dSum += latencies[i];
+
+		printf( "Latency (ms): average %.2f, median %.2f, 99th percentile %.2f, maximum %.2f\n", dSum / latencies.size(),
+			latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back() );
+	}
+
+	for ( unsigned int i = 0; i < servers.size(); ++i )
+		closesocket( servers[i].Socket );
+	for ( unsigned int i = 0; i < queries.size(); ++i )
+		closesocket( queries[i].Socket );
+
+	return 0;
+}
@@ -55,6 +55,7 @@
 #include "main.h"
 #include <sstream>
 #include <set>
+#include <unordered_map>
 
 // [BB] Needed for I_GetTime.
 #ifdef _MSC_VER
@@ -68,17 +69,18 @@
 //	VARIABLES
 
 // [BB] Comparision function, necessary to put SERVER_s entries into a std::set.
+// The servers are sorted by IP first, so that all servers on the same IP are next to each other.
 class SERVERCompFunc
 {
 public:
-	bool operator()(SERVER_s s1, SERVER_s s2) const
+	bool operator()( const SERVER_s &s1, const SERVER_s &s2 ) const
 	{
-		// [BB] NETWORK_AddressToString uses a static char array to generate the string, so we
-		// need to cache the string conversion of the first string when comparing to two.
-		// Note: Because we need a "<" comparison and not a "!=" comparison we can't use
-		// NETWORK_CompareAddress.
-		std::string address1 = s1.Address.ToString();
-		return ( stricmp ( address1.c_str(), s2.Address.ToString() ) < 0 );
+		const int iResult = memcmp( s1.Address.abIP, s2.Address.abIP, sizeof( s1.Address.abIP ));
+
+		if ( iResult != 0 )
+			return ( iResult < 0 );
+
+		return ( s1.Address.usPort < s2.Address.usPort );
 	}
 };
 
@@ -86,6 +88,15 @@ public:
 static	std::set<SERVER_s, SERVERCompFunc> g_Servers;
 static	std::set<SERVER_s, SERVERCompFunc> g_UnverifiedServers;
 
+// Number of servers in g_Servers for each IP.
+static	std::unordered_map<unsigned long, unsigned int> g_NumServersPerIP;
+
+// The server list packets for the launchers, already Huffman encoded. These are only rebuilt
+// when the list of servers shown to the launchers changed.
+static	std::vector<ENCODEDPACKET_t>	g_ServerListPackets;
+static	std::vector<ENCODEDPACKET_t>	g_ServerListPacketsOldFormat;
+static	bool					g_bServerListPacketsValid = false;
+
 // Message buffer we write our commands to.
 static	NETBUFFER_s				g_MessageBuffer;
 
@@ -315,6 +326,113 @@ unsigned long MASTERSERVER_NumServers ( void )
 	return g_Servers.size();
 }
 
+//*****************************************************************************
+//
+static unsigned long MASTERSERVER_GetIPKey( const NETADDRESS_s &Address )
+{
+	return ( ( Address.abIP[0] << 24 ) | ( Address.abIP[1] << 16 ) | ( Address.abIP[2] << 8 ) | Address.abIP[3] );
+}
+
+//*****************************************************************************
+//
+unsigned int MASTERSERVER_NumServersOnIP( const NETADDRESS_s &Address )
+{
+	std::unordered_map<unsigned long, unsigned int>::const_iterator it = g_NumServersPerIP.find( MASTERSERVER_GetIPKey( Address ));
+	return ( it != g_NumServersPerIP.end() ) ? it->second : 0;
+}
+
+//*****************************************************************************
+//
+void MASTERSERVER_InvalidateServerList( void )
+{
+	g_bServerListPacketsValid = false;
+}
+
+//*****************************************************************************
+//
+static bool MASTERSERVER_IsServerListed( const SERVER_s &Server )
+{
+	// [BB] Possibly omit servers that don't enforce our ban list.
+	return ( ( Server.bEnforcesBanList == true ) || ( g_bHideBanIgnoringServers == false ) );
+}
+
+//*****************************************************************************
+//
+void MASTERSERVER_BuildServerListPackets( void )
+{
+	g_ServerListPackets.clear();
+	g_ServerListPacketsOldFormat.clear();
+
+	// The list for launchers using LAUNCHER_SERVER_CHALLENGE.
+	g_MessageBuffer.Clear();
+	g_MessageBuffer.ByteStream.WriteLong( MSC_BEGINSERVERLIST );
+	for( std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin(); it != g_Servers.end(); ++it )
+	{
+		if ( MASTERSERVER_IsServerListed( *it ))
+			MASTERSERVER_SendServerIPToLauncher ( it->Address, &g_MessageBuffer.ByteStream );
+	}
+
+	// Tell the launcher that we're done sending servers.
+	g_MessageBuffer.ByteStream.WriteByte( MSC_ENDSERVERLIST );
+	g_ServerListPacketsOldFormat.push_back( ENCODEDPACKET_t() );
+	NETWORK_EncodePacket( &g_MessageBuffer, g_ServerListPacketsOldFormat.back() );
+
+	// The list for launchers using LAUNCHER_MASTER_CHALLENGE, split into several packets.
+	const unsigned long ulMaxPacketSize = 1024;
+	unsigned long ulPacketNum = 0;
+
+	std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin();
+
+	g_MessageBuffer.Clear();
+	g_MessageBuffer.ByteStream.WriteLong( MSC_BEGINSERVERLISTPART );
+	g_MessageBuffer.ByteStream.WriteByte( ulPacketNum );
+	g_MessageBuffer.ByteStream.WriteByte( MSC_SERVERBLOCK );
+	unsigned long ulSizeOfPacket = 6; // 4 (MSC_BEGINSERVERLISTPART) + 1 (0) + 1 (MSC_SERVERBLOCK)
+
+	while ( it != g_Servers.end() )
+	{
+		NETADDRESS_s serverAddress = it->Address;
+		std::vector<USHORT> serverPortList;
+
+		do {
+			if ( MASTERSERVER_IsServerListed( *it ))
+				serverPortList.push_back ( it->Address.usPort );
+			++it;
+		} while ( ( it != g_Servers.end() ) && it->Address.CompareNoPort( serverAddress ) );
+
+		// [BB] All servers on this IP ignore the list, nothing to send.
+		if ( serverPortList.size() == 0 )
+			continue;
+
+		const unsigned long ulServerBlockNetSize = MASTERSERVER_CalcServerIPBlockNetSize( serverAddress, serverPortList );
+
+		// [BB] If sending this block would cause the current packet to exceed ulMaxPacketSize ...
+		if ( ulSizeOfPacket + ulServerBlockNetSize > ulMaxPacketSize - 1 )
+		{
+			// [BB] ... close the current packet and start a new one.
+			g_MessageBuffer.ByteStream.WriteByte( 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
+			g_MessageBuffer.ByteStream.WriteByte( MSC_ENDSERVERLISTPART );
+			g_ServerListPackets.push_back( ENCODEDPACKET_t() );
+			NETWORK_EncodePacket( &g_MessageBuffer, g_ServerListPackets.back() );
+
+			g_MessageBuffer.Clear();
+			++ulPacketNum;
+			ulSizeOfPacket = 5;
+			g_MessageBuffer.ByteStream.WriteLong( MSC_BEGINSERVERLISTPART );
+			g_MessageBuffer.ByteStream.WriteByte( ulPacketNum );
+			g_MessageBuffer.ByteStream.WriteByte( MSC_SERVERBLOCK );
+		}
+		ulSizeOfPacket += ulServerBlockNetSize;
+		MASTERSERVER_SendServerIPBlockToLauncher ( serverAddress, serverPortList, &g_MessageBuffer.ByteStream );
+	}
+	g_MessageBuffer.ByteStream.WriteByte( 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
+	g_MessageBuffer.ByteStream.WriteByte( MSC_ENDSERVERLIST );
+	g_ServerListPackets.push_back( ENCODEDPACKET_t() );
+	NETWORK_EncodePacket( &g_MessageBuffer, g_ServerListPackets.back() );
+
+	g_bServerListPacketsValid = true;
+}
+
 //*****************************************************************************
 //
 bool MASTERSERVER_RefreshIPList( IPList &List, const char *FileName )
@@ -388,6 +506,8 @@ void MASTERSERVER_AddServer( const SERVER_s &Server, std::set<SERVER_s, SERVERCo
 		addedServer->lLastReceived = g_lCurrentTime;						
 		if ( &ServerSet == &g_Servers )
 		{
+			++g_NumServersPerIP[MASTERSERVER_GetIPKey( addedServer->Address )];
+			MASTERSERVER_InvalidateServerList( );
 			printf( "+ Adding %s (revision %d) to the server list.\n", addedServer->Address.ToString(), addedServer->iServerRevision );
 			MASTERSERVER_SendBanlistToServer( *addedServer );
 		}
@@ -461,14 +581,7 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 			// This is a new server; add it to the list.
 			if ( currentServer == g_Servers.end() )
 			{
-				unsigned int iNumOtherServers = 0;
-
-				// First count the number of servers from this IP.
-				for( std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin(); it != g_Servers.end(); ++it )
-				{
-					if ( it->Address.CompareNoPort( AddressFrom ))
-						iNumOtherServers++;
-				}
+				const unsigned int iNumOtherServers = MASTERSERVER_NumServersOnIP( AddressFrom );
 
 				if ( iNumOtherServers >= 10 && !g_MultiServerExceptions.isIPInList( AddressFrom ))
 					printf( "* More than 10 servers received from %s. Ignoring request...\n", AddressFrom.ToString() );
@@ -506,7 +619,11 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 				{
 					currentServer->lLastReceived = g_lCurrentTime;
 					// [BB] The server possibly changed the ban setting, so update it.
-					currentServer->bEnforcesBanList = newServer.bEnforcesBanList;
+					if ( currentServer->bEnforcesBanList != newServer.bEnforcesBanList )
+					{
+						currentServer->bEnforcesBanList = newServer.bEnforcesBanList;
+						MASTERSERVER_InvalidateServerList( );
+					}
 				}
 			}
 
@@ -591,78 +708,12 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 			// Wait 10 seconds before sending this IP the server list again.
 			g_queryIPQueue.addAddress( AddressFrom, g_lCurrentTime, &std::cerr );
 
-			switch ( lCommand )
-			{
-			case LAUNCHER_SERVER_CHALLENGE:
-				// Send the list of servers.
-				g_MessageBuffer.ByteStream.WriteLong( MSC_BEGINSERVERLIST );
-				for( std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin(); it != g_Servers.end(); ++it )
-				{
-					// [BB] Possibly omit servers that don't enforce our ban list.
-					if ( ( it->bEnforcesBanList == true ) || ( g_bHideBanIgnoringServers == false ) )
-						MASTERSERVER_SendServerIPToLauncher ( it->Address, &g_MessageBuffer.ByteStream );
-				}
+			if ( g_bServerListPacketsValid == false )
+				MASTERSERVER_BuildServerListPackets( );
 
-				// Tell the launcher that we're done sending servers.
-				g_MessageBuffer.ByteStream.WriteByte( MSC_ENDSERVERLIST );
-
-				// Send the launcher our packet.
-				NETWORK_LaunchPacket( &g_MessageBuffer, AddressFrom );
-				return;
-
-			case LAUNCHER_MASTER_CHALLENGE:
-
-				const unsigned long ulMaxPacketSize = 1024;
-				unsigned long ulPacketNum = 0;
-
-				std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin();
-
-				g_MessageBuffer.ByteStream.WriteLong( MSC_BEGINSERVERLISTPART );
-				g_MessageBuffer.ByteStream.WriteByte( ulPacketNum );
-				g_MessageBuffer.ByteStream.WriteByte( MSC_SERVERBLOCK );
-				unsigned long ulSizeOfPacket = 6; // 4 (MSC_BEGINSERVERLISTPART) + 1 (0) + 1 (MSC_SERVERBLOCK)
-
-				while ( it != g_Servers.end() )
-				{
-					NETADDRESS_s serverAddress = it->Address;
-					std::vector<USHORT> serverPortList;
-
-					do {
-						// [BB] Possibly omit servers that don't enforce our ban list.
-						if ( ( it->bEnforcesBanList == true ) || ( g_bHideBanIgnoringServers == false ) )
-							serverPortList.push_back ( it->Address.usPort );
-						++it;
-					} while ( ( it != g_Servers.end() ) && it->Address.CompareNoPort( serverAddress ) );
-
-					// [BB] All servers on this IP ignore the list, nothing to send.
-					if ( serverPortList.size() == 0 )
-						continue;
-
-					const unsigned long ulServerBlockNetSize = MASTERSERVER_CalcServerIPBlockNetSize( serverAddress, serverPortList );
-
-					// [BB] If sending this block would cause the current packet to exceed ulMaxPacketSize ...
-					if ( ulSizeOfPacket + ulServerBlockNetSize > ulMaxPacketSize - 1 )
-					{
-						// [BB] ... close the current packet and start a new one.
-						g_MessageBuffer.ByteStream.WriteByte( 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
-						g_MessageBuffer.ByteStream.WriteByte( MSC_ENDSERVERLISTPART );
-						NETWORK_LaunchPacket( &g_MessageBuffer, AddressFrom );
-
-						g_MessageBuffer.Clear();
-						++ulPacketNum;
-						ulSizeOfPacket = 5;
-						g_MessageBuffer.ByteStream.WriteLong( MSC_BEGINSERVERLISTPART );
-						g_MessageBuffer.ByteStream.WriteByte( ulPacketNum );
-						g_MessageBuffer.ByteStream.WriteByte( MSC_SERVERBLOCK );
-					}
-					ulSizeOfPacket += ulServerBlockNetSize;
-					MASTERSERVER_SendServerIPBlockToLauncher ( serverAddress, serverPortList, &g_MessageBuffer.ByteStream );
-				}
-				g_MessageBuffer.ByteStream.WriteByte( 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
-				g_MessageBuffer.ByteStream.WriteByte( MSC_ENDSERVERLIST );
-				NETWORK_LaunchPacket( &g_MessageBuffer, AddressFrom );
-				return;
-			}
+			// Send the launcher the list of servers.
+			NETWORK_LaunchEncodedPackets( ( lCommand == LAUNCHER_SERVER_CHALLENGE ) ? g_ServerListPacketsOldFormat : g_ServerListPackets, AddressFrom );
+			return;
 		}
 	}
 
@@ -682,6 +733,13 @@ void MASTERSERVER_CheckTimeouts( std::set<SERVER_s, SERVERCompFunc> &ServerSet )
 		if (( g_lCurrentTime - it->lLastReceived ) >= 60 )
 		{
 			printf( "- %server at %s timed out.\n", ( &ServerSet == &g_UnverifiedServers ) ? "Unverified s" : "S", it->Address.ToString() );
+			if ( &ServerSet == &g_Servers )
+			{
+				std::unordered_map<unsigned long, unsigned int>::iterator count = g_NumServersPerIP.find( MASTERSERVER_GetIPKey( it->Address ));
+				if ( ( count != g_NumServersPerIP.end() ) && ( --count->second == 0 ))
+					g_NumServersPerIP.erase( count );
+				MASTERSERVER_InvalidateServerList( );
+			}
 			// [BB] The standard does not require set::erase to return the incremented operator,
 			// that's why we must use the post increment operator here.
 			ServerSet.erase ( it++ );
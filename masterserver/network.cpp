@@ -85,6 +85,7 @@ static	UCHAR			g_ucHuffmanBuffer[131072];
 static	void			network_Error( const char *pszError );
 static	SOCKET			network_AllocateSocket( void );
 static	bool			network_BindSocketToPort( SOCKET Socket, ULONG ulInAddr, USHORT usPort, bool bReUse );
+static	void			network_HandleSendError( const NETADDRESS_s &Address );
 
 //*****************************************************************************
 //	FUNCTIONS
@@ -294,45 +295,66 @@ void NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address )
 
 	// If sendto returns -1, there was an error.
 	if ( lNumBytes == -1 )
-	{
-#ifdef __WIN32__
-		INT	iError = WSAGetLastError( );
+		network_HandleSendError( Address );
+}
 
-		// Wouldblock is silent.
-		if ( iError == WSAEWOULDBLOCK )
-			return;
+//*****************************************************************************
+//
+void NETWORK_EncodePacket( NETBUFFER_s *pBuffer, ENCODEDPACKET_t &Packet )
+{
+	INT		iNumBytesOut = sizeof(g_ucHuffmanBuffer);
 
-		switch ( iError )
-		{
-		case WSAEACCES:
+	pBuffer->ulCurrentSize = pBuffer->CalcSize();
+	HUFFMAN_Encode( (unsigned char *)pBuffer->pbData, g_ucHuffmanBuffer, pBuffer->ulCurrentSize, &iNumBytesOut );
+	Packet.assign( g_ucHuffmanBuffer, g_ucHuffmanBuffer + iNumBytesOut );
+}
 
-			printf( "NETWORK_LaunchPacket: Error #%d, WSAEACCES: Permission denied for address: %s\n", iError, Address.ToString() );
-			return;
-		case WSAEADDRNOTAVAIL:
+//*****************************************************************************
+//
+void NETWORK_LaunchEncodedPackets( const std::vector<ENCODEDPACKET_t> &Packets, const NETADDRESS_s &Address )
+{
+	// Convert the IP address to a socket address.
+	struct sockaddr_in SocketAddress;
+	Address.ToSocketAddress( reinterpret_cast<sockaddr&>(SocketAddress) );
 
-			printf( "NETWORK_LaunchPacket: Error #%d, WSAEADDRENOTAVAIL: Address %s not available\n", iError, Address.ToString() );
-			return;
-		case WSAEHOSTUNREACH:
+#ifdef HAVE_SENDMMSG
+	// Hand all packets to the kernel with as few system calls as possible.
+	std::vector<struct mmsghdr> messages( Packets.size() );
+	std::vector<struct iovec> vectors( Packets.size() );
 
-			printf( "NETWORK_LaunchPacket: Error #%d, WSAEHOSTUNREACH: Address %s unreachable\n", iError, Address.ToString() );
-			return;				
-		default:
+	for ( unsigned int i = 0; i < Packets.size(); ++i )
+	{
+		vectors[i].iov_base = const_cast<BYTE *>( Packets[i].data() );
+		vectors[i].iov_len = Packets[i].size();
+		memset( &messages[i], 0, sizeof( messages[i] ));
+		messages[i].msg_hdr.msg_name = &SocketAddress;
+		messages[i].msg_hdr.msg_namelen = sizeof( SocketAddress );
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
 
-			printf( "NETWORK_LaunchPacket: Error #%d\n", iError );
+	unsigned int ulNumSent = 0;
+	while ( ulNumSent < messages.size() )
+	{
+		const int iResult = sendmmsg( g_NetworkSocket, &messages[ulNumSent], messages.size() - ulNumSent, 0 );
+		if ( iResult <= 0 )
+		{
+			network_HandleSendError( Address );
 			return;
 		}
-#else
-	if ( errno == EWOULDBLOCK )
-return;
-
-          if ( errno == ECONNREFUSED )
-              return;
 
-		printf( "NETWORK_LaunchPacket: %s\n", strerror( errno ));
-		printf( "NETWORK_LaunchPacket: Address %s\n", Address.ToString() );
-
-#endif
+		ulNumSent += iResult;
 	}
+#else
+	for ( unsigned int i = 0; i < Packets.size(); ++i )
+	{
+		if ( sendto( g_NetworkSocket, (const char*)Packets[i].data(), Packets[i].size(), 0, reinterpret_cast<sockaddr*>(&SocketAddress), sizeof( SocketAddress )) == -1 )
+		{
+			network_HandleSendError( Address );
+			return;
+		}
+	}
+#endif
 }
 
 //*****************************************************************************
@@ -436,6 +458,48 @@ bool network_BindSocketToPort( SOCKET Socket, ULONG ulInAddr, USHORT usPort, boo
 }
 
 
+//*****************************************************************************
+//
+static void network_HandleSendError( const NETADDRESS_s &Address )
+{
+#ifdef __WIN32__
+	INT	iError = WSAGetLastError( );
+
+	// Wouldblock is silent.
+	if ( iError == WSAEWOULDBLOCK )
+		return;
+
+	switch ( iError )
+	{
+	case WSAEACCES:
+
+		printf( "NETWORK_LaunchPacket: Error #%d, WSAEACCES: Permission denied for address: %s\n", iError, Address.ToString() );
+		return;
+	case WSAEADDRNOTAVAIL:
+
+		printf( "NETWORK_LaunchPacket: Error #%d, WSAEADDRENOTAVAIL: Address %s not available\n", iError, Address.ToString() );
+		return;
+	case WSAEHOSTUNREACH:
+
+		printf( "NETWORK_LaunchPacket: Error #%d, WSAEHOSTUNREACH: Address %s unreachable\n", iError, Address.ToString() );
+		return;
+	default:
+
+		printf( "NETWORK_LaunchPacket: Error #%d\n", iError );
+		return;
+	}
+#else
+	if ( errno == EWOULDBLOCK )
+		return;
+
+	if ( errno == ECONNREFUSED )
+		return;
+
+	printf( "NETWORK_LaunchPacket: %s\n", strerror( errno ));
+	printf( "NETWORK_LaunchPacket: Address %s\n", Address.ToString() );
+#endif
+}
+
 #ifndef	WIN32
 extern int	stdin_ready;
 extern int	do_stdin;
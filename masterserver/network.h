@@ -52,6 +52,7 @@
 #define __NETWORK_H__
 
 #include <stdio.h>
+#include <vector>
 //#include "c_cvars.h"
 //#include "d_player.h"
 //#include "i_net.h"
@@ -64,6 +65,12 @@
 // Network messages (universal)
 #define	NETWORK_ERROR			254
 
+//*****************************************************************************
+//	STRUCTURES
+
+// A Huffman encoded packet, ready to be sent.
+typedef std::vector<BYTE> ENCODEDPACKET_t;
+
 //*****************************************************************************
 //	PROTOTYPES
 
@@ -73,6 +80,8 @@ int				NETWORK_GetPackets( void );
 int				NETWORK_GetLANPackets( void );
 NETADDRESS_s	NETWORK_GetFromAddress( void );
 void			NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address );
+void			NETWORK_EncodePacket( NETBUFFER_s *pBuffer, ENCODEDPACKET_t &Packet );
+void			NETWORK_LaunchEncodedPackets( const std::vector<ENCODEDPACKET_t> &Packets, const NETADDRESS_s &Address );
 //AActor			*NETWORK_FindThingByNetID( LONG lID );
 NETADDRESS_s	NETWORK_GetLocalAddress( void );
 NETBUFFER_s		*NETWORK_GetNetworkMessageBuffer( void );
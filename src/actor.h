@@ -946,6 +946,9 @@ public:
 
 // info for drawing
 // NOTE: The first member variable *must* be x.
+// The copy constructor and operator= in p_mobj.cpp and the prediction
+// backup and restore in p_user.cpp (P_PredictPlayer, P_UnPredictPlayer)
+// copy everything from x to the end of the object with memcpy.
 	fixed_t	 		x,y,z;
 	AActor			*snext, **sprev;	// links in sector (if needed)
 	angle_t			angle;
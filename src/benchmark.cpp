@@ -0,0 +1,263 @@
+/*
+** benchmark.cpp
+** Timed demo playback with per-frame phase timings
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "benchmark.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "m_argv.h"
+#include "c_console.h"
+#include "tarray.h"
+#include "zstring.h"
+
+extern cycle_t ThinkCycles;
+extern cycle_t SightCycles;
+
+cycle_t BenchNetCycles;
+cycle_t BenchSoundCycles;
+
+enum
+{
+	PHASE_FRAME,
+	PHASE_TIC,
+	PHASE_THINK,
+	PHASE_SIGHT,
+	PHASE_NETPARSE,
+	PHASE_SOUND,
+	PHASE_RENDER,
+
+	NUM_PHASES
+};
+
+static const char *PhaseNames[NUM_PHASES] =
+{
+	"frame", "tic", "think", "sight", "netparse", "sound", "render"
+};
+
+struct FBenchFrame
+{
+	float	Phase[NUM_PHASES];	// milliseconds
+};
+
+static bool					g_bBenchmarking = false;
+static FString				g_DemoName;
+static TArray<FBenchFrame>	g_Frames;
+static FBenchFrame			g_CurrentFrame;
+static cycle_t				g_FrameCycles;
+static cycle_t				g_PhaseCycles;
+static cycle_t				g_TotalCycles;
+static double				g_dSightStart;
+
+//*****************************************************************************
+//
+void BENCHMARK_Start( const char *pszDemoName )
+{
+	g_bBenchmarking = true;
+	g_DemoName = pszDemoName;
+	g_Frames.Clear( );
+	g_TotalCycles.Reset( );
+	g_TotalCycles.Clock( );
+}
+
+//*****************************************************************************
+//
+bool BENCHMARK_IsActive( void )
+{
+	return ( g_bBenchmarking );
+}
+
+//*****************************************************************************
+//
+void BENCHMARK_BeginFrame( void )
+{
+	if ( g_bBenchmarking == false )
+		return;
+
+	BenchNetCycles.Reset( );
+	BenchSoundCycles.Reset( );
+	g_dSightStart = SightCycles.TimeMS( );
+
+	g_FrameCycles.Reset( );
+	g_FrameCycles.Clock( );
+	g_PhaseCycles.Reset( );
+	g_PhaseCycles.Clock( );
+}
+
+//*****************************************************************************
+//
+void BENCHMARK_EndTic( void )
+{
+	if ( g_bBenchmarking == false )
+		return;
+
+	g_PhaseCycles.Unclock( );
+	g_CurrentFrame.Phase[PHASE_TIC] = (float)g_PhaseCycles.TimeMS( );
+	// RunThinkers resets ThinkCycles every tic, but the sight stat only
+	// resets its counter when it is displayed.
+	g_CurrentFrame.Phase[PHASE_THINK] = (float)ThinkCycles.TimeMS( );
+	g_CurrentFrame.Phase[PHASE_SIGHT] = (float)( SightCycles.TimeMS( ) - g_dSightStart );
+	g_CurrentFrame.Phase[PHASE_NETPARSE] = (float)BenchNetCycles.TimeMS( );
+	g_CurrentFrame.Phase[PHASE_SOUND] = (float)BenchSoundCycles.TimeMS( );
+
+	g_PhaseCycles.Reset( );
+	g_PhaseCycles.Clock( );
+}
+
+//*****************************************************************************
+//
+void BENCHMARK_EndFrame( void )
+{
+	if ( g_bBenchmarking == false )
+		return;
+
+	g_PhaseCycles.Unclock( );
+	g_FrameCycles.Unclock( );
+	g_CurrentFrame.Phase[PHASE_RENDER] = (float)g_PhaseCycles.TimeMS( );
+	g_CurrentFrame.Phase[PHASE_FRAME] = (float)g_FrameCycles.TimeMS( );
+	g_Frames.Push( g_CurrentFrame );
+}
+
+//*****************************************************************************
+//
+float BENCHMARK_Percentile( const TArray<float> &Sorted, double dPercent )
+{
+	if ( Sorted.Size( ) == 0 )
+		return ( 0 );
+
+	unsigned int ulIdx = (unsigned int)( dPercent / 100.0 * Sorted.Size( ) + 0.5 );
+
+	if ( ulIdx > 0 )
+		ulIdx--;
+	if ( ulIdx >= Sorted.Size( ))
+		ulIdx = Sorted.Size( ) - 1;
+	return ( Sorted[ulIdx] );
+}
+
+//*****************************************************************************
+//
+static FString benchmark_EscapeJSON( const char *pszString )
+{
+	FString	Out;
+
+	for ( ; *pszString; pszString++ )
+	{
+		if ( *pszString == '"' || *pszString == '\\' )
+			Out += '\\';
+		if ((unsigned char)*pszString >= ' ' )
+			Out += *pszString;
+	}
+	return ( Out );
+}
+
+//*****************************************************************************
+//
+void BENCHMARK_Finish( void )
+{
+	if ( g_bBenchmarking == false )
+		return;
+
+	g_bBenchmarking = false;
+	g_TotalCycles.Unclock( );
+
+	const char *pszOutName = Args->CheckValue( "-benchmarkout" );
+	if ( pszOutName == NULL )
+		pszOutName = "benchmark.json";
+
+	FILE *pFile = fopen( pszOutName, "w" );
+	if ( pFile == NULL )
+	{
+		Printf( "Could not write benchmark results to %s.\n", pszOutName );
+		exit( 1 );
+	}
+
+	const unsigned int ulNumFrames = g_Frames.Size( );
+	const double dTotalMS = g_TotalCycles.TimeMS( );
+
+	fprintf( pFile, "{\n" );
+	fprintf( pFile, "\t\"demo\": \"%s\",\n", benchmark_EscapeJSON( g_DemoName ).GetChars( ));
+	fprintf( pFile, "\t\"frames\": %u,\n", ulNumFrames );
+	fprintf( pFile, "\t\"total_ms\": %.3f,\n", dTotalMS );
+	fprintf( pFile, "\t\"fps\": %.2f,\n", dTotalMS > 0 ? ulNumFrames * 1000.0 / dTotalMS : 0.0 );
+	fprintf( pFile, "\t\"phases\": {\n" );
+
+	TArray<float>	Sorted;
+	Sorted.Resize( ulNumFrames );
+	for ( unsigned int ulPhase = 0; ulPhase < NUM_PHASES; ulPhase++ )
+	{
+		double	dSum = 0;
+
+		for ( unsigned int ulIdx = 0; ulIdx < ulNumFrames; ulIdx++ )
+		{
+			Sorted[ulIdx] = g_Frames[ulIdx].Phase[ulPhase];
+			dSum += Sorted[ulIdx];
+		}
+		if ( ulNumFrames > 0 )
+			std::sort( &Sorted[0], &Sorted[0] + ulNumFrames );
+
+		fprintf( pFile, "\t\t\"%s\": { ", PhaseNames[ulPhase] );
+		if ( ulNumFrames > 0 )
+		{
+			fprintf( pFile, "\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f",
+				dSum / ulNumFrames, BENCHMARK_Percentile( Sorted, 50 ), BENCHMARK_Percentile( Sorted, 90 ),
+				BENCHMARK_Percentile( Sorted, 99 ), Sorted[ulNumFrames - 1] );
+		}
+		fprintf( pFile, " }%s\n", ( ulPhase + 1 < NUM_PHASES ) ? "," : "" );
+	}
+	fprintf( pFile, "\t},\n" );
+
+	// One row per frame, in the same order as the phases above.
+	fprintf( pFile, "\t\"columns\": [" );
+	for ( unsigned int ulPhase = 0; ulPhase < NUM_PHASES; ulPhase++ )
+		fprintf( pFile, "%s\"%s\"", ulPhase ? ", " : "", PhaseNames[ulPhase] );
+	fprintf( pFile, "],\n" );
+	fprintf( pFile, "\t\"timings\": [\n" );
+	for ( unsigned int ulIdx = 0; ulIdx < ulNumFrames; ulIdx++ )
+	{
+		fprintf( pFile, "\t\t[" );
+		for ( unsigned int ulPhase = 0; ulPhase < NUM_PHASES; ulPhase++ )
+			fprintf( pFile, "%s%.4f", ulPhase ? ", " : "", g_Frames[ulIdx].Phase[ulPhase] );
+		fprintf( pFile, "]%s\n", ( ulIdx + 1 < ulNumFrames ) ? "," : "" );
+	}
+	fprintf( pFile, "\t]\n" );
+	fprintf( pFile, "}\n" );
+	fclose( pFile );
+
+	Printf( "Benchmark: %u frames in %.1f ms (%.1f fps), results written to %s.\n",
+		ulNumFrames, dTotalMS, dTotalMS > 0 ? ulNumFrames * 1000.0 / dTotalMS : 0.0, pszOutName );
+	exit( 0 );
+}
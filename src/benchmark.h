@@ -0,0 +1,65 @@
+/*
+** benchmark.h
+** Timed demo playback with per-frame phase timings
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "stats.h"
+#include "tarray.h"
+
+// Time spent parsing client demo packets and updating sounds during the
+// current frame. Only clocked while a benchmark is running.
+extern cycle_t BenchNetCycles;
+extern cycle_t BenchSoundCycles;
+
+// -benchmark <demo> plays the demo as a timedemo and, when it ends, writes
+// the timings to the file given with -benchmarkout (benchmark.json by
+// default) and quits.
+void	BENCHMARK_Start( const char *pszDemoName );
+bool	BENCHMARK_IsActive( void );
+
+// Called from the single tic loop around the tic and the display.
+void	BENCHMARK_BeginFrame( void );
+void	BENCHMARK_EndTic( void );
+void	BENCHMARK_EndFrame( void );
+
+// Called when demo playback stops. Does nothing if no benchmark is running.
+void	BENCHMARK_Finish( void );
+
+// Nearest-rank percentile of an already sorted array, 0 if it's empty.
+// Also used by the server profiler.
+float	BENCHMARK_Percentile( const TArray<float> &Sorted, double dPercent );
+
+#endif
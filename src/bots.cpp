@@ -620,6 +620,7 @@ void BOTS_RemoveBot( ULONG ulPlayerIdx, bool bExitMsg )
 	{
 		// Redo the scoreboard.
 		SERVERCONSOLE_ReListPlayers( );
+		SERVER_MASTER_InvalidateServerInfo( );
 	
 		// [RC] Update clients using the RCON utility.
 		SERVER_RCON_UpdateInfo( SVRCU_PLAYERDATA );
@@ -1881,6 +1882,7 @@ CSkullBot::CSkullBot( char *pszName, char *pszTeamName, ULONG ulPlayerNum )
 
 		// Redo the scoreboard.
 		SERVERCONSOLE_ReListPlayers( );
+		SERVER_MASTER_InvalidateServerInfo( );
 
 		// [RC] Update clients using the RCON utility.
 		SERVER_RCON_UpdateInfo( SVRCU_PLAYERDATA );
@@ -169,6 +169,10 @@ void FBaseCVar::ForceSet (UCVarValue value, ECVarType type, bool nouserinfosend)
 
 	Flags &= ~CVAR_ISDEFAULT;
 
+	// Launchers may be shown the new value.
+	if ( NETWORK_GetState( ) == NETSTATE_SERVER )
+		SERVER_MASTER_InvalidateServerInfo( );
+
 	// [TP]
 	if ( DMenu::CurrentMenu != NULL )
 		DMenu::CurrentMenu->CVarChanged ( this );
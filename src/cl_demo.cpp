@@ -51,6 +51,7 @@
 #include "c_console.h"
 #include "c_dispatch.h"
 #include "cl_demo.h"
+#include "benchmark.h"
 #include "cl_main.h"
 #include "cmdlib.h"
 #include "d_event.h"
@@ -696,6 +697,9 @@ void CLIENTDEMO_FinishPlaying( void )
 	viewactive = false;
 
 	Printf( "Demo ended.\n" );
+
+	// Writes the results and quits if this was a -benchmark run.
+	BENCHMARK_Finish( );
 }
 
 //*****************************************************************************
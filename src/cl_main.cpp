@@ -156,6 +156,8 @@ EXTERN_CVAR( String, name )
 #ifdef	_DEBUG
 CVAR( Bool, cl_emulatepacketloss, false, 0 )
 #endif
+// Tell the server which packets we received, so that it can resend lost ones on its own.
+CVAR( Bool, cl_selectiveack, true, CVAR_ARCHIVE )
 // [BB]
 CVAR( Bool, cl_connectsound, true, CVAR_ARCHIVE )
 CVAR( Bool, cl_showwarnings, false, CVAR_ARCHIVE )
@@ -362,6 +364,9 @@ static	LONG				g_lHighestReceivedSequence;
 // Delay for sending a request missing packets.
 static	LONG				g_lMissingPacketTicks;
 
+// Did we receive a packet we didn't acknowledge yet?
+static	bool				g_bPacketsToAcknowledge;
+
 // Debugging variables.
 static	LONG				g_lLastCmd;
 
@@ -836,6 +841,7 @@ void CLIENT_AttemptConnection( void )
 	g_lHighestReceivedSequence = -1;
 
 	g_lMissingPacketTicks = 0;
+	g_bPacketsToAcknowledge = false;
 
 	// [CK] Reset this here since we plan on connecting to a new server
 	CLIENT_SetLatestServerGametic( 0 );
@@ -1105,6 +1111,29 @@ void CLIENT_CheckForMissingPackets( void )
 	LONG	lIdx;
 	LONG	lIdx2;
 
+	// Acknowledge the packets we received: The last one we received without any gaps before
+	// it and which of the 32 packets following the first missing one we have.
+	if ( cl_selectiveack && g_bPacketsToAcknowledge )
+	{
+		ULONG	ulReceivedMask = 0;
+
+		if ( g_lHighestReceivedSequence > g_lLastParsedSequence + 1 )
+		{
+			for ( lIdx = 0; lIdx < PACKET_BUFFER_SIZE; lIdx++ )
+			{
+				const LONG lOffset = g_lPacketSequence[lIdx] - ( g_lLastParsedSequence + 2 );
+
+				if (( lOffset >= 0 ) && ( lOffset < 32 ))
+					ulReceivedMask |= ( 1u << lOffset );
+			}
+		}
+
+		g_LocalBuffer.ByteStream.WriteByte( CLC_ACKNOWLEDGEPACKETS );
+		g_LocalBuffer.ByteStream.WriteLong( g_lLastParsedSequence );
+		g_LocalBuffer.ByteStream.WriteLong( ulReceivedMask );
+		g_bPacketsToAcknowledge = false;
+	}
+
 	// We already told the server we're missing packets a little bit ago. No need
 	// to do it again.
 	if ( g_lMissingPacketTicks > 0 )
@@ -1181,6 +1210,9 @@ bool CLIENT_ReadPacketHeader( BYTESTREAM_s *pByteStream )
 	{
 		// Read in the sequence. This is the # of the packet the server has sent us.
 		lSequence = pByteStream->ReadLong();
+
+		// Also acknowledge packets we already have, the server may have missed our acknowledgement.
+		g_bPacketsToAcknowledge = true;
 	}
 	if ( lCommand != SVC_HEADER )
 		Printf( "CLIENT_ReadPacketHeader: WARNING! Expected SVC_HEADER or SVC_UNRELIABLEPACKET!\n" );
@@ -2343,6 +2375,7 @@ void CLIENT_QuitNetworkGame( const char *pszString )
 	g_lHighestReceivedSequence = -1;
 
 	g_lMissingPacketTicks = 0;
+	g_bPacketsToAcknowledge = false;
 
 	// Set the network state back to single player.
 	NETWORK_SetState( NETSTATE_SINGLE );
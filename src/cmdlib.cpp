@@ -3,9 +3,11 @@
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
+#include <sys/utime.h>
 #else
 #include <unistd.h>
 #include <sys/types.h>
+#include <utime.h>
 #include <pwd.h>
 #if !defined(__sun)
 #include <fts.h>
@@ -1071,3 +1073,90 @@ void ScanDirectory(TArray<FFileList> &list, const char *dirpath)
 	delete[] argv[0];
 }
 #endif
+
+
+//==========================================================================
+//
+// TouchFile
+//
+// Sets a file's modification time to now. Caches use this to mark files
+// as recently used for TrimDirectory.
+//
+//==========================================================================
+
+void TouchFile(const char *path)
+{
+#ifdef _WIN32
+	_utime(path, NULL);
+#else
+	utime(path, NULL);
+#endif
+}
+
+//==========================================================================
+//
+// TrimDirectory
+//
+// Deletes the least recently modified files in a directory tree until the
+// rest takes up no more than maxbytes, and returns the size of the rest.
+// Temporary files that may still be written are left alone, as are files
+// that can't be deleted because another process has them open.
+//
+//==========================================================================
+
+struct FTrimFile
+{
+	FString Filename;
+	size_t Size;
+	time_t Time;
+};
+
+static int STACK_ARGS TrimFileCmp(const void *a, const void *b)
+{
+	const FTrimFile *file1 = (const FTrimFile *)a;
+	const FTrimFile *file2 = (const FTrimFile *)b;
+
+	return file1->Time < file2->Time ? -1 : file1->Time > file2->Time ? 1 : 0;
+}
+
+size_t TrimDirectory(const char *dirpath, size_t maxbytes)
+{
+	TArray<FFileList> list;
+	TArray<FTrimFile> files;
+	size_t total = 0;
+
+	ScanDirectory(list, dirpath);
+	for (unsigned int i = 0; i < list.Size(); ++i)
+	{
+		struct stat info;
+		FTrimFile file;
+
+		if (list[i].isDirectory || stat(list[i].Filename, &info) != 0)
+		{
+			continue;
+		}
+		total += (size_t)info.st_size;
+
+		if (list[i].Filename.Len() >= 4 && stricmp(list[i].Filename.GetChars() + list[i].Filename.Len() - 4, ".tmp") == 0)
+		{
+			continue;
+		}
+		file.Filename = list[i].Filename;
+		file.Size = (size_t)info.st_size;
+		file.Time = info.st_mtime;
+		files.Push(file);
+	}
+
+	if (total > maxbytes && files.Size() > 0)
+	{
+		qsort(&files[0], files.Size(), sizeof(FTrimFile), TrimFileCmp);
+		for (unsigned int i = 0; i < files.Size() && total > maxbytes; ++i)
+		{
+			if (remove(files[i].Filename) == 0)
+			{
+				total -= files[i].Size;
+			}
+		}
+	}
+	return total;
+}
@@ -63,5 +63,7 @@ struct FFileList
 };
 
 void ScanDirectory(TArray<FFileList> &list, const char *dirpath);
+void TouchFile(const char *path);
+size_t TrimDirectory(const char *dirpath, size_t maxbytes);
 
 #endif
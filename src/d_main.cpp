@@ -119,6 +119,7 @@
 #include "survival.h"
 #include "possession.h"
 #include "cl_demo.h"
+#include "benchmark.h"
 #include "gamemode.h"
 #include "sectinfo.h"
 #include "md5.h"
@@ -142,6 +143,7 @@
 #include "resourcefiles/resourcefile.h"
 #include "r_renderer.h"
 #include "p_local.h"
+#include "startupprofile.h"
 
 #ifdef USE_POLYMOST
 #include "r_polymost.h"
@@ -204,6 +206,7 @@ extern int NewWidth, NewHeight, NewBits, DisplayBits;
 EXTERN_CVAR (Bool, st_scale)
 extern bool gameisdead;
 extern bool demorecording;
+extern bool timingdemo;
 extern bool M_DemoNoPlay;	// [RH] if true, then skip any demos in the loop
 extern bool insave;
 
@@ -890,7 +893,8 @@ void D_Display ()
 	// [RH] Allow temporarily disabling wipes
 	// [BB] Wipes cause more harm than good on the client. Disable them for now.
 	// [Leo] Disable them while playing demos too.
-	if ( NoWipe || NETWORK_InClientMode() ) 
+	// Timed demos skip them as well since they wait for the display.
+	if ( NoWipe || NETWORK_InClientMode() || timingdemo ) 
 	{
 		V_SetBorderNeedRefresh();
 		NoWipe--;
@@ -1352,6 +1356,7 @@ void D_DoomLoop ()
 				// process one or more tics
 				if (singletics)
 				{
+					BENCHMARK_BeginFrame ();
 					I_StartTic ();
 					D_ProcessEvents ();
 					G_BuildTiccmd (&netcmds[consoleplayer][maketic%BACKUPTICS]);
@@ -1367,6 +1372,11 @@ void D_DoomLoop ()
 					maketic++;
 					GC::CheckGC ();
 					Net_NewMakeTic ();
+					// Move positional sounds, as TryRunTics does.
+					BenchSoundCycles.Clock ();
+					S_UpdateSounds (players[consoleplayer].camera);
+					BenchSoundCycles.Unclock ();
+					BENCHMARK_EndTic ();
 				}
 				else
 				{
@@ -1375,6 +1385,10 @@ void D_DoomLoop ()
 				// Update display, next frame, with current state.
 				I_StartTic ();
 				D_Display ();
+				if (singletics)
+				{
+					BENCHMARK_EndFrame ();
+				}
 				break;
 			}
 		}
@@ -2423,6 +2437,12 @@ static void D_DoomInit()
 	Args->CollectFiles("-exec", ".cfg");
 	Args->CollectFiles("-playdemo", ".lmp");
 	Args->CollectFiles("-file", NULL);	// anything left goes after -file
+
+	// Benchmarks measure the game and the renderer, so leave sound out.
+	if (Args->CheckParm("-benchmark") && !Args->CheckParm("-nosound"))
+	{
+		Args->AppendArg("-nosound");
+	}
 	Args->CollectFiles( "-optfile", NULL ); // [TP]
 
 	atterm (C_DeinitConsole);
@@ -2736,6 +2756,47 @@ static void FinalGC()
 	GC::DelSoftRootHead();	// the soft root head will not be collected by a GC so we have to do it explicitly
 }
 
+//==========================================================================
+//
+// D_PrefetchScripts
+//
+// The text lumps can't be parsed in parallel, since the parsers all fill
+// global tables, but they can at least be decompressed ahead of time.
+//
+//==========================================================================
+
+static void D_PrefetchScripts ()
+{
+	static const char *const scriptlumps[] =
+	{
+		"ANIMDEFS", "CVARINFO", "DECALDEF", "DECORATE", "DEHACKED", "FONTDEFS", "GAMEMODE",
+		"GLDEFS", "KEYCONF", "LANGUAGE", "LOCKDEFS", "MAPINFO", "MENUDEF", "MODELDEF",
+		"MUSINFO", "REVERBS", "SBARINFO", "SECTINFO", "SNDINFO", "SNDSEQ", "S_SKIN",
+		"TEAMINFO", "TERRAIN", "TEXTCOLO", "TEXTURES", "VOXELDEF", "ZMAPINFO", NULL
+	};
+	TArray<int> lumps;
+	int lump, lastlump;
+
+	for (int i = 0; scriptlumps[i] != NULL; ++i)
+	{
+		lastlump = 0;
+		while ((lump = Wads.FindLump (scriptlumps[i], &lastlump)) != -1)
+		{
+			lumps.Push (lump);
+		}
+	}
+
+	// The DECORATE files included by our own DECORATE lump.
+	for (lump = 0; lump < Wads.GetNumLumps(); ++lump)
+	{
+		if (strnicmp (Wads.GetLumpFullName (lump), "actors/", 7) == 0)
+		{
+			lumps.Push (lump);
+		}
+	}
+	Wads.PrefetchLumps (lumps);
+}
+
 //==========================================================================
 //
 // D_DoomMain
@@ -2840,13 +2901,25 @@ void D_DoomMain (void)
 		pwads.Clear();
 		pwads.ShrinkToFit();
 
+		StartupProfile.Start ();
+		StartupProfile.Phase ("W_Init");
 		Printf ("W_Init: Init WADfiles.\n");
 		Wads.InitMultipleFiles (/*allwads*/); // [BB] Removed argument.
 		allwads.Clear();
 		allwads.ShrinkToFit();
 		SetMapxxFlag();
 
+		// Start inflating the scripts and graphics from compressed archives now,
+		// so the parsers and the texture manager find most of them ready.
+		D_PrefetchScripts ();
+		Wads.PrefetchNamespace (ns_sprites);
+		Wads.PrefetchNamespace (ns_graphics);
+		Wads.PrefetchNamespace (ns_patches);
+		Wads.PrefetchNamespace (ns_flats);
+		Wads.PrefetchNamespace (ns_newtextures);
+
 		// Now that wads are loaded, define mod-specific cvars.
+		StartupProfile.Phase ("ParseCVarInfo");
 		ParseCVarInfo();
 
 		// Actually exec command line commands and exec files.
@@ -2858,6 +2931,7 @@ void D_DoomMain (void)
 		}
 
 		// Initialize the chat module.
+		StartupProfile.Phase ("Game modules");
 		CHAT_Construct( );
 
 		// Initialize the team info.
@@ -2896,6 +2970,7 @@ void D_DoomMain (void)
 		GAMEMODE_ParseGamemodeInfo( );
 
 		// [RH] Initialize localizable strings.
+		StartupProfile.Phase ("GStrings.LoadStrings");
 		GStrings.LoadStrings (false);
 
 		V_InitFontColors ();
@@ -2906,6 +2981,7 @@ void D_DoomMain (void)
 		// [BB] Zandronum handles chat differently.
 		//CT_Init ();
 
+		StartupProfile.Phase ("I_Init/V_Init");
 		if (!restart)
 		{
 			Printf ("I_Init: Setting up machine state.\n");
@@ -2933,9 +3009,11 @@ void D_DoomMain (void)
 		// [RC] Start the G15 LCD module here.
 		G15_Construct ();
 
+		StartupProfile.Phase ("S_Init");
 		Printf ("S_Init: Setting up sound.\n");
 		S_Init ();
 
+		StartupProfile.Phase ("ST_Init");
 		Printf ("ST_Init: Init startup screen.\n");
 		if (!restart)
 		{
@@ -2951,6 +3029,7 @@ void D_DoomMain (void)
 		CheckCmdLine();
 
 		// [RH] Load sound environments
+		StartupProfile.Phase ("S_InitData");
 		S_ParseReverbDef ();
 
 		// [RH] Parse any SNDINFO lumps
@@ -2958,6 +3037,7 @@ void D_DoomMain (void)
 		S_InitData ();
 
 		// [RH] Parse through all loaded mapinfo lumps
+		StartupProfile.Phase ("G_ParseMapInfo");
 		Printf ("G_ParseMapInfo: Load map definitions.\n");
 		G_ParseMapInfo (iwad_info->MapInfo);
 		ReadStatistics();
@@ -2968,16 +3048,19 @@ void D_DoomMain (void)
 		// [BL] Load SectInfo
 		SECTINFO_Load();
 
+		StartupProfile.Phase ("TexMan.Init");
 		Printf ("Texman.Init: Init texture manager.\n");
 		TexMan.Init();
 		C_InitConback();
 
 		// [CW] Parse any TEAMINFO lumps.
+		StartupProfile.Phase ("ParseTeamInfo");
 		Printf ("ParseTeamInfo: Load team definitions.\n");
 		//TeamLibrary.ParseTeamInfo ();
 		// [BB] At the moment Skulltag still doesn't use the new ZDoom TeamLibrary class.
 		TEAMINFO_Init ();
 
+		StartupProfile.Phase ("FActorInfo::StaticInit");
 		FActorInfo::StaticInit ();
 
 		// [GRB] Initialize player class list
@@ -2995,14 +3078,17 @@ void D_DoomMain (void)
 
 		StartScreen->Progress ();
 
+		StartupProfile.Phase ("R_Init");
 		Printf ("R_Init: Init %s refresh subsystem.\n", gameinfo.ConfigName.GetChars());
 		StartScreen->LoadingStatus ("Loading graphics", 0x3f);
 		R_Init ();
 
+		StartupProfile.Phase ("DecalLibrary");
 		Printf ("DecalLibrary: Load decals.\n");
 		DecalLibrary.ReadAllDecals ();
 
 		// [RH] Add any .deh and .bex files on the command line.
+		StartupProfile.Phase ("Dehacked");
 		// If there are none, try adding any in the config file.
 		// Note that the command line overrides defaults from the config.
 
@@ -3048,13 +3134,16 @@ void D_DoomMain (void)
 		// [BC] Server doesn't use any status bar stuff.
 		// [BC] Now that all the skins have been loaded, parse the bot info.
 		// [TP] This needs to be done before the menus are initialized.
+		StartupProfile.Phase ("BOTS_Construct");
 		BOTS_Construct( );
 		BOTS_ParseBotInfo( );
 		GameConfig->ReadRevealedBotsAndSkins( );
 
+		StartupProfile.Phase ("M_Init");
 		Printf ("M_Init: Init menus.\n");
 		M_Init ();
 
+		StartupProfile.Phase ("P_Init");
 		Printf ("P_Init: Init Playloop state.\n");
 		StartScreen->LoadingStatus ("Init game engine", 0x3f);
 		AM_StaticInit();
@@ -3079,6 +3168,7 @@ void D_DoomMain (void)
 			}
 		}
 
+		StartupProfile.Phase ("D_CheckNetGame");
 		if (!restart)
 		{
 			Printf ("D_CheckNetGame: Checking network game status.\n");
@@ -3110,6 +3200,7 @@ void D_DoomMain (void)
 		delete iwad_man;	// now we won't need this anymore
 
 		// [RH] Run any saved commands from the command line or autoexec.cfg now.
+		StartupProfile.Phase ("Start game");
 		gamestate = GS_FULLCONSOLE;
 		Net_NewMakeTic ();
 		DThinker::RunThinkers ();
@@ -3160,6 +3251,7 @@ void D_DoomMain (void)
 				{
 					singledemo = true;				// quit after one demo
 					G_DeferedPlayDemo (v);
+					StartupProfile.Finish ();
 					D_DoomLoop ();	// never returns
 				}
 
@@ -3167,6 +3259,16 @@ void D_DoomMain (void)
 				if (v)
 				{
 					G_TimeDemo (v);
+					StartupProfile.Finish ();
+					D_DoomLoop ();	// never returns
+				}
+
+				v = Args->CheckValue ("-benchmark");
+				if (v)
+				{
+					BENCHMARK_Start (v);
+					G_TimeDemo (v);
+					StartupProfile.Finish ();
 					D_DoomLoop ();	// never returns
 				}
 
@@ -3275,6 +3377,7 @@ void D_DoomMain (void)
 			}
 		}
 
+		StartupProfile.Finish ();
 		try
 		{
 			D_DoomLoop ();		// never returns
@@ -3328,6 +3431,7 @@ UNSAFE_CCMD(restart)
 	Args->RemoveArgs("-deh");
 	Args->RemoveArgs("-bex");
 	Args->RemoveArgs("-playdemo");
+	Args->RemoveArgs("-benchmark");
 	Args->RemoveArgs("-file");
 	Args->RemoveArgs("-altdeath");
 	Args->RemoveArgs("-deathmatch");
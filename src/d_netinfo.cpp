@@ -1561,7 +1561,10 @@ CCMD (playerinfo)
 
 					// [K6/BB] Show the player's country, if the GeoIP db is available.
 					if ( NETWORK_IsGeoIPAvailable() )
-						infoString.AppendFormat ( TEXTCOLOR_BROWN " - FROM %s", NETWORK_GetCountryCodeFromAddress ( SERVER_GetClient( i )->Address ).GetChars() );
+					{
+						const FString country = NETWORK_GetCountryCodeFromAddress ( SERVER_GetClient( i )->Address );
+						infoString.AppendFormat ( TEXTCOLOR_BROWN " - FROM %s", country.IsNotEmpty() ? country.GetChars() : "?" );
+					}
 				}
 
 				if ( PLAYER_IsTrueSpectator( &players[i] ))
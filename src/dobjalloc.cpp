@@ -0,0 +1,257 @@
+/*
+** dobjalloc.cpp
+** Size-class free lists for DObject memory
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "doomtype.h"
+#include "dobject.h"
+#include "m_alloc.h"
+#include "m_argv.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "tarray.h"
+#include "templates.h"
+#include "i_system.h"
+
+// Every object is preceded by a small header that records where its
+// memory came from, so it can go back to the same place. PClass sizes can
+// be larger than the C++ type (DECORATE user variables), so the size passed
+// to operator delete can't be trusted for this.
+struct FObjectHeader
+{
+	DWORD SizeClass;
+	DWORD Size;
+	DWORD Pad[2];		// keeps the object 16-byte aligned
+};
+
+enum
+{
+	OBJ_GRANULARITY = 16,
+	OBJ_MAXPOOLED = 2048,		// larger than any native actor
+	OBJ_NUMCLASSES = OBJ_MAXPOOLED / OBJ_GRANULARITY,
+	OBJ_SLABSIZE = 64*1024,
+	OBJ_MALLOCED = 0xffffffff	// SizeClass of objects from M_Malloc
+};
+
+struct FFreeObject
+{
+	FFreeObject *Next;
+};
+
+static FFreeObject *FreeLists[OBJ_NUMCLASSES];
+static TArray<void *> Slabs;
+static size_t SlabBytes;
+static size_t PooledObjects;
+static int UsePool = -1;
+
+//==========================================================================
+//
+// AllocSlab
+//
+// Carves a new slab into objects of one size class and puts them on its
+// free list. Slabs come straight from malloc: GC::AllocBytes counts the
+// objects handed out, not the slabs.
+//
+//==========================================================================
+
+static void AllocSlab (unsigned int sizeclass)
+{
+	size_t itemsize = sizeof(FObjectHeader) + (sizeclass + 1) * OBJ_GRANULARITY;
+	size_t count = MAX<size_t>(OBJ_SLABSIZE / itemsize, 16);
+	BYTE *slab = (BYTE *)malloc(count * itemsize);
+
+	if (slab == NULL)
+	{
+		I_FatalError("Could not allocate %u bytes for objects", unsigned(count * itemsize));
+	}
+	Slabs.Push(slab);
+	SlabBytes += count * itemsize;
+
+	// Link them in address order so objects allocated together stay together.
+	for (size_t i = count; i-- > 0; )
+	{
+		FFreeObject *obj = (FFreeObject *)(slab + i * itemsize + sizeof(FObjectHeader));
+		obj->Next = FreeLists[sizeclass];
+		FreeLists[sizeclass] = obj;
+	}
+}
+
+//==========================================================================
+//
+// M_AllocObject
+//
+//==========================================================================
+
+void *M_AllocObject (size_t len)
+{
+	if (UsePool < 0 && Args != NULL)
+	{
+		// -noobjectpool goes back to plain M_Malloc, for comparisons.
+		UsePool = !Args->CheckParm("-noobjectpool");
+	}
+
+	FObjectHeader *header;
+
+	if (len == 0 || len > OBJ_MAXPOOLED || UsePool == 0)
+	{
+		header = (FObjectHeader *)M_Malloc(sizeof(FObjectHeader) + len);
+		header->SizeClass = OBJ_MALLOCED;
+	}
+	else
+	{
+		unsigned int sizeclass = unsigned((len - 1) / OBJ_GRANULARITY);
+
+		if (FreeLists[sizeclass] == NULL)
+		{
+			AllocSlab(sizeclass);
+		}
+		FFreeObject *obj = FreeLists[sizeclass];
+		FreeLists[sizeclass] = obj->Next;
+
+		header = (FObjectHeader *)obj - 1;
+		header->SizeClass = sizeclass;
+		GC::AllocBytes += (sizeclass + 1) * OBJ_GRANULARITY;
+		PooledObjects++;
+	}
+	header->Size = DWORD(len);
+	return header + 1;
+}
+
+//==========================================================================
+//
+// M_FreeObject
+//
+//==========================================================================
+
+void M_FreeObject (void *mem)
+{
+	if (mem == NULL)
+	{
+		return;
+	}
+
+	FObjectHeader *header = (FObjectHeader *)mem - 1;
+
+	if (header->SizeClass == OBJ_MALLOCED)
+	{
+		M_Free(header);
+	}
+	else
+	{
+		unsigned int sizeclass = header->SizeClass;
+		FFreeObject *obj = (FFreeObject *)mem;
+
+		assert(sizeclass < OBJ_NUMCLASSES);
+		obj->Next = FreeLists[sizeclass];
+		FreeLists[sizeclass] = obj;
+		GC::AllocBytes -= (sizeclass + 1) * OBJ_GRANULARITY;
+		PooledObjects--;
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+ADD_STAT(objectpool)
+{
+	FString out;
+	out.Format("Pooled objects: %u, slabs: %u (%u KB), allocated: %u KB",
+		unsigned(PooledObjects), Slabs.Size(), unsigned(SlabBytes >> 10), unsigned(GC::AllocBytes >> 10));
+	return out;
+}
+
+//==========================================================================
+//
+// CCMD objectpoolbench
+//
+// Allocates and frees objects in random order, like actors spawning and
+// dying, once through the pool and once through M_Malloc.
+//
+//==========================================================================
+
+CCMD (objectpoolbench)
+{
+	static const size_t sizes[] = { 64, 120, 256, 512, 984, 1096 };
+	const int numsizes = countof(sizes);
+	int count = argv.argc() > 1 ? atoi(argv[1]) : 10000;
+	int rounds = argv.argc() > 2 ? atoi(argv[2]) : 20;
+	if (count <= 0 || rounds <= 0)
+	{
+		Printf("Usage: objectpoolbench [objects] [rounds]\n");
+		return;
+	}
+
+	TArray<void *> live;
+	TArray<int> order;
+	DWORD seed = 0x9e3779b9;
+	order.Resize(count);
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		cycle_t time;
+		time.Reset();
+		time.Clock();
+		for (int r = 0; r < rounds; ++r)
+		{
+			live.Resize(count);
+			for (int i = 0; i < count; ++i)
+			{
+				size_t size = sizes[i % numsizes];
+				live[i] = pass == 0 ? M_AllocObject(size) : M_Malloc(size);
+				memset(live[i], 0, size);
+				order[i] = i;
+			}
+			// Free in a shuffled order, like objects dying at random.
+			for (int i = count - 1; i > 0; --i)
+			{
+				seed = seed * 1664525 + 1013904223;
+				std::swap(order[i], order[(seed >> 8) % (i + 1)]);
+			}
+			for (int i = 0; i < count; ++i)
+			{
+				if (pass == 0) M_FreeObject(live[order[i]]);
+				else M_Free(live[order[i]]);
+			}
+		}
+		time.Unclock();
+		Printf("%s: %d x %d allocations in %.3f ms\n", pass == 0 ? "Object pool" : "M_Malloc",
+			rounds, count, time.TimeMS());
+	}
+}
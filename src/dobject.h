@@ -226,6 +226,10 @@ enum EObjectFlags
 
 template<class T> class TObjPtr;
 
+// Memory for DObjects comes from per-size free lists (see dobjalloc.cpp).
+void *M_AllocObject (size_t len);
+void M_FreeObject (void *mem);
+
 namespace GC
 {
 	enum EGCState
@@ -492,12 +496,12 @@ public:
 
 	void *operator new(size_t len)
 	{
-		return M_Malloc(len);
+		return M_AllocObject(len);
 	}
 
 	void operator delete (void *mem)
 	{
-		M_Free(mem);
+		M_FreeObject(mem);
 	}
 
 	// GC fiddling
@@ -562,9 +566,10 @@ protected:
 		return (void *)mem;
 	}
 
+	// Placement new didn't allocate anything, so there is nothing to free here.
+	// CreateNew releases the memory itself if a constructor throws.
 	void operator delete (void *mem, EInPlace *)
 	{
-		M_Free (mem);
 	}
 };
 
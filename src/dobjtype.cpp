@@ -255,7 +255,7 @@ const PClass *PClass::FindClass (FName zaname)
 // Create a new object that this class represents
 DObject *PClass::CreateNew () const
 {
-	BYTE *mem = (BYTE *)M_Malloc (Size);
+	BYTE *mem = (BYTE *)M_AllocObject (Size);
 	assert (mem != NULL);
 
 	// Set this object's defaults before constructing it.
@@ -264,7 +264,15 @@ DObject *PClass::CreateNew () const
 	else
 		memset (mem, 0, Size);
 
-	ConstructNative (mem);
+	try
+	{
+		ConstructNative (mem);
+	}
+	catch (...)
+	{
+		M_FreeObject (mem);
+		throw;
+	}
 	((DObject *)mem)->SetClass (const_cast<PClass *>(this));
 	return (DObject *)mem;
 }
@@ -46,9 +46,10 @@
 // [BB] New #includes.
 #include "cl_demo.h"
 #include "doomstat.h"
+#include "sv_profile.h"
 
 
-static cycle_t ThinkCycles;
+cycle_t ThinkCycles;
 
 IMPLEMENT_CLASS (DThinker)
 
@@ -409,6 +410,8 @@ void DThinker::RunThinkers ()
 {
 	int i, count;
 
+	FServerProfileScope profile( SPP_THINKERS );
+
 	ThinkCycles.Reset();
 
 	ThinkCycles.Clock();
@@ -469,7 +472,21 @@ int DThinker::TickThinkers (FThinkerList *list, FThinkerList *dest)
 				( node->IsKindOf( RUNTIME_CLASS( AActor )) == false ) ||
 				( static_cast<AActor *>( node ) != players[consoleplayer].mo ))
 			{
-				node->Tick();
+				if ( SERVERPROFILE_IsProfilingThinkers( ))
+				{
+					// The thinker may destroy itself, so get the class first.
+					const PClass *type = node->GetClass();
+					cycle_t cycles;
+					cycles.Reset();
+					cycles.Clock();
+					node->Tick();
+					cycles.Unclock();
+					SERVERPROFILE_AddThinkerTime( type, cycles.TimeMS() );
+				}
+				else
+				{
+					node->Tick();
+				}
 			}
 			node->ObjectFlags &= ~OF_JustSpawned;
 			GC::CheckGC();
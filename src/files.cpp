@@ -33,10 +33,21 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#define USE_WINDOWS_DWORD
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "files.h"
 #include "i_system.h"
 #include "templates.h"
 #include "m_misc.h"
+#include "m_argv.h"
 
 //==========================================================================
 //
@@ -527,3 +538,134 @@ char *MemoryReader::Gets(char *strbuf, int len)
 {
 	return GetsFromBuffer(bufptr, strbuf, len);
 }
+
+//==========================================================================
+//
+// MappedFileReader
+//
+// reads data from a file mapped into memory
+//
+//==========================================================================
+
+MappedFileReader::MappedFileReader ()
+: bufptr(NULL)
+{
+#ifdef _WIN32
+	MappingHandle = NULL;
+#endif
+}
+
+MappedFileReader::~MappedFileReader ()
+{
+	if (bufptr != NULL)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(bufptr);
+		CloseHandle(MappingHandle);
+#else
+		munmap(const_cast<char *>(bufptr), Length);
+#endif
+		bufptr = NULL;
+	}
+}
+
+bool MappedFileReader::Open (const char *filename)
+{
+	if (!FileReader::Open(filename) || Length <= 0)
+	{
+		return false;
+	}
+
+#ifdef _WIN32
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno(File));
+	MappingHandle = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (MappingHandle == NULL)
+	{
+		return false;
+	}
+	void *view = MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		CloseHandle(MappingHandle);
+		MappingHandle = NULL;
+		return false;
+	}
+#else
+	void *view = mmap(NULL, Length, PROT_READ, MAP_PRIVATE, fileno(File), 0);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+#endif
+	bufptr = (const char *)view;
+	return true;
+}
+
+FileReader *MappedFileReader::OpenFile (const char *filename)
+{
+	if (!Args->CheckParm("-nommap"))
+	{
+		MappedFileReader *reader = new MappedFileReader;
+		if (reader->Open(filename))
+		{
+			return reader;
+		}
+		delete reader;
+	}
+	return new FileReader(filename);
+}
+
+long MappedFileReader::Tell () const
+{
+	return FilePos;
+}
+
+long MappedFileReader::Seek (long offset, int origin)
+{
+	switch (origin)
+	{
+	case SEEK_CUR:
+		offset += FilePos;
+		break;
+
+	case SEEK_END:
+		offset += Length;
+		break;
+
+	}
+	FilePos = clamp<long>(offset, 0, Length);
+	return 0;
+}
+
+long MappedFileReader::Read (void *buffer, long len)
+{
+	if (len > Length - FilePos) len = Length - FilePos;
+	if (len < 0) len = 0;
+	memcpy(buffer, bufptr + FilePos, len);
+	FilePos += len;
+	return len;
+}
+
+char *MappedFileReader::Gets(char *strbuf, int len)
+{
+	return GetsFromBuffer(bufptr, strbuf, len);
+}
+
+void MappedFileReader::Prefetch (long offset, long len) const
+{
+#ifndef _WIN32
+	if (offset < 0 || len <= 0 || offset >= Length)
+	{
+		return;
+	}
+	if (len > Length - offset)
+	{
+		len = Length - offset;
+	}
+
+	// madvise wants a page aligned address.
+	static const long pagesize = sysconf(_SC_PAGESIZE);
+	long start = offset - (offset % pagesize);
+	madvise(const_cast<char *>(bufptr) + start, len + (offset - start), MADV_WILLNEED);
+#endif
+}
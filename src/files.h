@@ -80,6 +80,9 @@ public:
 	FILE *GetFile () const { return File; }
 	virtual const char *GetBuffer() const { return NULL; }
 
+	// Hints that the given part of the file is going to be read soon.
+	virtual void Prefetch (long offset, long len) const {}
+
 	FileReader &operator>> (BYTE &v)
 	{
 		Read (&v, 1);
@@ -338,6 +341,34 @@ protected:
 	const char * bufptr;
 };
 
+// Reads a whole file through a read-only memory mapping, so that uncompressed
+// lumps can point right into it instead of being copied into their own buffers.
+// The FILE is kept open for the code that wants to stream from it directly.
+class MappedFileReader : public FileReader
+{
+public:
+	MappedFileReader ();
+	~MappedFileReader ();
+
+	bool Open (const char *filename);
+
+	virtual long Tell () const;
+	virtual long Seek (long offset, int origin);
+	virtual long Read (void *buffer, long len);
+	virtual char *Gets(char *strbuf, int len);
+	virtual const char *GetBuffer() const { return bufptr; }
+	virtual void Prefetch (long offset, long len) const;
+
+	// Maps the file if possible and falls back to a normal FileReader otherwise.
+	static FileReader *OpenFile (const char *filename);
+
+protected:
+	const char * bufptr;
+#ifdef _WIN32
+	void * MappingHandle;
+#endif
+};
+
 
 
 #endif
@@ -90,6 +90,7 @@
 #include "sv_commands.h"
 #include "medal.h"
 #include "cl_demo.h"
+#include "benchmark.h"
 #include "cl_main.h"
 #include "cl_statistics.h"
 #include "browser.h"
@@ -1538,7 +1539,11 @@ void G_Ticker ()
 	{
 		// [BB] .. only if the demo is not currently paused.
 		if ( CLIENTDEMO_IsPaused( ) == false )
+		{
+			BenchNetCycles.Clock( );
 			CLIENTDEMO_ReadPacket( );
+			BenchNetCycles.Unclock( );
+		}
 		// [BB] If the demo is paused, the tic offset increases.
 		else
 			CLIENTDEMO_SetGameticOffset ( CLIENTDEMO_GetGameticOffset() + 1 );
@@ -5339,6 +5344,9 @@ bool G_CheckDemoStatus (void)
 		{
 			if (timingdemo)
 			{
+				// Writes the results and quits if this was a -benchmark run.
+				BENCHMARK_Finish ();
+
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
@@ -1598,6 +1598,7 @@ void G_DoLoadLevel (int position, bool autosave)
 		string.Format( "%s: %s", level.mapname, level.LevelName.GetChars() );
 		SERVERCONSOLE_SetCurrentMapname( string );
 		SERVERCONSOLE_UpdateScoreboard( );
+		SERVER_MASTER_InvalidateServerInfo( );
 
 		// Reset the columns.
 		SERVERCONSOLE_SetupColumns( );
@@ -42,6 +42,7 @@
 #include "g_level.h"
 #include "thingdef/thingdef.h"
 #include "i_system.h"
+#include "stats.h"
 
 // [BB] New #includes.
 #include "network.h"
@@ -414,33 +415,18 @@ size_t ADynamicLight::PointerSubstitution (DObject *old, DObject *notOld)
 //
 // These have been copied from the secnode code and modified for the light links
 //
-// P_AddSecnode() searches the current list to see if this sector is
-// already there. If not, it adds a sector node at the head of the list of
-// sectors this object appears in. This is called when creating a list of
-// nodes that will get linked in later. Returns a pointer to the new node.
+// Adds a node at the head of the list of targets this light touches and
+// at the head of the target's light list. Unlike P_AddSecnode no search for
+// an existing node is done: LinkLight releases all old nodes first and
+// CollectWithinRadius visits each subsector and linedef only once per pass,
+// so a duplicate cannot occur. Returns a pointer to the new node.
 //
 //=============================================================================
 static FreeList<FLightNode> freelist;
 
 FLightNode * AddLightNode(FLightNode ** thread, void * linkto, ADynamicLight * light, FLightNode *& nextnode)
 {
-	FLightNode * node;
-
-	node = nextnode;
-	while (node)
-    {
-		if (node->targ==linkto)   // Already have a node for this sector?
-		{
-			node->lightsource = light; // Yes. Setting m_thing says 'keep it'.
-			return(nextnode);
-		}
-		node = node->nextTarget;
-    }
-
-	// Couldn't find an existing node for this sector. Add one at the head
-	// of the list.
-	
-	node = freelist.GetNew();
+	FLightNode * node = freelist.GetNew();
 	
 	node->targ = linkto;
 	node->lightsource = light; 
@@ -567,29 +553,56 @@ void ADynamicLight::CollectWithinRadius(subsector_t *subSec, float radius)
 	}
 }
 
+//==========================================================================
+//
+// Per-frame link statistics
+//
+// Everything linked since the previous frame started, including the tics
+// run in between, is counted towards the frame that follows them.
+//
+//==========================================================================
+
+static cycle_t LinkCycles;
+static int LinkCount, LinkNodes;
+static int LastLinkCount, LastLinkNodes;
+static double LastLinkMS;
+
+void gl_ResetLightLinkStats()
+{
+	LastLinkCount = LinkCount;
+	LastLinkNodes = LinkNodes;
+	LastLinkMS = LinkCycles.TimeMS();
+	LinkCount = LinkNodes = 0;
+	LinkCycles.Reset();
+}
+
+ADD_STAT(lightlinks)
+{
+	FString out;
+	out.Format("Light relinks=%d, nodes=%d, time=%2.3f ms (last frame)", 
+		LastLinkCount, LastLinkNodes, LastLinkMS);
+	return out;
+}
+
 //==========================================================================
 //
 // Link the light into the world
 //
+// The old links are released to the free list up front and the touched
+// subsectors and sides are collected from scratch. This is cheaper than
+// matching each new node against the old list, which was quadratic in
+// the number of touched surfaces, and it also drops nodes that were
+// linked to the other additive/non-additive list before.
+//
 //==========================================================================
 
 void ADynamicLight::LinkLight()
 {
-	// mark the old light nodes
-	FLightNode * node;
-	
-	node = touching_sides;
-	while (node)
-    {
-		node->lightsource = NULL;
-		node = node->nextTarget;
-    }
-	node = touching_subsectors;
-	while (node)
-    {
-		node->lightsource = NULL;
-		node = node->nextTarget;
-    }
+	int nodes = 0;
+
+	LinkCycles.Clock();
+	while (touching_sides) touching_sides = DeleteLightNode(touching_sides);
+	while (touching_subsectors) touching_subsectors = DeleteLightNode(touching_subsectors);
 
 	if (radius>0)
 	{
@@ -602,31 +615,12 @@ void ADynamicLight::LinkLight()
 			CollectWithinRadius(subSec, fradius*fradius);
 		}
 	}
-		
-	// Now delete any nodes that won't be used. These are the ones where
-	// m_thing is still NULL.
-	
-	node = touching_sides;
-	while (node)
-	{
-		if (node->lightsource == NULL)
-		{
-			node = DeleteLightNode(node);
-		}
-		else
-			node = node->nextTarget;
-	}
+	LinkCycles.Unclock();
 
-	node = touching_subsectors;
-	while (node)
-	{
-		if (node->lightsource == NULL)
-		{
-			node = DeleteLightNode(node);
-		}
-		else
-			node = node->nextTarget;
-	}
+	for (FLightNode *node = touching_sides; node; node = node->nextTarget) nodes++;
+	for (FLightNode *node = touching_subsectors; node; node = node->nextTarget) nodes++;
+	LinkCount++;
+	LinkNodes += nodes;
 }
 
 
@@ -185,6 +185,7 @@ struct FDynLightData
 bool gl_GetLight(Plane & p, ADynamicLight * light, int desaturation, bool checkside, bool forceadditive, FDynLightData &data);
 bool gl_SetupLight(Plane & p, ADynamicLight * light, Vector & nearPt, Vector & up, Vector & right, float & scale, int desaturation, bool checkside=true, bool forceadditive=true);
 bool gl_SetupLightTexture();
+void gl_ResetLightLinkStats();
 
 
 #endif
@@ -51,6 +51,7 @@
 #include "gl/scene/gl_clipper.h"
 #include "gl/scene/gl_portal.h"
 #include "gl/scene/gl_wall.h"
+#include "gl/scene/gl_wallqueue.h"
 #include "gl/utility/gl_clock.h"
 
 EXTERN_CVAR(Bool, gl_render_segs)
@@ -187,20 +188,16 @@ static void AddLine (seg_t *seg)
 		{
 			SetupWall.Clock();
 
-			//if (!gl_multithreading)
+			if (gl_wallqueue.IsActive())
 			{
-				GLWall wall;
-				wall.sub = currentsubsector;
-				wall.Process(seg, currentsector, backsector);
+				gl_wallqueue.Queue(seg, currentsubsector, currentsector, backsector);
 			}
-			/*
 			else
 			{
-				FJob *job = new FGLJobProcessWall(currentsubsector, seg, 
-					currentsector->sectornum, backsector != NULL? backsector->sectornum : -1);
-				GLRenderer->mThreadManager->AddJob(job);
+				GLWall wall;
+				wall.sub = currentsubsector;
+				wall.Process(seg, currentsector, backsector);
 			}
-			*/
 			rendered_lines++;
 
 			SetupWall.Unclock();
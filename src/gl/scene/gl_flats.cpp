@@ -121,8 +121,10 @@ void GLFlat::DrawSubsectorLights(subsector_t * sub, int pass)
 	seg_t *v;
 
 	FLightNode * node = sub->lighthead[pass==GLPASS_LIGHT_ADDITIVE];
+	int budget = gl_lights_maxpersurface;
+	int used = 0;
 	gl_RenderState.Apply();
-	while (node)
+	while (node && (budget <= 0 || used < budget))
 	{
 		ADynamicLight * light = node->lightsource;
 		
@@ -149,6 +151,7 @@ void GLFlat::DrawSubsectorLights(subsector_t * sub, int pass)
 			continue;
 		}
 		draw_dlightf++;
+		used++;
 
 		// Render the light
 		glBegin(GL_TRIANGLE_FAN);
@@ -181,11 +184,14 @@ bool GLFlat::SetupSubsectorLights(bool lightsapplied, subsector_t * sub)
 {
 	Plane p;
 
+	int budget = gl_lights_maxpersurface;
+	int used = 0;
+
 	lightdata.Clear();
 	for(int i=0;i<2;i++)
 	{
 		FLightNode * node = sub->lighthead[i];
-		while (node)
+		while (node && (budget <= 0 || used < budget))
 		{
 			ADynamicLight * light = node->lightsource;
 			
@@ -206,7 +212,7 @@ bool GLFlat::SetupSubsectorLights(bool lightsapplied, subsector_t * sub)
 			}
 
 			p.Set(plane.plane);
-			gl_GetLight(p, light, Colormap.colormap, false, false, lightdata);
+			if (gl_GetLight(p, light, Colormap.colormap, false, false, lightdata)) used++;
 			node = node->nextLight;
 		}
 	}
@@ -51,6 +51,7 @@
 #include "gl/dynlights/gl_lightbuffer.h"
 #include "gl/scene/gl_drawinfo.h"
 #include "gl/scene/gl_portal.h"
+#include "gl/scene/gl_wallqueue.h"
 #include "gl/utility/gl_clock.h"
 #include "gl/utility/gl_templates.h"
 
@@ -144,6 +145,7 @@ void FDrawInfo::AddOtherCeilingPlane(int sector, gl_subsectorrendernode * node)
 void FDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, fixed_t backheight)
 {
 	if (!side->segs[0]->backsector) return;
+	if (FGLWallQueue::DeferMissingTexture(true, side, sub, backheight)) return;
 
 	totalms.Clock();
 	for(int i=0; i<side->numsegs; i++)
@@ -202,6 +204,7 @@ void FDrawInfo::AddLowerMissingTexture(side_t * side, subsector_t *sub, fixed_t
 {
 	sector_t *backsec = side->segs[0]->backsector;
 	if (!backsec) return;
+	if (FGLWallQueue::DeferMissingTexture(false, side, sub, backheight)) return;
 	if (backsec->transdoor)
 	{
 		// Transparent door hacks alter the backsector's floor height so we should not
@@ -70,6 +70,7 @@
 #include "gl/scene/gl_clipper.h"
 #include "gl/scene/gl_drawinfo.h"
 #include "gl/scene/gl_portal.h"
+#include "gl/scene/gl_wallqueue.h"
 #include "gl/shaders/gl_shader.h"
 #include "gl/textures/gl_material.h"
 #include "gl/utility/gl_clock.h"
@@ -339,12 +340,15 @@ void FGLRenderer::CreateScene()
 	PO_LinkToSubsectors();
 
 	ProcessAll.Clock();
+	SceneBuild.Clock();
 
 	// clip the scene and fill the drawlists
 	for(unsigned i=0;i<portals.Size(); i++) portals[i]->glportal = NULL;
 	gl_spriteindex=0;
 	Bsp.Clock();
+	gl_wallqueue.Begin();
 	gl_RenderBSPNode (nodes + numnodes - 1);
+	gl_wallqueue.Flush();
 	Bsp.Unclock();
 
 	// And now the crappy hacks that have to be done to avoid rendering anomalies:
@@ -354,6 +358,7 @@ void FGLRenderer::CreateScene()
 	gl_drawinfo->ProcessSectorStacks();		// merge visplanes of sector stacks
 
 	GLRenderer->mVBO->UnmapVBO ();
+	SceneBuild.Unclock();
 	ProcessAll.Unclock();
 
 }
@@ -369,6 +374,7 @@ void FGLRenderer::CreateScene()
 void FGLRenderer::RenderScene(int recursion)
 {
 	RenderAll.Clock();
+	SceneSubmit.Clock();
 
 	glDepthMask(true);
 	if (!gl_no_skyclear) GLPortal::RenderFirstSkyPortal(recursion);
@@ -552,6 +558,7 @@ void FGLRenderer::RenderScene(int recursion)
 	glPolygonOffset(0.0f, 0.0f);
 	glDisable(GL_POLYGON_OFFSET_FILL);
 
+	SceneSubmit.Unclock();
 	RenderAll.Unclock();
 }
 
@@ -566,6 +573,7 @@ void FGLRenderer::RenderScene(int recursion)
 void FGLRenderer::RenderTranslucent()
 {
 	RenderAll.Clock();
+	SceneSubmit.Clock();
 
 	glDepthMask(false);
 	gl_RenderState.SetCameraPos(FIXED2FLOAT(viewx), FIXED2FLOAT(viewy), FIXED2FLOAT(viewz));
@@ -583,6 +591,7 @@ void FGLRenderer::RenderTranslucent()
 	glDepthMask(true);
 
 	gl_RenderState.AlphaFunc(GL_GEQUAL,0.5f);
+	SceneSubmit.Unclock();
 	RenderAll.Unclock();
 }
 
@@ -1023,6 +1032,7 @@ void FGLRenderer::RenderView (player_t* player)
 
 	// reset statistics counters
 	ResetProfilingData();
+	gl_ResetLightLinkStats();
 
 	// Get this before everything else
 	if (cl_capfps || r_NoInterpolate) r_TicFrac = FRACUNIT;
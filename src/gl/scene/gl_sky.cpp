@@ -51,6 +51,7 @@
 #include "gl/renderer/gl_lightdata.h"
 #include "gl/scene/gl_drawinfo.h"
 #include "gl/scene/gl_portal.h"
+#include "gl/scene/gl_wallqueue.h"
 #include "gl/textures/gl_material.h"
 #include "gl/utility/gl_convert.h"
 
@@ -150,7 +151,10 @@ void GLWall::SkyPlane(sector_t *sector, int plane, bool allowreflect)
 			else skyinfo.fadecolor=0;
 
 			type=RENDERWALL_SKY;
-			sky=UniqueSkies.Get(&skyinfo);
+			{
+				std::lock_guard<std::mutex> lock(FGLWallQueue::UniqueMutex);
+				sky=UniqueSkies.Get(&skyinfo);
+			}
 		}
 	}
 	else if (allowreflect && sector->GetReflect(plane) > 0)
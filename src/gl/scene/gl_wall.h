@@ -105,6 +105,7 @@ public:
 
 	friend struct GLDrawList;
 	friend class GLPortal;
+	friend class FGLWallQueue;
 
 	GLSeg glseg;
 	vertex_t * vertexes[2];				// required for polygon splitting
@@ -0,0 +1,412 @@
+/*
+** gl_wallqueue.cpp
+** Deferred wall processing for the GL renderer
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "gl/system/gl_system.h"
+#include "templates.h"
+#include "c_cvars.h"
+#include "doomstat.h"
+#include "r_state.h"
+#include "r_sky.h"
+#include "p_3dfloors.h"
+#include "workerthreads.h"
+#include "gl/system/gl_cvars.h"
+#include "gl/data/gl_data.h"
+#include "gl/scene/gl_drawinfo.h"
+#include "gl/scene/gl_portal.h"
+#include "gl/scene/gl_wallqueue.h"
+#include "gl/textures/gl_material.h"
+#include "gl/utility/gl_clock.h"
+
+// 0 uses one thread per core, 1 processes the walls during the BSP traversal.
+CVAR(Int, gl_scenethreads, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+EXTERN_CVAR(Bool, gl_seamless)
+
+// Below this many walls per thread it's not worth waking up the workers.
+#define MIN_CHUNKWALLS	32
+
+FGLWallQueue gl_wallqueue;
+
+thread_local TArray<FGLWallQueue::FWallResult> *FGLWallQueue::Collector;
+thread_local int *FGLWallQueue::TexSplits;
+std::mutex FGLWallQueue::UniqueMutex;
+
+static std::mutex WallChunkMutex;
+static std::condition_variable WallChunksDone;
+static int WallChunksRunning;
+static std::atomic<int> NextWallChunk;
+
+//==========================================================================
+//
+// FGLWallQueue :: FGLWallQueue
+//
+//==========================================================================
+
+FGLWallQueue::FGLWallQueue ()
+: NumFakeSectors(0), NumThreads(1), bActive(false)
+{
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: Begin
+//
+//==========================================================================
+
+void FGLWallQueue::Begin ()
+{
+	int threads = gl_scenethreads;
+	if (threads <= 0)
+	{
+		threads = (int)std::thread::hardware_concurrency();
+	}
+	NumThreads = clamp (threads, 1, FWorkerThreads::Get().NumThreads() + 1);
+	bActive = NumThreads > 1;
+	NumFakeSectors = 0;
+	Walls.Clear();
+
+	if (bActive)
+	{
+		FMaterial::ValidateTexture(sky1texture, true);
+		FMaterial::ValidateTexture(sky2texture, true);
+	}
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: KeepSector
+//
+// Sectors made up by gl_FakeFlat live on the caller's stack, so they have
+// to be copied if they are to be used after the traversal.
+//
+//==========================================================================
+
+sector_t *FGLWallQueue::KeepSector (sector_t *sector)
+{
+	if (sector == NULL || (sector >= sectors && sector < sectors + numsectors))
+	{
+		return sector;
+	}
+	if (NumFakeSectors == FakeSectors.Size())
+	{
+		FakeSectors.Push(new sector_t);
+	}
+	sector_t *copy = FakeSectors[NumFakeSectors++];
+	*copy = *sector;
+	return copy;
+}
+
+//==========================================================================
+//
+// ValidateMidTexture
+//
+// GLWall::DoMidTexture asks if the texture is transparent, which creates
+// its texture buffer the first time.
+//
+//==========================================================================
+
+static void ValidateMidTexture (FTextureID texid)
+{
+	FTexture *tex = TexMan(texid);
+	if (tex == NULL)
+	{
+		return;
+	}
+	FMaterial *gltex = FMaterial::ValidateTexture(tex);
+	if (gltex != NULL) gltex->GetTransparent();
+
+	if (i_compatflags & COMPATF_MASKEDMIDTEX)
+	{
+		gltex = FMaterial::ValidateTexture(tex->GetRawTexture());
+		if (gltex != NULL) gltex->GetTransparent();
+	}
+}
+
+//==========================================================================
+//
+// ValidateSectorTextures
+//
+// The textures a wall takes from somewhere other than its own sidedef:
+// the control line of a 3D floor and the line of a sky transfer.
+//
+//==========================================================================
+
+static void ValidateSectorTextures (sector_t *sector)
+{
+	if (sector == NULL)
+	{
+		return;
+	}
+
+	TArray<F3DFloor *> &ffloors = sector->e->XFloor.ffloors;
+	for (unsigned int i = 0; i < ffloors.Size(); i++)
+	{
+		FMaterial::ValidateTexture(ffloors[i]->master->sidedef[0]->GetTexture(side_t::mid), true);
+	}
+
+	int sky = sector->sky;
+	if ((sky & PL_SKYFLAT) && (sky & (PL_SKYFLAT-1)))
+	{
+		const side_t *s = lines[(sky & (PL_SKYFLAT-1)) - 1].sidedef[0];
+		FMaterial::ValidateTexture(s->GetTexture(side_t::top), true);
+		FMaterial::ValidateTexture(s->GetTexture(side_t::bottom), true);
+	}
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: Queue
+//
+// Anything GLWall::Process would otherwise set up lazily is done here, on
+// the main thread, so that the workers only read materials and texture
+// information that already exist.
+//
+//==========================================================================
+
+void FGLWallQueue::Queue (seg_t *seg, subsector_t *sub, sector_t *frontsector, sector_t *backsector)
+{
+	FQueuedWall &wall = Walls[Walls.Reserve(1)];
+
+	wall.seg = seg;
+	wall.sub = sub;
+	wall.frontsector = KeepSector(frontsector);
+	wall.backsector = backsector == frontsector ? wall.frontsector : KeepSector(backsector);
+
+	side_t *side = seg->sidedef;
+	if (gl_seamless && !(side->Flags & WALLF_POLYOBJ))
+	{
+		if (seg->linedef->v1->dirty) gl_RecalcVertexHeights(seg->linedef->v1);
+		if (seg->linedef->v2->dirty) gl_RecalcVertexHeights(seg->linedef->v2);
+	}
+
+	FMaterial::ValidateTexture(side->GetTexture(side_t::top), true);
+	FMaterial::ValidateTexture(side->GetTexture(side_t::bottom), true);
+	ValidateMidTexture(side->GetTexture(side_t::mid));
+	FMaterial::ValidateTexture(frontsector->GetTexture(sector_t::ceiling), true);
+	FMaterial::ValidateTexture(frontsector->GetTexture(sector_t::floor), true);
+	ValidateSectorTextures(frontsector);
+	if (backsector != frontsector) ValidateSectorTextures(backsector);
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: ProcessChunk
+//
+//==========================================================================
+
+void FGLWallQueue::ProcessChunk (int chunk, int numchunks)
+{
+	unsigned int first = Walls.Size() * chunk / numchunks;
+	unsigned int last = Walls.Size() * (chunk + 1) / numchunks;
+
+	Collector = &ChunkResults[chunk];
+	TexSplits = &ChunkTexSplits[chunk];
+	*TexSplits = 0;
+	for (unsigned int i = first; i < last; i++)
+	{
+		const FQueuedWall &queued = Walls[i];
+		GLWall wall;
+
+		wall.sub = queued.sub;
+		wall.Process(queued.seg, queued.frontsector, queued.backsector);
+	}
+	Collector = NULL;
+	TexSplits = NULL;
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: Flush
+//
+// The main thread processes chunks along with the workers and then puts
+// all results into the draw info, chunk by chunk.
+//
+//==========================================================================
+
+void FGLWallQueue::Flush ()
+{
+	if (Walls.Size() == 0)
+	{
+		return;
+	}
+
+	SceneWalls.Clock();
+	queued_walls += Walls.Size();
+
+	int numchunks = MIN<int> (Walls.Size() / MIN_CHUNKWALLS, NumThreads * 4);
+	numchunks = MIN<int> (numchunks, MAX_CHUNKS);
+
+	if (numchunks <= 1)
+	{
+		numchunks = 1;
+		ProcessChunk (0, 1);
+	}
+	else
+	{
+		int workers = MIN (NumThreads - 1, numchunks - 1);
+
+		scene_threads = MAX (scene_threads, workers + 1);
+		NextWallChunk = 0;
+		WallChunksRunning = workers;
+		for (int i = 0; i < workers; ++i)
+		{
+			FWorkerThreads::Get().SubmitUrgent([this, numchunks]()
+			{
+				int chunk;
+				while ((chunk = NextWallChunk++) < numchunks)
+				{
+					ProcessChunk (chunk, numchunks);
+				}
+				{
+					std::lock_guard<std::mutex> lock(WallChunkMutex);
+					WallChunksRunning--;
+				}
+				WallChunksDone.notify_all();
+			});
+		}
+
+		int chunk;
+		while ((chunk = NextWallChunk++) < numchunks)
+		{
+			ProcessChunk (chunk, numchunks);
+		}
+		// Workers that are still busy elsewhere haven't started their job
+		// yet. There are no chunks left for it, so just retire it here.
+		FWorkerThreads::Get().RunUrgentJobs ();
+		{
+			std::unique_lock<std::mutex> lock(WallChunkMutex);
+			WallChunksDone.wait(lock, [] { return WallChunksRunning == 0; });
+		}
+	}
+
+	for (int i = 0; i < numchunks; ++i)
+	{
+		render_texsplit += ChunkTexSplits[i];
+
+		TArray<FWallResult> &results = ChunkResults[i];
+		for (unsigned int j = 0; j < results.Size(); ++j)
+		{
+			FWallResult &result = results[j];
+			switch (result.Type)
+			{
+			case RESULT_WALL:
+				result.Wall.PutWall(result.Translucent);
+				break;
+
+			case RESULT_UPPERMISSING:
+				gl_drawinfo->AddUpperMissingTexture(result.Side, result.Sub, result.BackHeight);
+				break;
+
+			case RESULT_LOWERMISSING:
+				gl_drawinfo->AddLowerMissingTexture(result.Side, result.Sub, result.BackHeight);
+				break;
+			}
+		}
+		results.Clear();
+	}
+	Walls.Clear();
+	SceneWalls.Unclock();
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: DeferWall
+//
+// Horizons and plane mirrors may point into the processing thread's stack
+// or a sector copy, so they are made unique before the wall is recorded.
+//
+//==========================================================================
+
+bool FGLWallQueue::DeferWall (GLWall *wall, bool translucent)
+{
+	if (Collector == NULL)
+	{
+		return false;
+	}
+	if (wall->type == RENDERWALL_HORIZON)
+	{
+		std::lock_guard<std::mutex> lock(UniqueMutex);
+		wall->horizon = UniqueHorizons.Get(wall->horizon);
+	}
+	else if (wall->type == RENDERWALL_PLANEMIRROR)
+	{
+		std::lock_guard<std::mutex> lock(UniqueMutex);
+		wall->planemirror = UniquePlaneMirrors.Get(wall->planemirror);
+	}
+
+	FWallResult &result = (*Collector)[Collector->Reserve(1)];
+	result.Type = RESULT_WALL;
+	result.Translucent = translucent;
+	result.Wall = *wall;
+	return true;
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: CountTexSplit
+//
+//==========================================================================
+
+void FGLWallQueue::CountTexSplit (int count)
+{
+	if (TexSplits != NULL) *TexSplits += count;
+	else render_texsplit += count;
+}
+
+//==========================================================================
+//
+// FGLWallQueue :: DeferMissingTexture
+//
+//==========================================================================
+
+bool FGLWallQueue::DeferMissingTexture (bool upper, side_t *side, subsector_t *sub, fixed_t backheight)
+{
+	if (Collector == NULL)
+	{
+		return false;
+	}
+
+	FWallResult &result = (*Collector)[Collector->Reserve(1)];
+	result.Type = upper ? RESULT_UPPERMISSING : RESULT_LOWERMISSING;
+	result.Side = side;
+	result.Sub = sub;
+	result.BackHeight = backheight;
+	return true;
+}
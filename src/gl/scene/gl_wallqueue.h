@@ -0,0 +1,120 @@
+/*
+** gl_wallqueue.h
+** Deferred wall processing for the GL renderer
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#ifndef __GL_WALLQUEUE_H
+#define __GL_WALLQUEUE_H
+
+#include <mutex>
+#include "tarray.h"
+#include "gl/scene/gl_wall.h"
+
+//==========================================================================
+//
+// The BSP traversal only clips and queues the visible walls. Once it is
+// done, the queued walls are processed on the worker threads and their
+// results are put into the draw lists chunk by chunk. The unique sky,
+// horizon and plane mirror lists are filled in whatever order the threads
+// get to them, so with more than one thread the draw lists' order may
+// differ from gl_scenethreads 1.
+//
+//==========================================================================
+
+class FGLWallQueue
+{
+	struct FQueuedWall
+	{
+		seg_t *seg;
+		subsector_t *sub;
+		sector_t *frontsector;
+		sector_t *backsector;
+	};
+
+	enum
+	{
+		RESULT_WALL,
+		RESULT_UPPERMISSING,
+		RESULT_LOWERMISSING,
+	};
+
+	struct FWallResult
+	{
+		BYTE Type;
+		bool Translucent;
+		GLWall Wall;
+		side_t *Side;
+		subsector_t *Sub;
+		fixed_t BackHeight;
+	};
+
+	enum { MAX_CHUNKS = 64 };
+
+	TArray<FQueuedWall> Walls;
+	TArray<FWallResult> ChunkResults[MAX_CHUNKS];
+	int ChunkTexSplits[MAX_CHUNKS];
+	TDeletingArray<sector_t *> FakeSectors;
+	unsigned int NumFakeSectors;
+	int NumThreads;
+	bool bActive;
+
+	static thread_local TArray<FWallResult> *Collector;
+	static thread_local int *TexSplits;
+
+	sector_t *KeepSector (sector_t *sector);
+	void ProcessChunk (int chunk, int numchunks);
+
+public:
+	FGLWallQueue ();
+
+	void Begin ();
+	void Queue (seg_t *seg, subsector_t *sub, sector_t *frontsector, sector_t *backsector);
+	void Flush ();
+	bool IsActive () const { return bActive; }
+
+	// These return true if the wall or missing texture was recorded by
+	// a worker thread instead of being added to the draw info right away.
+	static bool DeferWall (GLWall *wall, bool translucent);
+	static bool DeferMissingTexture (bool upper, side_t *side, subsector_t *sub, fixed_t backheight);
+
+	// Split mid textures are counted per chunk and added to render_texsplit
+	// once the workers are done.
+	static void CountTexSplit (int count);
+
+	// Guards the unique lists of sky, horizon and plane mirror information.
+	static std::mutex UniqueMutex;
+};
+
+extern FGLWallQueue gl_wallqueue;
+
+#endif
@@ -56,6 +56,7 @@
 #include "gl/dynlights/gl_lightbuffer.h"
 #include "gl/scene/gl_drawinfo.h"
 #include "gl/scene/gl_portal.h"
+#include "gl/scene/gl_wallqueue.h"
 #include "gl/textures/gl_material.h"
 #include "gl/utility/gl_clock.h"
 #include "gl/utility/gl_geometric.h"
@@ -122,6 +123,11 @@ void GLWall::PutWall(bool translucent)
 		2,		//RENDERWALL_FFBLOCK           // depends on render and texture settings
 		4,		//RENDERWALL_COLORLAYER        // color layer needs special handling
 	};
+
+	if (FGLWallQueue::DeferWall(this, translucent))
+	{
+		return;
+	}
 	
 	if (gltexture && gltexture->GetTransparent() && passflag[type] == 2)
 	{
@@ -1076,7 +1082,7 @@ void GLWall::DoMidTexture(seg_t * seg, bool drawfogboundary,
 
 				t=1;
 			}
-			render_texsplit+=t;
+			FGLWallQueue::CountTexSplit(t);
 		}
 		else
 		{
@@ -130,6 +130,14 @@ void GLWall::SetupLights()
 	{
 		return;
 	}
+
+	// These only depend on the wall's plane, not on the light.
+	Vector fn, up, right;
+	fn=p.Normal();
+	fn.GetRightUp(right, up);
+
+	int budget = gl_lights_maxpersurface;
+	int used = 0;
 	for(int i=0;i<2;i++)
 	{
 		FLightNode *node;
@@ -149,13 +157,13 @@ void GLWall::SetupLights()
 		else node = NULL;
 
 		// Iterate through all dynamic lights which touch this wall and render them
-		while (node)
+		while (node && (budget <= 0 || used < budget))
 		{
 			if (!(node->lightsource->flags2&MF2_DORMANT))
 			{
 				iter_dlight++;
 
-				Vector fn, pos;
+				Vector pos;
 
 				float x = FIXED2FLOAT(node->lightsource->x);
 				float y = FIXED2FLOAT(node->lightsource->y);
@@ -166,11 +174,9 @@ void GLWall::SetupLights()
 
 				if (radius > 0.f && dist < radius)
 				{
-					Vector nearPt, up, right;
+					Vector nearPt;
 
 					pos.Set(x,z,y);
-					fn=p.Normal();
-					fn.GetRightUp(right, up);
 
 					Vector tmpVec = fn * dist;
 					nearPt = pos + tmpVec;
@@ -195,7 +201,7 @@ void GLWall::SetupLights()
 					}
 					if (outcnt[0]!=4 && outcnt[1]!=4 && outcnt[2]!=4 && outcnt[3]!=4) 
 					{
-						gl_GetLight(p, node->lightsource, Colormap.colormap, true, false, lightdata);
+						if (gl_GetLight(p, node->lightsource, Colormap.colormap, true, false, lightdata)) used++;
 					}
 				}
 			}
@@ -545,14 +551,14 @@ void GLWall::Draw(int pass)
 			node = sub->lighthead[pass==GLPASS_LIGHT_ADDITIVE];
 		}
 		else node = NULL;
-		while (node)
+		for (int budget = gl_lights_maxpersurface, used = 0; node && (budget <= 0 || used < budget); node = node->nextLight)
 		{
 			if (!(node->lightsource->flags2&MF2_DORMANT))
 			{
 				iter_dlight++;
+				used++;
 				RenderWall(1, NULL, node->lightsource);
 			}
-			node = node->nextLight;
 		}
 		break;
 
@@ -34,11 +34,25 @@
 **
 */
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include <atomic>
+#include <zlib.h>
+
 #include "gl/system/gl_system.h"
 #include "gl/system/gl_interface.h"
 #include "gl/renderer/gl_renderer.h"
 #include "gl/textures/gl_texture.h"
 #include "c_cvars.h"
+#include "i_system.h"
+#include "m_misc.h"
+#include "cmdlib.h"
+#include "md5.h"
+#include "stats.h"
+#include "workerthreads.h"
 #include "gl/hqnx/hqx.h"
 #ifdef _MSC_VER
 #include "gl/hqnx_asm/hqnx_asm.h"
@@ -65,6 +79,26 @@ CUSTOM_CVAR(Int, gl_texture_hqresize_targets, 7, CVAR_ARCHIVE | CVAR_GLOBALCONFI
 CVAR (Flag, gl_texture_hqresize_textures, gl_texture_hqresize_targets, 1);
 CVAR (Flag, gl_texture_hqresize_sprites, gl_texture_hqresize_targets, 2);
 CVAR (Flag, gl_texture_hqresize_fonts, gl_texture_hqresize_targets, 4);
+CVAR (Bool, gl_texture_hqresize_cache, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR (Int, gl_texture_hqresize_cachesize, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// in megabytes
+
+extern long gl_frameCount;
+
+// Every scaler reads at most two source rows above and below the one it's
+// working on (scale4x is two passes of scale2x), so bands that are scaled
+// with this many extra rows come out exactly as if scaled in one go.
+#define HQRESIZE_BANDHALO		2
+#define HQRESIZE_MINBANDROWS	16
+#define HQRESIZE_MAXBANDS		16
+
+static std::mutex ResizeBandMutex;
+static std::condition_variable ResizeBandsDone;
+static int ResizeBandsRunning;
+
+static long ResizeStatFrame = -1;
+static int FrameResizes, LastFrameResizes, PeakFrameResizes;
+static double FrameResizeMS, LastFrameResizeMS;
+static unsigned int TotalResizes, CachedResizes;
 
 
 static void scale2x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight )
@@ -165,6 +199,72 @@ static void scale4x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, in
 }
 
 
+//===========================================================================
+// 
+// Runs a scaler on bands of rows on the worker threads. Each band is
+// scaled together with a few rows of its neighbours into a scratch buffer
+// and only its own rows are copied out, so the bands don't race each other.
+//
+//===========================================================================
+
+template<class T>
+static void scaleInBands ( void (*scaleNxFunction) ( T*, T*, int, int ),
+						   const int N,
+						   unsigned char *inputBuffer,
+						   unsigned char *outputBuffer,
+						   const int inWidth,
+						   const int inHeight )
+{
+	int bands = MIN ( FWorkerThreads::Get().NumThreads() + 1, inHeight / HQRESIZE_MINBANDROWS );
+	bands = MIN ( bands, HQRESIZE_MAXBANDS );
+
+	if ( bands <= 1 || FWorkerThreads::IsWorkerThread() )
+	{
+		scaleNxFunction ( reinterpret_cast<T*> ( inputBuffer ), reinterpret_cast<T*> ( outputBuffer ), inWidth, inHeight );
+		return;
+	}
+
+	const int rowsPerBand = ( inHeight + bands - 1 ) / bands;
+	const int outPitch = N * inWidth;
+
+	auto scaleBand = [=] ( int top )
+	{
+		const int bottom = MIN ( top + rowsPerBand, inHeight );
+		const int first = MAX ( top - HQRESIZE_BANDHALO, 0 );
+		const int last = MIN ( bottom + HQRESIZE_BANDHALO, inHeight );
+		T *scaled = new T[outPitch * N * ( last - first )];
+
+		scaleNxFunction ( reinterpret_cast<T*> ( inputBuffer ) + first * inWidth, scaled, inWidth, last - first );
+		memcpy ( reinterpret_cast<T*> ( outputBuffer ) + outPitch * N * top,
+			scaled + outPitch * N * ( top - first ), outPitch * N * ( bottom - top ) * sizeof(T) );
+		delete[] scaled;
+	};
+
+	ResizeBandsRunning = 0;
+	for ( int top = rowsPerBand; top < inHeight; top += rowsPerBand )
+	{
+		{
+			std::lock_guard<std::mutex> lock(ResizeBandMutex);
+			ResizeBandsRunning++;
+		}
+		FWorkerThreads::Get().SubmitUrgent([=]()
+		{
+			scaleBand ( top );
+			{
+				std::lock_guard<std::mutex> lock(ResizeBandMutex);
+				ResizeBandsRunning--;
+			}
+			ResizeBandsDone.notify_all();
+		});
+	}
+
+	scaleBand ( 0 );
+	FWorkerThreads::Get().RunUrgentJobs ();
+
+	std::unique_lock<std::mutex> lock(ResizeBandMutex);
+	ResizeBandsDone.wait(lock, [] { return ResizeBandsRunning == 0; });
+}
+
 static unsigned char *scaleNxHelper( void (*scaleNxFunction) ( uint32* , uint32* , int , int),
 							  const int N,
 							  unsigned char *inputBuffer,
@@ -177,7 +277,7 @@ static unsigned char *scaleNxHelper( void (*scaleNxFunction) ( uint32* , uint32*
 	outHeight = N *inHeight;
 	unsigned char * newBuffer = new unsigned char[outWidth*outHeight*4];
 
-	scaleNxFunction ( reinterpret_cast<uint32*> ( inputBuffer ), reinterpret_cast<uint32*> ( newBuffer ), inWidth, inHeight );
+	scaleInBands ( scaleNxFunction, N, inputBuffer, newBuffer, inWidth, inHeight );
 	delete[] inputBuffer;
 	return newBuffer;
 }
@@ -233,12 +333,155 @@ static unsigned char *hqNxHelper( void (*hqNxFunction) ( unsigned*, unsigned*, i
 	outHeight = N *inHeight;
 
 	unsigned char * newBuffer = new unsigned char[outWidth*outHeight*4];
-	hqNxFunction( reinterpret_cast<unsigned*>(inputBuffer), reinterpret_cast<unsigned*>(newBuffer), inWidth, inHeight );
+	scaleInBands( hqNxFunction, N, inputBuffer, newBuffer, inWidth, inHeight );
 	delete[] inputBuffer;
 	return newBuffer;
 }
 
 
+//===========================================================================
+// 
+// The scaled texture cache. Scaled textures are stored zlib compressed
+// under the cache path, named after a hash of the unscaled pixels and the
+// scaler used. Once the directory grows past gl_texture_hqresize_cachesize,
+// the textures that were used least recently are deleted.
+//
+//===========================================================================
+
+static std::mutex ResizeCacheMutex;
+static size_t ResizeCacheBytes;
+static bool ResizeCacheScanned;
+
+static FString GetResizeCacheDir ( bool create )
+{
+	FString path = M_GetCachePath ( create );
+	path << "/hqresize/";
+	if ( create )
+	{
+		CreatePath ( path );
+	}
+	return path;
+}
+
+static FString GetResizeCachePath ( const BYTE *hash, bool create )
+{
+	FString path = GetResizeCacheDir ( create );
+	for ( int i = 0; i < 16; ++i )
+	{
+		path.AppendFormat ( "%02x", hash[i] );
+	}
+	path << ".hqz";
+	return path;
+}
+
+static unsigned char *loadCachedResize ( const BYTE *hash, const int size )
+{
+	FString path = GetResizeCachePath ( hash, false );
+	FILE *file = fopen ( path, "rb" );
+	if ( file == NULL )
+		return NULL;
+
+	TArray<Bytef> compressed;
+	Bytef chunk[16384];
+	size_t len;
+	while ( ( len = fread ( chunk, 1, sizeof(chunk), file ) ) > 0 )
+	{
+		memcpy ( &compressed[compressed.Reserve ( (unsigned int)len )], chunk, len );
+	}
+	fclose ( file );
+
+	unsigned char *buffer = new unsigned char[size];
+	uLongf destlen = size;
+	if ( compressed.Size() == 0 || uncompress ( buffer, &destlen, &compressed[0], compressed.Size() ) != Z_OK || destlen != (uLongf)size )
+	{
+		delete[] buffer;
+		return NULL;
+	}
+	// Mark it as recently used so that trimming the cache keeps it.
+	TouchFile ( path );
+	return buffer;
+}
+
+// Compressing and writing happens on a worker thread from a copy of the
+// scaled texture, since the caller uploads and frees the original right away.
+static void storeCachedResize ( const BYTE *hash, const unsigned char *buffer, const int size )
+{
+	static std::atomic<unsigned int> tempCounter(0);
+
+	FString dir = GetResizeCacheDir ( true );
+	FString path = GetResizeCachePath ( hash, false );
+	FString temppath;
+	// The pid keeps clients that share the cache directory from writing to the same file.
+#ifdef _WIN32
+	temppath.Format ( "%s.%d-%u.tmp", path.GetChars(), _getpid(), tempCounter++ );
+#else
+	temppath.Format ( "%s.%d-%u.tmp", path.GetChars(), (int)getpid(), tempCounter++ );
+#endif
+	unsigned char *copy = new unsigned char[size];
+	memcpy ( copy, buffer, size );
+	const size_t maxbytes = (size_t)MAX<int> ( gl_texture_hqresize_cachesize, 1 ) << 20;
+
+	FWorkerThreads::Get().Submit([=]()
+	{
+		uLongf complen = compressBound ( size );
+		Bytef *compressed = new Bytef[complen];
+		bool ok = compress2 ( compressed, &complen, copy, size, Z_BEST_SPEED ) == Z_OK;
+		delete[] copy;
+
+		FILE *file = ok ? fopen ( temppath, "wb" ) : NULL;
+		if ( file != NULL )
+		{
+			ok = fwrite ( compressed, 1, complen, file ) == (size_t)complen;
+			ok = fclose ( file ) == 0 && ok;
+			if ( !ok || rename ( temppath, path ) != 0 )
+			{
+				remove ( temppath );
+				ok = false;
+			}
+		}
+		delete[] compressed;
+
+		if ( ok )
+		{
+			std::lock_guard<std::mutex> lock ( ResizeCacheMutex );
+			ResizeCacheBytes += complen;
+			if ( !ResizeCacheScanned || ResizeCacheBytes > maxbytes )
+			{
+				// Leave some room so that not every new texture causes another scan.
+				ResizeCacheBytes = TrimDirectory ( dir, ResizeCacheScanned ? maxbytes - maxbytes / 4 : maxbytes );
+				ResizeCacheScanned = true;
+			}
+		}
+	});
+}
+
+//===========================================================================
+// 
+// Counts the resizes that stalled the current frame.
+//
+//===========================================================================
+
+static void advanceResizeFrame ()
+{
+	if ( ResizeStatFrame != gl_frameCount )
+	{
+		LastFrameResizes = FrameResizes;
+		LastFrameResizeMS = FrameResizeMS;
+		FrameResizes = 0;
+		FrameResizeMS = 0;
+		ResizeStatFrame = gl_frameCount;
+	}
+}
+
+ADD_STAT(hqresize)
+{
+	FString out;
+	advanceResizeFrame ();
+	out.Format ( "Last frame: %d resizes (%.1f ms), peak = %d, total = %u, from cache = %u",
+		LastFrameResizes, LastFrameResizeMS, PeakFrameResizes, TotalResizes, CachedResizes );
+	return out;
+}
+
 //===========================================================================
 // 
 // [BB] Upsamples the texture in inputBuffer, frees inputBuffer and returns
@@ -292,30 +535,85 @@ unsigned char *gl_CreateUpsampledTextureBuffer ( const FTexture *inputTexture, u
 			type += 3;
 		}
 #endif
+		if (type <= 0)
+			return inputBuffer;
+
+		const int N = (type - 1) % 3 + 2;
+		BYTE hash[16];
+
+		if (gl_texture_hqresize_cache)
+		{
+			MD5Context md5;
+			int header[3] = { type, inWidth, inHeight };
+
+			md5.Update ( reinterpret_cast<const BYTE*> ( header ), sizeof(header) );
+			md5.Update ( inputBuffer, inWidth * inHeight * 4 );
+			md5.Final ( hash );
+
+			unsigned char *cached = loadCachedResize ( hash, N * inWidth * N * inHeight * 4 );
+			if (cached != NULL)
+			{
+				outWidth = N * inWidth;
+				outHeight = N * inHeight;
+				delete[] inputBuffer;
+				CachedResizes++;
+				return cached;
+			}
+		}
 
+		cycle_t resizeTime;
+		unsigned char *outputBuffer = NULL;
+
+		resizeTime.Reset();
+		resizeTime.Clock();
 		switch (type)
 		{
 		case 1:
-			return scaleNxHelper( &scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = scaleNxHelper( &scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 2:
-			return scaleNxHelper( &scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = scaleNxHelper( &scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 3:
-			return scaleNxHelper( &scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = scaleNxHelper( &scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 4:
-			return hqNxHelper( &hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxHelper( &hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 5:
-			return hqNxHelper( &hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxHelper( &hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 6:
-			return hqNxHelper( &hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxHelper( &hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 #ifdef _MSC_VER
 		case 7:
-			return hqNxAsmHelper( &HQnX_asm::hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxAsmHelper( &HQnX_asm::hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 8:
-			return hqNxAsmHelper( &HQnX_asm::hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxAsmHelper( &HQnX_asm::hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 9:
-			return hqNxAsmHelper( &HQnX_asm::hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxAsmHelper( &HQnX_asm::hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 #endif
 		}
+		resizeTime.Unclock();
+
+		if (outputBuffer != NULL)
+		{
+			advanceResizeFrame ();
+			FrameResizes++;
+			FrameResizeMS += resizeTime.TimeMS();
+			PeakFrameResizes = MAX ( PeakFrameResizes, FrameResizes );
+			TotalResizes++;
+
+			if (gl_texture_hqresize_cache)
+			{
+				storeCachedResize ( hash, outputBuffer, outWidth * outHeight * 4 );
+			}
+			return outputBuffer;
+		}
 	}
 	return inputBuffer;
 }
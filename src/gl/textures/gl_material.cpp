@@ -35,6 +35,8 @@
 **
 */
 
+#include <mutex>
+
 #include "gl/system/gl_system.h"
 #include "w_wad.h"
 #include "m_png.h"
@@ -47,6 +49,7 @@
 #include "templates.h"
 #include "sc_man.h"
 #include "colormatcher.h"
+#include "workerthreads.h"
 
 //#include "gl/gl_intern.h"
 
@@ -597,9 +600,15 @@ FGLTexture * FMaterial::ValidateSysTexture(FTexture * tex, bool expand)
 TArray<FMaterial *> FMaterial::mMaterials;
 int FMaterial::mMaxBound;
 
+// The wall queue creates every material its threads need before they start,
+// since creating one may read and convert the texture's pixels. The lock and
+// the published pointer only guard against lookups of half built materials.
+static std::recursive_mutex MaterialMutex;
+
 FMaterial::FMaterial(FTexture * tx, bool forceexpand)
 {
-	assert(tx->gl_info.Material == NULL);
+	assert(tx->gl_info.Material.Get() == NULL);
+	assert(!FWorkerThreads::IsWorkerThread());
 
 	bool expanded = tx->UseType == FTexture::TEX_Sprite || 
 					tx->UseType == FTexture::TEX_SkinSprite || 
@@ -665,7 +674,6 @@ FMaterial::FMaterial(FTexture * tx, bool forceexpand)
 	mTextureLayers.ShrinkToFit();
 	mMaxBound = -1;
 	mMaterials.Push(this);
-	tx->gl_info.Material = this;
 	if (tx->bHasCanvas) tx->gl_info.mIsTransparent = 0;
 	tex = tx;
 
@@ -723,6 +731,9 @@ FMaterial::FMaterial(FTexture * tx, bool forceexpand)
 			}
 		}
 	}
+	// Only published once the material is complete, since the wall queue's
+	// threads look this up without locking.
+	tx->gl_info.Material.Publish(this);
 }
 
 //===========================================================================
@@ -1047,11 +1058,15 @@ FMaterial * FMaterial::ValidateTexture(FTexture * tex)
 {
 	if (tex	&& tex->UseType!=FTexture::TEX_Null)
 	{
-		FMaterial *gltex = tex->gl_info.Material;
+		FMaterial *gltex = tex->gl_info.Material.Get();
 		if (gltex == NULL) 
 		{
-			//@sync-tex
-			gltex = new FMaterial(tex, false);
+			std::lock_guard<std::recursive_mutex> lock(MaterialMutex);
+			gltex = tex->gl_info.Material.Get();
+			if (gltex == NULL)
+			{
+				gltex = new FMaterial(tex, false);
+			}
 		}
 		return gltex;
 	}
@@ -245,7 +245,6 @@ FTexture::MiscGLInfo::MiscGLInfo() throw()
 	shaderspeed = 1.f;
 	shaderindex = 0;
 
-	Material = NULL;
 	SystemTexture = NULL;
 	Brightmap = NULL;
 	DecalTexture = NULL;
@@ -253,8 +252,8 @@ FTexture::MiscGLInfo::MiscGLInfo() throw()
 
 FTexture::MiscGLInfo::~MiscGLInfo()
 {
-	if (Material != NULL) delete Material;
-	Material = NULL;
+	if (Material.Get() != NULL) delete Material.Get();
+	Material.Publish(NULL);
 
 	if (SystemTexture != NULL) delete SystemTexture;
 	SystemTexture = NULL;
@@ -339,7 +338,7 @@ void FTexture::PrecacheGL()
 
 void FTexture::UncacheGL()
 {
-	if (gl_info.Material) gl_info.Material->Clean(true); 
+	if (gl_info.Material.Get()) gl_info.Material.Get()->Clean(true); 
 }
 
 //==========================================================================
@@ -23,6 +23,8 @@ glcycle_t All, Finish, PortalAll, Bsp;
 glcycle_t ProcessAll;
 glcycle_t RenderAll;
 glcycle_t Dirty;
+cycle_t SceneBuild, SceneSubmit, SceneWalls;
+int queued_walls, scene_threads;
 int vertexcount, flatvertices, flatprimitives;
 
 int rendered_lines,rendered_flats,rendered_sprites,render_vertexsplit,render_texsplit,rendered_decals, rendered_portals;
@@ -96,9 +98,13 @@ void ResetProfilingData()
 	SetupFlat.Reset();
 	RenderSprite.Reset();
 	SetupSprite.Reset();
+	SceneBuild.Reset();
+	SceneSubmit.Reset();
+	SceneWalls.Reset();
 
 	flatvertices=flatprimitives=vertexcount=0;
 	render_texsplit=render_vertexsplit=rendered_lines=rendered_flats=rendered_sprites=rendered_decals=rendered_portals = 0;
+	queued_walls = scene_threads = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -150,6 +156,14 @@ ADD_STAT(rendertimes)
 	return buff;
 }
 
+ADD_STAT(scenetimes)
+{
+	FString out;
+	out.Format("Scene build=%2.3f ms (walls=%2.3f ms, %d walls on %d threads), GL submit=%2.3f ms",
+		SceneBuild.TimeMS(), SceneWalls.TimeMS(), queued_walls, MAX(scene_threads, 1), SceneSubmit.TimeMS());
+	return out;
+}
+
 ADD_STAT(renderstats)
 {
 	FString out;
@@ -109,6 +109,10 @@ extern glcycle_t ProcessAll;
 extern glcycle_t RenderAll;
 extern glcycle_t Dirty;
 
+// These use the regular cycle counter, which is available everywhere.
+extern cycle_t SceneBuild, SceneSubmit, SceneWalls;
+extern int queued_walls, scene_threads;
+
 extern int iter_dlightf, iter_dlight, draw_dlight, draw_dlightf;
 extern int rendered_lines,rendered_flats,rendered_sprites,rendered_decals,render_vertexsplit,render_texsplit;
 extern int rendered_portals;
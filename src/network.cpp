@@ -67,6 +67,18 @@
 #include <ctype.h>
 #include <math.h>
 #include <list>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <process.h>
+#endif
 #include "../GeoIP/GeoIP.h"
 
 #include "c_console.h"
@@ -90,6 +102,7 @@
 #include "d_netinf.h"
 
 #include "md5.h"
+#include "m_misc.h"
 #include "network/sv_auth.h"
 #include "doomerrors.h"
 
@@ -149,6 +162,36 @@ static	TArray<const PClass*> g_ActorNetworkIndexClassPointerMap;
 // [BB]
 static GeoIP * g_GeoIPDB = NULL;
 
+// The whole GeoIP database is kept in memory, so that lookups never hit the disk. Windows
+// can't map the file, so it's read in there.
+#ifdef _WIN32
+#define	GEOIP_CACHE_FLAGS	GEOIP_MEMORY_CACHE
+#else
+#define	GEOIP_CACHE_FLAGS	GEOIP_MMAP_CACHE
+#endif
+
+// Number of addresses we remember the country of.
+#define	MAX_GEOIP_CACHE_ENTRIES		1024
+
+struct GeoIPCacheEntry
+{
+	ULONG	ulIP;
+	char	szCountryCode[4];
+
+	// Is szCountryCode valid, or is the lookup still pending?
+	bool	bResolved;
+};
+
+// Country codes of recently seen addresses, most recently used first. The lookups themselves
+// are done by a helper thread, so the cache and the queue are protected by g_GeoIPMutex.
+static	std::list<GeoIPCacheEntry>	g_GeoIPCache;
+static	std::unordered_map<ULONG, std::list<GeoIPCacheEntry>::iterator>	g_GeoIPCacheMap;
+static	std::deque<ULONG>			g_GeoIPQueue;
+static	std::mutex					g_GeoIPMutex;
+static	std::condition_variable		g_GeoIPCondition;
+static	std::thread					g_GeoIPThread;
+static	bool						g_bGeoIPThreadQuit;
+
 // [BB]
 extern int restart;
 
@@ -157,6 +200,34 @@ extern int restart;
 // already be off. So we create a special index of script names here.
 static TArray<FName> g_ACSNameIndex;
 
+// Name of the file in the cache directory that remembers the checksums of the PWADs we've loaded before.
+#define	PWAD_HASH_CACHE_FILENAME	"pwadhashes.txt"
+
+// A file is only hashed again if its size, modification time or inode changed.
+struct PWADHashCacheEntry
+{
+	FString		Path;
+	QWORD		Size;
+	QWORD		ModifiedTime;
+	QWORD		Inode;
+	FString		Checksum;
+};
+
+// Outgoing packets held back to emulate latency.
+struct DelayedPacket
+{
+	unsigned int	releaseTime;
+	NETADDRESS_s	Address;
+	TArray<BYTE>	Data;
+};
+static	std::list<DelayedPacket>	g_DelayedPackets;
+
+// Emulation of bad connections, to test how well we cope with them. This applies to all packets
+// we send, so for a local server and client pair it's enough to set this on both ends.
+CVAR( Int, net_emulatepacketloss, 0, CVAR_DEBUGONLY ) // Percentage of dropped packets.
+CVAR( Int, net_emulatelatency, 0, CVAR_DEBUGONLY ) // Delay of the packets in ms.
+CVAR( Int, net_emulatejitter, 0, CVAR_DEBUGONLY ) // Maximum random additional delay in ms.
+
 //*****************************************************************************
 //	PROTOTYPES
 
@@ -165,6 +236,14 @@ static	void			network_Error( const char *pszError );
 static	SOCKET			network_AllocateSocket( void );
 static	bool			network_BindSocketToPort( SOCKET Socket, ULONG ulInAddr, USHORT usPort, bool bReUse );
 static	bool			network_GenerateLumpMD5HashAndWarnIfNeeded( const int LumpNum, const char *LumpName, FString &MD5Hash );
+static	bool			network_EmulateConnection( const NETADDRESS_s &Address, const BYTE *pbData, int iSize );
+static	void			network_SendDelayedPackets( void );
+static	ULONG			network_GetIPKey( const NETADDRESS_s &Address );
+static	GeoIPCacheEntry	*network_FindOrRequestCountryCode( ULONG ulIP );
+static	void			network_GeoIPThread( void );
+static	bool			network_GetPWADIdentity( const char *pszPath, PWADHashCacheEntry &Entry );
+static	void			network_LoadPWADHashCache( TArray<PWADHashCacheEntry> &Cache );
+static	void			network_SavePWADHashCache( const TArray<PWADHashCacheEntry> &Cache );
 
 //*****************************************************************************
 //	FUNCTIONS
@@ -456,14 +535,23 @@ void NETWORK_Construct( USHORT usPort, bool bAllocateLANSocket )
 	{
 #ifdef __unix__
 		if ( FileExists ( "/usr/share/GeoIP/GeoIP.dat" ) )
-		  g_GeoIPDB = GeoIP_open ( "/usr/share/GeoIP/GeoIP.dat", GEOIP_STANDARD );
+		  g_GeoIPDB = GeoIP_open ( "/usr/share/GeoIP/GeoIP.dat", GEOIP_CACHE_FLAGS );
 		else if ( FileExists ( "/usr/local/share/GeoIP/GeoIP.dat" ) )
-		  g_GeoIPDB = GeoIP_open ( "/usr/local/share/GeoIP/GeoIP.dat", GEOIP_STANDARD );
+		  g_GeoIPDB = GeoIP_open ( "/usr/local/share/GeoIP/GeoIP.dat", GEOIP_CACHE_FLAGS );
 #endif
 		if ( g_GeoIPDB == NULL )
-			g_GeoIPDB = GeoIP_new ( GEOIP_STANDARD );
+			g_GeoIPDB = GeoIP_new ( GEOIP_CACHE_FLAGS );
 		if ( g_GeoIPDB != NULL )
+		{
 			Printf( "GeoIP initialized.\n" );
+
+			// Country lookups are resolved in the background.
+			if ( g_GeoIPThread.joinable( ) == false )
+			{
+				g_bGeoIPThreadQuit = false;
+				g_GeoIPThread = std::thread( network_GeoIPThread );
+			}
+		}
 		else
 			Printf( "GeoIP initialization failed.\n" );
 	}
@@ -511,6 +599,20 @@ void NETWORK_Destruct( void )
 	// Free the network message buffer.
 	g_NetworkMessage.Free();
 
+	// Stop the GeoIP thread before the database goes away.
+	if ( g_GeoIPThread.joinable( ))
+	{
+		{
+			std::lock_guard<std::mutex> lock( g_GeoIPMutex );
+			g_bGeoIPThreadQuit = true;
+		}
+		g_GeoIPCondition.notify_one( );
+		g_GeoIPThread.join( );
+	}
+	g_GeoIPQueue.clear( );
+	g_GeoIPCacheMap.clear( );
+	g_GeoIPCache.clear( );
+
 	// [BB] Delete the GeoIP database.
 	GeoIP_delete ( g_GeoIPDB );
 	g_GeoIPDB = NULL;
@@ -534,6 +636,9 @@ int NETWORK_GetPackets( void )
 	if ( g_NetworkSocket == INVALID_SOCKET )
 		return ( 0 );
 
+	if ( g_DelayedPackets.empty( ) == false )
+		network_SendDelayedPackets( );
+
 #ifdef	WIN32
 	lNumBytes = recvfrom( g_NetworkSocket, (char *)g_ucHuffmanBuffer, sizeof( g_ucHuffmanBuffer ), 0, &SocketFrom, &iSocketFromLength );
 #else
@@ -734,7 +839,11 @@ void NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address )
 		iNumBytesOut = pBuffer->ulCurrentSize;
 	}
 
-	lNumBytes = sendto( g_NetworkSocket, (const char*)g_ucHuffmanBuffer, iNumBytesOut, 0, reinterpret_cast<sockaddr*>(&SocketAddress), sizeof( SocketAddress ));
+	// If we're emulating a bad connection, the packet may be dropped or delayed instead.
+	if ( network_EmulateConnection( Address, g_ucHuffmanBuffer, iNumBytesOut ))
+		lNumBytes = iNumBytesOut;
+	else
+		lNumBytes = sendto( g_NetworkSocket, (const char*)g_ucHuffmanBuffer, iNumBytesOut, 0, reinterpret_cast<sockaddr*>(&SocketAddress), sizeof( SocketAddress ));
 
 	// If sendto returns -1, there was an error.
 	if ( lNumBytes == -1 )
@@ -787,6 +896,54 @@ return;
 		SERVER_STATISTIC_AddToOutboundDataTransfer( lNumBytes );
 }
 
+//*****************************************************************************
+//
+// Returns true if the packet was taken care of, i.e. dropped or queued to be sent later.
+static bool network_EmulateConnection( const NETADDRESS_s &Address, const BYTE *pbData, int iSize )
+{
+	if (( net_emulatepacketloss <= 0 ) && ( net_emulatelatency <= 0 ) && ( net_emulatejitter <= 0 ))
+		return ( false );
+
+	// Leave the communication with the auth server alone.
+	if ( Address.Compare( NETWORK_AUTH_GetCachedServerAddress() ))
+		return ( false );
+
+	if ( M_Random( 100 ) < net_emulatepacketloss )
+		return ( true );
+
+	const int iDelay = MAX( 0, *net_emulatelatency ) + (( net_emulatejitter > 0 ) ? M_Random( net_emulatejitter + 1 ) : 0 );
+	if ( iDelay == 0 )
+		return ( false );
+
+	DelayedPacket packet;
+	packet.releaseTime = I_MSTime( ) + iDelay;
+	packet.Address = Address;
+	packet.Data.Resize( iSize );
+	memcpy( &packet.Data[0], pbData, iSize );
+	g_DelayedPackets.push_back( packet );
+	return ( true );
+}
+
+//*****************************************************************************
+//
+static void network_SendDelayedPackets( void )
+{
+	const unsigned int now = I_MSTime( );
+
+	for ( std::list<DelayedPacket>::iterator it = g_DelayedPackets.begin( ); it != g_DelayedPackets.end( ); )
+	{
+		if ( static_cast<int>( now - it->releaseTime ) >= 0 )
+		{
+			struct sockaddr_in SocketAddress;
+			it->Address.ToSocketAddress( reinterpret_cast<sockaddr&>( SocketAddress ));
+			sendto( g_NetworkSocket, (const char*)&it->Data[0], it->Data.Size( ), 0, reinterpret_cast<sockaddr*>( &SocketAddress ), sizeof( SocketAddress ));
+			it = g_DelayedPackets.erase( it );
+		}
+		else
+			++it;
+	}
+}
+
 //*****************************************************************************
 //
 NETADDRESS_s NETWORK_GetLocalAddress( void )
@@ -951,7 +1108,8 @@ bool NETWORK_IsGeoIPAvailable ( void )
 }
 
 //*****************************************************************************
-// [BB] 
+// [BB] Never blocks. Returns an empty string if the country isn't known yet, in which case
+// it is looked up in the background.
 FString NETWORK_GetCountryCodeFromAddress( NETADDRESS_s Address )
 {
 	const char * addressString = Address.ToStringNoPort();
@@ -963,8 +1121,94 @@ FString NETWORK_GetCountryCodeFromAddress( NETADDRESS_s Address )
 	if ( g_GeoIPDB == NULL )
 		return "";
 
-	FString country = GeoIP_country_code_by_addr ( g_GeoIPDB, Address.ToStringNoPort() );
-	return country.IsEmpty() ? "N/A" : country;
+	std::lock_guard<std::mutex> lock( g_GeoIPMutex );
+	const GeoIPCacheEntry *pEntry = network_FindOrRequestCountryCode( network_GetIPKey( Address ));
+	return pEntry->bResolved ? pEntry->szCountryCode : "";
+}
+
+//*****************************************************************************
+//
+// Starts looking up the country of an address, so that it's known by the time we need it.
+void NETWORK_RequestCountryCode( NETADDRESS_s Address )
+{
+	if ( g_GeoIPDB == NULL )
+		return;
+
+	std::lock_guard<std::mutex> lock( g_GeoIPMutex );
+	network_FindOrRequestCountryCode( network_GetIPKey( Address ));
+}
+
+//*****************************************************************************
+//
+static ULONG network_GetIPKey( const NETADDRESS_s &Address )
+{
+	return (( static_cast<ULONG>( Address.abIP[0] ) << 24 ) | ( Address.abIP[1] << 16 ) | ( Address.abIP[2] << 8 ) | Address.abIP[3] );
+}
+
+//*****************************************************************************
+//
+// Must be called with g_GeoIPMutex locked.
+static GeoIPCacheEntry *network_FindOrRequestCountryCode( ULONG ulIP )
+{
+	auto it = g_GeoIPCacheMap.find( ulIP );
+	if ( it != g_GeoIPCacheMap.end( ))
+	{
+		// Move the entry to the front, so that it's the last one to be evicted.
+		g_GeoIPCache.splice( g_GeoIPCache.begin( ), g_GeoIPCache, it->second );
+		return &g_GeoIPCache.front( );
+	}
+
+	GeoIPCacheEntry Entry;
+	Entry.ulIP = ulIP;
+	Entry.szCountryCode[0] = '\0';
+	Entry.bResolved = false;
+	g_GeoIPCache.push_front( Entry );
+	g_GeoIPCacheMap[ulIP] = g_GeoIPCache.begin( );
+
+	if ( g_GeoIPCache.size( ) > MAX_GEOIP_CACHE_ENTRIES )
+	{
+		g_GeoIPCacheMap.erase( g_GeoIPCache.back( ).ulIP );
+		g_GeoIPCache.pop_back( );
+	}
+
+	g_GeoIPQueue.push_back( ulIP );
+	g_GeoIPCondition.notify_one( );
+	return &g_GeoIPCache.front( );
+}
+
+//*****************************************************************************
+//
+static void network_GeoIPThread( void )
+{
+	std::unique_lock<std::mutex> lock( g_GeoIPMutex );
+
+	while ( true )
+	{
+		g_GeoIPCondition.wait( lock, [] { return g_bGeoIPThreadQuit || ( g_GeoIPQueue.empty( ) == false ); } );
+		if ( g_bGeoIPThreadQuit )
+			return;
+
+		const ULONG ulIP = g_GeoIPQueue.front( );
+		g_GeoIPQueue.pop_front( );
+
+		// Nobody is waiting for this anymore if it has already been evicted.
+		if ( g_GeoIPCacheMap.find( ulIP ) == g_GeoIPCacheMap.end( ))
+			continue;
+
+		// The database is only ever used by this thread, so the lookup itself doesn't need the lock.
+		lock.unlock( );
+		const char *pszCountryCode = GeoIP_country_code_by_ipnum( g_GeoIPDB, ulIP );
+		lock.lock( );
+
+		auto it = g_GeoIPCacheMap.find( ulIP );
+		if ( it == g_GeoIPCacheMap.end( ))
+			continue;
+
+		const char *pszResult = (( pszCountryCode != NULL ) && ( *pszCountryCode != '\0' )) ? pszCountryCode : "N/A";
+		strncpy( it->second->szCountryCode, pszResult, sizeof( it->second->szCountryCode ) - 1 );
+		it->second->szCountryCode[sizeof( it->second->szCountryCode ) - 1] = '\0';
+		it->second->bResolved = true;
+	}
 }
 
 //*****************************************************************************
@@ -1403,6 +1647,23 @@ static void network_InitPWADList( void )
 
 	g_IWAD = Wads.GetWadName( ulRealIWADIdx );
 
+	struct HashJob
+	{
+		unsigned int	PWADIndex;
+		FString			Path;
+		char			MD5Sum[33];
+		bool			bSuccess;
+		int				Error;
+		unsigned int	Milliseconds;
+	};
+
+	TArray<PWADHashCacheEntry> cache;
+	TArray<PWADHashCacheEntry> identities;
+	TArray<HashJob> jobs;
+	const unsigned int startTime = I_MSTime( );
+
+	network_LoadPWADHashCache( cache );
+
 	// Collect all the PWADs into a list.
 	for ( ULONG ulIdx = 0; Wads.GetWadName( ulIdx ) != NULL; ulIdx++ )
 	{
@@ -1414,15 +1675,207 @@ static void network_InitPWADList( void )
 		{
 			continue;
 		}
-		char MD5Sum[33];
-		MD5SumOfFile ( Wads.GetWadFullName( ulIdx ), MD5Sum );
 
 		NetworkPWAD pwad;
 		pwad.name = Wads.GetWadName( ulIdx );
-		pwad.checksum = MD5Sum;
 		pwad.wadnum = ulIdx;
+
+		// Reuse the checksum we calculated the last time, if the file didn't change since then.
+		PWADHashCacheEntry identity;
+		const bool bHasIdentity = network_GetPWADIdentity( Wads.GetWadFullName( ulIdx ), identity );
+		for ( unsigned int i = 0; bHasIdentity && ( i < cache.Size( )); i++ )
+		{
+			if (( cache[i].Path.Compare( identity.Path ) == 0 ) && ( cache[i].Size == identity.Size )
+				&& ( cache[i].ModifiedTime == identity.ModifiedTime ) && ( cache[i].Inode == identity.Inode ))
+			{
+				pwad.checksum = cache[i].Checksum;
+				break;
+			}
+		}
+
+		if ( pwad.checksum.IsEmpty( ))
+		{
+			HashJob job;
+			job.PWADIndex = g_PWADs.Size( );
+			job.Path = Wads.GetWadFullName( ulIdx );
+			job.MD5Sum[0] = '\0';
+			job.bSuccess = false;
+			job.Error = 0;
+			job.Milliseconds = 0;
+			jobs.Push( job );
+
+			if ( bHasIdentity )
+				identities.Push( identity );
+		}
+		else
+			DPrintf( "%s: %s (cached)\n", pwad.name.GetChars( ), pwad.checksum.GetChars( ));
+
 		g_PWADs.Push( pwad );
 	}
+
+	// Hash everything that wasn't cached. Big files dominate, so the workers take the
+	// next file whenever they are done instead of splitting the list up front.
+	if ( jobs.Size( ) > 0 )
+	{
+		std::atomic<unsigned int> nextJob( 0 );
+		auto hashFiles = [&jobs, &nextJob]( )
+		{
+			for ( unsigned int i = nextJob++; i < jobs.Size( ); i = nextJob++ )
+			{
+				const auto hashStart = std::chrono::steady_clock::now( );
+				jobs[i].bSuccess = MD5SumOfFile( jobs[i].Path.GetChars( ), jobs[i].MD5Sum, true );
+				jobs[i].Error = jobs[i].bSuccess ? 0 : errno;
+				jobs[i].Milliseconds = static_cast<unsigned int>( std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now( ) - hashStart ).count( ));
+			}
+		};
+
+		const unsigned int numThreads = clamp<unsigned int>( std::thread::hardware_concurrency( ), 1, jobs.Size( ));
+		std::vector<std::thread> threads;
+		for ( unsigned int i = 1; i < numThreads; i++ )
+			threads.push_back( std::thread( hashFiles ));
+		hashFiles( );
+		for ( unsigned int i = 0; i < threads.size( ); i++ )
+			threads[i].join( );
+
+		for ( unsigned int i = 0; i < jobs.Size( ); i++ )
+		{
+			NetworkPWAD &pwad = g_PWADs[jobs[i].PWADIndex];
+
+			if ( jobs[i].bSuccess == false )
+			{
+				Printf( "%s: %s\n", jobs[i].Path.GetChars( ), strerror( jobs[i].Error ));
+				continue;
+			}
+
+			pwad.checksum = jobs[i].MD5Sum;
+			DPrintf( "%s: %s (%u ms)\n", pwad.name.GetChars( ), pwad.checksum.GetChars( ), jobs[i].Milliseconds );
+
+			// Remember the checksum for the next time.
+			for ( unsigned int j = 0; j < identities.Size( ); j++ )
+			{
+				if ( identities[j].Path.Compare( jobs[i].Path ) != 0 )
+					continue;
+
+				identities[j].Checksum = pwad.checksum;
+				for ( unsigned int k = 0; k < cache.Size( ); k++ )
+				{
+					if ( cache[k].Path.Compare( identities[j].Path ) == 0 )
+					{
+						cache.Delete( k );
+						break;
+					}
+				}
+				cache.Push( identities[j] );
+				break;
+			}
+		}
+
+		network_SavePWADHashCache( cache );
+	}
+
+	Printf( "Checksummed %u PWADs (%u cached) in %u ms.\n", g_PWADs.Size( ), g_PWADs.Size( ) - jobs.Size( ), I_MSTime( ) - startTime );
+}
+
+//*****************************************************************************
+//
+// Fills in what identifies the current contents of a file, i.e. everything but the checksum.
+static bool network_GetPWADIdentity( const char *pszPath, PWADHashCacheEntry &Entry )
+{
+	struct stat info;
+
+	if ( stat( pszPath, &info ) != 0 )
+		return false;
+
+	Entry.Path = pszPath;
+	Entry.Size = info.st_size;
+	Entry.ModifiedTime = info.st_mtime;
+	Entry.Inode = info.st_ino;
+	return true;
+}
+
+//*****************************************************************************
+//
+// Each line of the cache is "<checksum> <size> <mtime> <inode> <path>".
+static void network_LoadPWADHashCache( TArray<PWADHashCacheEntry> &Cache )
+{
+	FString path = M_GetCachePath( false );
+	path << "/" PWAD_HASH_CACHE_FILENAME;
+
+	FILE *file = fopen( path, "r" );
+	if ( file == NULL )
+		return;
+
+	char line[4096];
+	while ( fgets( line, sizeof( line ), file ) != NULL )
+	{
+		PWADHashCacheEntry entry;
+		char checksum[33];
+		unsigned long long size, modifiedTime, inode;
+		int pathOffset = 0;
+
+		if (( sscanf( line, "%32s %llu %llu %llu %n", checksum, &size, &modifiedTime, &inode, &pathOffset ) != 4 ) || ( pathOffset == 0 ))
+			continue;
+
+		entry.Path = line + pathOffset;
+		entry.Path.StripRight( "\r\n" );
+		if ( entry.Path.IsEmpty( ) || ( strlen( checksum ) != 32 ))
+			continue;
+
+		entry.Checksum = checksum;
+		entry.Size = size;
+		entry.ModifiedTime = modifiedTime;
+		entry.Inode = inode;
+		Cache.Push( entry );
+	}
+
+	fclose( file );
+}
+
+//*****************************************************************************
+//
+// Entries of files that are gone or changed since they were hashed are dropped, so that
+// the cache doesn't keep every PWAD that was ever loaded.
+static void network_SavePWADHashCache( const TArray<PWADHashCacheEntry> &Cache )
+{
+	FString path = M_GetCachePath( true );
+	path << "/" PWAD_HASH_CACHE_FILENAME;
+
+	// Write to a temporary file first, a crash or another instance saving at the same
+	// time must never leave a truncated cache behind that is trusted afterwards.
+	FString tempPath;
+#ifdef _WIN32
+	tempPath.Format( "%s.%d.tmp", path.GetChars( ), _getpid( ));
+#else
+	tempPath.Format( "%s.%d.tmp", path.GetChars( ), static_cast<int>( getpid( )));
+#endif
+
+	FILE *file = fopen( tempPath, "w" );
+	if ( file == NULL )
+		return;
+
+	bool ok = true;
+	for ( unsigned int i = 0; i < Cache.Size( ); i++ )
+	{
+		PWADHashCacheEntry identity;
+		if (( network_GetPWADIdentity( Cache[i].Path, identity ) == false ) || ( identity.Size != Cache[i].Size )
+			|| ( identity.ModifiedTime != Cache[i].ModifiedTime ) || ( identity.Inode != Cache[i].Inode ))
+			continue;
+
+		if ( fprintf( file, "%s %llu %llu %llu %s\n", Cache[i].Checksum.GetChars( ), static_cast<unsigned long long>( Cache[i].Size ),
+			static_cast<unsigned long long>( Cache[i].ModifiedTime ), static_cast<unsigned long long>( Cache[i].Inode ), Cache[i].Path.GetChars( )) < 0 )
+			ok = false;
+	}
+
+	ok = ( fclose( file ) == 0 ) && ok;
+
+	// rename replaces the old file atomically on POSIX systems, Windows refuses to
+	// rename over an existing file.
+#ifdef _WIN32
+	if ( ok )
+		remove( path );
+#endif
+	if (( ok == false ) || ( rename( tempPath, path ) != 0 ))
+		remove( tempPath );
 }
 
 void network_Error( const char *pszError )
@@ -1480,38 +1933,33 @@ extern int	stdin_ready;
 extern int	do_stdin;
 #endif
 
-// [BB] We only need this for the server console input under Linux.
-void I_DoSelect (void)
-{
-#ifdef		WIN32
-/*
-    struct timeval   timeout;
-    fd_set           fdset;
-
-    FD_ZERO(&fdset);
-    FD_SET(g_NetworkSocket, &fdset);
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
-    if (select (static_cast<int>(g_NetworkSocket)+1, &fdset, NULL, NULL, &timeout) == -1)
-        return;
-*/
-#else
-    struct timeval   timeout;
-    fd_set           fdset;
+// Waits up to ulTimeoutUS microseconds for a packet on the game socket and,
+// under Linux, for server console input. Returns true if a packet is waiting.
+bool I_DoSelect( ULONG ulTimeoutUS )
+{
+	struct timeval	timeout;
+	fd_set			fdset;
 
-    FD_ZERO(&fdset);
-    if (do_stdin)
-    	FD_SET(0, &fdset);
+	FD_ZERO( &fdset );
+	FD_SET( g_NetworkSocket, &fdset );
+#ifndef	WIN32
+	// Once input is waiting, leave stdin out until it is read, or select
+	// would return right away until the next tic.
+	if ( do_stdin && ( stdin_ready == 0 ))
+		FD_SET( 0, &fdset );
+#endif
 
-    FD_SET(g_NetworkSocket, &fdset);
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
-    if (select (static_cast<int>(g_NetworkSocket)+1, &fdset, NULL, NULL, &timeout) == -1)
-        return;
+	timeout.tv_sec = ulTimeoutUS / 1000000;
+	timeout.tv_usec = ulTimeoutUS % 1000000;
+	if ( select( static_cast<int>( g_NetworkSocket ) + 1, &fdset, NULL, NULL, &timeout ) <= 0 )
+		return ( false );
 
-    stdin_ready = FD_ISSET(0, &fdset);
+#ifndef	WIN32
+	if ( do_stdin && FD_ISSET( 0, &fdset ))
+		stdin_ready = 1;
 #endif
-} 
+	return ( FD_ISSET( g_NetworkSocket, &fdset ) != 0 );
+}
 
 //*****************************************************************************
 // [BB] Let Skulltag's existing code use ZDoom's MD5 code.
@@ -234,6 +234,7 @@ NETBUFFER_s		*NETWORK_GetNetworkMessageBuffer( void );
 USHORT			NETWORK_ntohs( ULONG ul );
 bool			NETWORK_IsGeoIPAvailable( void );
 FString			NETWORK_GetCountryCodeFromAddress( NETADDRESS_s Address );
+void			NETWORK_RequestCountryCode( NETADDRESS_s Address );
 USHORT			NETWORK_GetLocalPort( void );
 
 // [TP] Now a struct
@@ -297,7 +298,7 @@ float			NETWORK_AttenuationIntToFloat ( const int iAttenuation );
 LONG			NETWORK_GetState( void );
 void			NETWORK_SetState( LONG lState );
 
-void			I_DoSelect( void );
+bool			I_DoSelect( ULONG ulTimeoutUS );
 
 // DEBUG FUNCTION!
 #ifdef	_DEBUG
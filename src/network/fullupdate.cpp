@@ -0,0 +1,192 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Zandronum Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: fullupdate.cpp
+//
+// Description: Shares the actor part of the full update between clients that join during the same tic
+//
+//-----------------------------------------------------------------------------
+
+#include "fullupdate.h"
+#include "c_cvars.h"
+#include "doomstat.h"
+#include "network.h"
+#include "stats.h"
+#include "sv_main.h"
+
+//*****************************************************************************
+//	VARIABLES
+
+// A command written to the client while the actor snapshot was generated.
+struct CAPTUREDCOMMAND_s
+{
+	// Where the command starts within g_SnapshotData.
+	unsigned int	uiOffset;
+
+	// Size of the command in bytes.
+	unsigned int	uiSize;
+
+	// Was the command sent through the unreliable packet buffer?
+	bool			bUnreliable;
+};
+
+// The raw commands of the last generated actor snapshot.
+static	TArray<BYTE>				g_SnapshotData;
+static	TArray<CAPTUREDCOMMAND_s>	g_SnapshotCommands;
+
+// The snapshot may only be replayed in the tic it was generated in, and only as long
+// as nothing was broadcasted since then.
+static	int							g_SnapshotGametic = -1;
+static	bool						g_bSnapshotValid = false;
+
+// The client the snapshot is currently generated for, MAXPLAYERS if we aren't capturing.
+static	ULONG						g_ulCaptureClient = MAXPLAYERS;
+
+// Did something happen during the capture that makes the snapshot unusable for others?
+static	bool						g_bCaptureTainted = false;
+
+static	ULONG						g_ulNumSnapshotsGenerated = 0;
+static	ULONG						g_ulNumSnapshotsReplayed = 0;
+
+CVAR( Bool, sv_sharefullupdates, true, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+//*****************************************************************************
+//	FUNCTIONS
+
+bool FULLUPDATE_ReplayActorSnapshot( ULONG ulClient )
+{
+	CLIENT_s	*pClient;
+
+	if (( sv_sharefullupdates == false ) || ( g_bSnapshotValid == false ) || ( g_SnapshotGametic != gametic ))
+		return ( false );
+
+	pClient = SERVER_GetClient( ulClient );
+	if ( pClient == NULL )
+		return ( false );
+
+	// Write the commands exactly like NetCommand::sendCommandToOneClient would have, so
+	// that the packets are split at the same positions.
+	for ( unsigned int i = 0; i < g_SnapshotCommands.Size( ); ++i )
+	{
+		const CAPTUREDCOMMAND_s &command = g_SnapshotCommands[i];
+
+		SERVER_CheckClientBuffer( ulClient, command.uiSize, command.bUnreliable == false );
+
+		NETBUFFER_s &buffer = command.bUnreliable ? pClient->UnreliablePacketBuffer : pClient->PacketBuffer;
+		buffer.ByteStream.WriteBuffer( &g_SnapshotData[command.uiOffset], command.uiSize );
+	}
+
+	g_ulNumSnapshotsReplayed++;
+	return ( true );
+}
+
+//*****************************************************************************
+//
+void FULLUPDATE_BeginCapture( ULONG ulClient )
+{
+	g_SnapshotData.Clear( );
+	g_SnapshotCommands.Clear( );
+	g_bSnapshotValid = false;
+	g_bCaptureTainted = false;
+	g_ulCaptureClient = ulClient;
+}
+
+//*****************************************************************************
+//
+void FULLUPDATE_EndCapture( void )
+{
+	g_bSnapshotValid = ( g_bCaptureTainted == false ) && sv_sharefullupdates;
+	g_SnapshotGametic = gametic;
+	g_ulCaptureClient = MAXPLAYERS;
+	g_ulNumSnapshotsGenerated++;
+}
+
+//*****************************************************************************
+//
+void FULLUPDATE_NoteCommand( ULONG ulClient, const NETBUFFER_s &Command, bool bUnreliable )
+{
+	if ( g_ulCaptureClient != MAXPLAYERS )
+	{
+		// Anything that goes to somebody else while we capture can't be part of the snapshot.
+		if ( ulClient != g_ulCaptureClient )
+		{
+			g_bCaptureTainted = true;
+			return;
+		}
+
+		CAPTUREDCOMMAND_s command;
+		command.uiOffset = g_SnapshotData.Size( );
+		command.uiSize = Command.CalcSize( );
+		command.bUnreliable = bUnreliable;
+
+		g_SnapshotData.Resize( command.uiOffset + command.uiSize );
+		memcpy( &g_SnapshotData[command.uiOffset], Command.pbData, command.uiSize );
+		g_SnapshotCommands.Push( command );
+	}
+	// A reliable command to anybody but the client we are currently dealing with means
+	// that the world possibly changed since the snapshot was generated.
+	else if (( bUnreliable == false ) && ( static_cast<LONG>( ulClient ) != SERVER_GetCurrentClient( )))
+	{
+		g_bSnapshotValid = false;
+	}
+}
+
+//*****************************************************************************
+//
+void FULLUPDATE_Invalidate( void )
+{
+	g_bSnapshotValid = false;
+
+	if ( g_ulCaptureClient != MAXPLAYERS )
+		g_bCaptureTainted = true;
+}
+
+//*****************************************************************************
+//
+ADD_STAT( fullupdate )
+{
+	FString	out;
+
+	out.Format( "Actor snapshots generated: %lu, shared: %lu, size: %u bytes in %u commands",
+		g_ulNumSnapshotsGenerated, g_ulNumSnapshotsReplayed, g_SnapshotData.Size( ), g_SnapshotCommands.Size( ));
+	return ( out );
+}
@@ -47,6 +47,8 @@
 //-----------------------------------------------------------------------------
 
 #include "netcommand.h"
+#include "fullupdate.h"
+#include "sv_profile.h"
 
 //*****************************************************************************
 //
@@ -277,6 +279,13 @@ BYTESTREAM_s& NetCommand::getBytestreamForClient( ULONG i ) const
 //
 void NetCommand::sendCommandToClients ( ULONG ulPlayerExtra, ServerCommandFlags flags )
 {
+	FServerProfileScope profile( SPP_COMMANDS );
+
+	// Reliable broadcasts tell the clients that the world changed, so a shared full
+	// update generated before this is outdated.
+	if (( _unreliable == false ) && (( flags & SVCF_ONLYTHISCLIENT ) == false ))
+		FULLUPDATE_Invalidate( );
+
 	for ( ClientIterator it ( ulPlayerExtra, flags ); it.notAtEnd(); ++it )
 		sendCommandToOneClient( *it );
 }
@@ -300,6 +309,7 @@ void NetCommand::sendCommandToOneClient( ULONG i )
 	}
 
 	writeCommandToStream( getBytestreamForClient( i ));
+	FULLUPDATE_NoteCommand( i, _buffer, _unreliable );
 }
 
 //*****************************************************************************
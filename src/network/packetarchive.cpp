@@ -51,8 +51,26 @@
 #include "../sv_main.h"
 #include "../network.h"
 #include "../network_enums.h" 
+#include "i_system.h"
 #include "packetarchive.h"
 
+// The client only buffers the last 256 packets it received (see g_bPacketNum in cl_main.cpp),
+// so a client that acknowledges packets never gets more than this many unacknowledged ones.
+// This is also well below PACKET_BUFFER_SIZE, so we always still have the packets in flight.
+static const unsigned int MAX_PACKETS_IN_FLIGHT = 192;
+
+// A hole in the acknowledged packets is considered lost once this many later packets arrived.
+static const unsigned int FAST_RETRANSMIT_THRESHOLD = 3;
+
+// Bounds of the retransmission timeout (in ms).
+static const int MIN_RETRANSMIT_TIMEOUT = 100;
+static const int MAX_RETRANSMIT_TIMEOUT = 2000;
+
+// Bounds of the congestion controlled sending rate (in bytes per second). The rate never drops
+// below what a busy game needs, it only limits how quickly backlogs like full updates are sent.
+static const int MIN_PACING_RATE = 32 * KILOBYTE;
+static const int MAX_PACING_RATE = 8192 * KILOBYTE;
+
 //*****************************************************************************
 //
 PacketArchive::PacketArchive() :
@@ -178,12 +196,36 @@ CUSTOM_CVAR( Int, sv_maxpacketspertick, 64, CVAR_ARCHIVE )
 	}
 }
 
+//*****************************************************************************
+//
+// Maximum bandwidth (in KB/s) used per client, 0 means no fixed limit. This mostly affects
+// full updates, since during normal game play the traffic to a client is far below any sane
+// limit. With sv_selectiveack, the congestion control paces clients that acknowledge their
+// packets at 32 to 8192 KB/s on top of this, so with 0 only that pacing is left.
+CUSTOM_CVAR( Int, sv_maxclientbandwidth, 0, CVAR_ARCHIVE )
+{
+	if ( self < 0 )
+	{
+		Printf( "sv_maxclientbandwidth can't be negative.\n" );
+		self = 0;
+	}
+}
+
+//*****************************************************************************
+//
+// Whether the packet acknowledgements of the clients are used to measure the round trip time,
+// resend lost packets and adapt the sending rate. If disabled, only the packets the clients
+// report as missing are resent.
+CVAR( Bool, sv_selectiveack, true, CVAR_ARCHIVE )
+
 //*****************************************************************************
 //
 OutgoingPacketBuffer::OutgoingPacketBuffer ( )
 {
 	_packetsSentThisTick = 0;
 	_clientIdx = MAXPLAYERS;
+	_bandwidthTokens = 0;
+	ResetTransmissionState();
 }
 
 //*****************************************************************************
@@ -193,11 +235,66 @@ void OutgoingPacketBuffer::SetClientIndex ( const unsigned int ClientIdx )
 	_clientIdx = ClientIdx;
 }
 
+//*****************************************************************************
+//
+bool OutgoingPacketBuffer::CanSendUnsentPacket ( ) const
+{
+	if ( _packetsSentThisTick >= static_cast<unsigned int> ( sv_maxpacketspertick ) )
+		return false;
+
+	// A packet may overdraw the bucket, otherwise packets bigger than the tokens
+	// refilled per tic would never be sent. The debt is paid by the next refills.
+	if ( ( GetBandwidthLimit() > 0 ) && ( _bandwidthTokens <= 0 ) )
+		return false;
+
+	if ( _selectiveAck && ( GetPacketsInFlight() >= MAX_PACKETS_IN_FLIGHT ) )
+		return false;
+
+	return true;
+}
+
+//*****************************************************************************
+//
+// Returns the bandwidth (in bytes per second) available to this client, or zero if unlimited.
+// Clients that acknowledge their packets are always paced, even if sv_maxclientbandwidth is 0.
+int OutgoingPacketBuffer::GetBandwidthLimit ( ) const
+{
+	if ( _selectiveAck )
+		return ( sv_maxclientbandwidth > 0 ) ? MIN ( _pacingRate, sv_maxclientbandwidth * KILOBYTE ) : _pacingRate;
+
+	return sv_maxclientbandwidth * KILOBYTE;
+}
+
+//*****************************************************************************
+//
+unsigned int OutgoingPacketBuffer::GetPacketsInFlight ( ) const
+{
+	return GetNextSequenceNumber() - _firstUnacknowledged;
+}
+
+//*****************************************************************************
+//
+void OutgoingPacketBuffer::RefillBandwidthTokens ( )
+{
+	const int bandwidthLimit = GetBandwidthLimit();
+
+	if ( bandwidthLimit <= 0 )
+	{
+		_bandwidthTokens = 0;
+		return;
+	}
+
+	const int tokensPerTick = MAX ( 1, bandwidthLimit / TICRATE );
+
+	// Allow bursts of up to a quarter of a second.
+	_bandwidthTokens = MIN ( _bandwidthTokens + tokensPerTick, MAX ( tokensPerTick * TICRATE / 4, static_cast<int> ( SERVER_GetMaxPacketSize( ) ) ) );
+}
+
 //*****************************************************************************
 //
 void OutgoingPacketBuffer::ScheduleUnsentPacket ( const NETBUFFER_s &Packet )
 {
-	if ( ( _unsentPackets.Size () == 0 ) && ( _packetsSentThisTick < static_cast<unsigned int> ( sv_maxpacketspertick ) ) )
+	if ( ( _unsentPackets.Size () == 0 ) && CanSendUnsentPacket() )
 	{
 		++_packetsSentThisTick;
 		const int packetNumber = this->StorePacket ( Packet );
@@ -211,7 +308,7 @@ void OutgoingPacketBuffer::ScheduleUnsentPacket ( const NETBUFFER_s &Packet )
 
 //*****************************************************************************
 //
-bool OutgoingPacketBuffer::SendPacket( unsigned int packetNumber, const NETADDRESS_s &Address ) const
+bool OutgoingPacketBuffer::SendPacket( unsigned int packetNumber, const NETADDRESS_s &Address )
 {
 	// Find the packet from the saved packet archive.
 	const BYTE* packetData;
@@ -232,13 +329,81 @@ bool OutgoingPacketBuffer::SendPacket( unsigned int packetNumber, const NETADDRE
 		TempBuffer.ByteStream.WriteBuffer( packetData, packetSize );
 	NETWORK_LaunchPacket( &TempBuffer, Address );
 	TempBuffer.Free();
+	NoteTransmission( packetNumber );
+
+	// Retransmissions aren't delayed by the bandwidth limit, but they still use up bandwidth.
+	if ( GetBandwidthLimit() > 0 )
+		_bandwidthTokens -= static_cast<int> ( packetSize ) + 5;
 	return true;
 }
 
+//*****************************************************************************
+//
+void OutgoingPacketBuffer::NoteTransmission ( unsigned int packetNumber )
+{
+	TransmissionRecord &record = _transmissions[packetNumber % PACKET_BUFFER_SIZE];
+
+	if ( record.sequenceNumber == packetNumber )
+	{
+		record.retransmitted = true;
+		++_numRetransmissions;
+	}
+	else
+	{
+		record.sequenceNumber = packetNumber;
+		record.retransmitted = false;
+		record.acknowledged = false;
+	}
+
+	record.lastTransmitTime = I_MSTime();
+}
+
+//*****************************************************************************
+//
+// Checks whether the packet was already acknowledged or (re)sent so recently that it can't
+// have arrived yet. Either way, sending it again right now would only waste bandwidth.
+bool OutgoingPacketBuffer::WasTransmittedRecently ( unsigned int packetNumber, unsigned int now ) const
+{
+	const TransmissionRecord &record = _transmissions[packetNumber % PACKET_BUFFER_SIZE];
+
+	if ( record.sequenceNumber != packetNumber )
+		return false;
+
+	if ( record.acknowledged )
+		return true;
+
+	// Give a retransmission the full timeout, it may have been delayed by the same congestion.
+	const int timeout = record.retransmitted ? _retransmitTimeout : _smoothedRTT;
+	return ( static_cast<int> ( now - record.lastTransmitTime ) < timeout );
+}
+
+//*****************************************************************************
+//
+void OutgoingPacketBuffer::ScheduleRetransmission ( unsigned int packetNumber )
+{
+	for ( unsigned int i = 0; i < _scheduledPacketIndices.Size(); ++i )
+	{
+		if ( _scheduledPacketIndices[i] == packetNumber )
+			return;
+	}
+
+	_scheduledPacketIndices.Push( packetNumber );
+}
+
 //*****************************************************************************
 //
 bool OutgoingPacketBuffer::SchedulePacket ( unsigned int packetNumber )
 {
+	// If the client acknowledges its packets, we already resend lost packets on our own
+	// and there's no point in following requests for packets that are still on their way.
+	if ( _selectiveAck && WasTransmittedRecently( packetNumber, I_MSTime() ) )
+	{
+		++_numSuppressedRequests;
+		const BYTE* packetData;
+		size_t packetSize;
+		return this->FindPacket( packetNumber, packetData, packetSize );
+	}
+
 	if ( ( _scheduledPacketIndices.Size() == 0 ) && ( _packetsSentThisTick < static_cast<unsigned int> ( sv_maxpacketspertick ) ) )
 	{
 		++_packetsSentThisTick;
@@ -267,11 +432,39 @@ void OutgoingPacketBuffer::Clear ( )
 {
 	PacketArchive::Clear();
 	ClearScheduling();
+	ResetTransmissionState();
+	_pacingRate = ( sv_maxclientbandwidth > 0 ) ? clamp<int> ( sv_maxclientbandwidth * KILOBYTE, MIN_PACING_RATE, MAX_PACING_RATE ) : MAX_PACING_RATE;
+
+	_bandwidthTokens = 0;
+	RefillBandwidthTokens();
 	for ( unsigned int i = 0; i < _unsentPackets.Size(); ++i )
 		_unsentPackets[i].Free();
 	_unsentPackets.Clear();
 }
 
+//*****************************************************************************
+//
+void OutgoingPacketBuffer::ResetTransmissionState ( )
+{
+	for ( unsigned int i = 0; i < countof( _transmissions ); ++i )
+	{
+		_transmissions[i].sequenceNumber = UINT_MAX;
+		_transmissions[i].lastTransmitTime = 0;
+		_transmissions[i].retransmitted = _transmissions[i].acknowledged = false;
+	}
+
+	_selectiveAck = false;
+	_firstUnacknowledged = 0;
+	_hasRTTSample = false;
+	_smoothedRTT = 0;
+	_RTTVariation = 0;
+	_retransmitTimeout = MAX_RETRANSMIT_TIMEOUT / 2;
+	_pacingRate = MAX_PACING_RATE;
+	_lastRateDecreaseTime = 0;
+	_numRetransmissions = 0;
+	_numSuppressedRequests = 0;
+}
+
 //*****************************************************************************
 //
 void OutgoingPacketBuffer::ForceSendAll()
@@ -296,6 +489,9 @@ void OutgoingPacketBuffer::ForceSendAll()
 //
 void OutgoingPacketBuffer::Tick ( )
 {
+	RefillBandwidthTokens();
+	CheckRetransmitTimeout();
+
 	{
 		const int packetsToSend = MIN ( sv_maxpacketspertick - static_cast<int> ( _packetsSentThisTick ), static_cast<int> ( _scheduledPacketIndices.Size () ) );
 		for ( int i = 0; i < packetsToSend; ++i )
@@ -311,16 +507,178 @@ void OutgoingPacketBuffer::Tick ( )
 	}
 
 	{
-		const int unsentPacketsToSend = MIN ( sv_maxpacketspertick - static_cast<int> ( _packetsSentThisTick ), static_cast<int> ( _unsentPackets.Size () ) );
-		for ( int i = 0; i < unsentPacketsToSend; ++i )
+		unsigned int unsentPacketsSent = 0;
+		while ( ( unsentPacketsSent < _unsentPackets.Size () ) && CanSendUnsentPacket() )
 		{
 			++_packetsSentThisTick;
-			const int packetNumber = this->StorePacket ( _unsentPackets[i] );
+			const int packetNumber = this->StorePacket ( _unsentPackets[unsentPacketsSent] );
 			SendPacket ( packetNumber, SERVER_GetClient( _clientIdx )->Address );
-			_unsentPackets[i].Free ();
+			_unsentPackets[unsentPacketsSent].Free ();
+			++unsentPacketsSent;
 		}
-		_unsentPackets.Delete( 0, unsentPacketsToSend );
+		_unsentPackets.Delete( 0, unsentPacketsSent );
 	}
 
 	_packetsSentThisTick = 0;
 }
+
+//*****************************************************************************
+//
+// If the oldest packet in flight wasn't acknowledged within the retransmission timeout,
+// resend it. This also recovers from losing the last packets of a burst, which the client
+// can't notice on its own.
+void OutgoingPacketBuffer::CheckRetransmitTimeout ( )
+{
+	if ( ( _selectiveAck == false ) || ( GetPacketsInFlight() == 0 ) )
+		return;
+
+	const TransmissionRecord &record = _transmissions[_firstUnacknowledged % PACKET_BUFFER_SIZE];
+	const unsigned int now = I_MSTime();
+
+	if ( ( record.sequenceNumber != _firstUnacknowledged ) || record.acknowledged )
+		return;
+
+	if ( static_cast<int> ( now - record.lastTransmitTime ) < _retransmitTimeout )
+		return;
+
+	ScheduleRetransmission( _firstUnacknowledged );
+	DecreaseRate( now );
+
+	// Back off until we get a new round trip time sample.
+	_retransmitTimeout = MIN ( _retransmitTimeout * 2, MAX_RETRANSMIT_TIMEOUT );
+}
+
+//*****************************************************************************
+//
+bool OutgoingPacketBuffer::MarkAcknowledged ( unsigned int packetNumber, unsigned int now, int &RTTSample )
+{
+	TransmissionRecord &record = _transmissions[packetNumber % PACKET_BUFFER_SIZE];
+
+	if ( ( record.sequenceNumber != packetNumber ) || record.acknowledged )
+		return false;
+
+	record.acknowledged = true;
+
+	// Karn's algorithm: We can't tell which transmission a retransmitted packet's
+	// acknowledgement belongs to, so these don't give us a round trip time sample.
+	if ( record.retransmitted == false )
+		RTTSample = static_cast<int> ( now - record.lastTransmitTime );
+
+	return true;
+}
+
+//*****************************************************************************
+//
+void OutgoingPacketBuffer::UpdateRTT ( int RTTSample )
+{
+	if ( _hasRTTSample == false )
+	{
+		_smoothedRTT = RTTSample;
+		_RTTVariation = RTTSample / 2;
+		_hasRTTSample = true;
+	}
+	else
+	{
+		_RTTVariation = ( 3 * _RTTVariation + abs ( _smoothedRTT - RTTSample ) ) / 4;
+		_smoothedRTT = ( 7 * _smoothedRTT + RTTSample ) / 8;
+	}
+
+	// The client acknowledges once per tic, so the clock granularity is a tic.
+	_retransmitTimeout = clamp<int> ( _smoothedRTT + MAX ( 1000 / TICRATE, 4 * _RTTVariation ), MIN_RETRANSMIT_TIMEOUT, MAX_RETRANSMIT_TIMEOUT );
+}
+
+//*****************************************************************************
+//
+void OutgoingPacketBuffer::DecreaseRate ( unsigned int now )
+{
+	// React at most once per round trip, all losses within it belong to the same congestion event.
+	if ( static_cast<int> ( now - _lastRateDecreaseTime ) < MAX ( _smoothedRTT, 1000 / TICRATE ) )
+		return;
+
+	_pacingRate = MAX ( _pacingRate / 2, MIN_PACING_RATE );
+	_lastRateDecreaseTime = now;
+}
+
+//*****************************************************************************
+//
+// The client tells us the last packet it received without any gaps before it and which of
+// the 32 packets following the first missing one it received as well.
+void OutgoingPacketBuffer::AcknowledgePackets ( int lastContiguousPacket, unsigned int receivedMask )
+{
+	const unsigned int nextSequenceNumber = GetNextSequenceNumber();
+
+	// The client may still acknowledge packets from before we cleared our archive.
+	if ( ( lastContiguousPacket < -1 ) || ( lastContiguousPacket >= static_cast<int> ( nextSequenceNumber ) ) )
+		return;
+
+	const unsigned int now = I_MSTime();
+	const unsigned int firstMissing = static_cast<unsigned int> ( lastContiguousPacket + 1 );
+	int RTTSample = -1;
+	bool acknowledgedNewPackets = false;
+
+	_selectiveAck = true;
+
+	// Everything up to the first missing packet arrived. We don't have records of packets
+	// older than our archive, so there's no need to look at those.
+	if ( firstMissing > _firstUnacknowledged )
+	{
+		for ( unsigned int packet = MAX ( _firstUnacknowledged, firstMissing - MIN<unsigned int> ( firstMissing, PACKET_BUFFER_SIZE ) ); packet < firstMissing; ++packet )
+			acknowledgedNewPackets |= MarkAcknowledged( packet, now, RTTSample );
+
+		_firstUnacknowledged = firstMissing;
+	}
+
+	// Process the selectively acknowledged packets, counting from the highest one down, so that we
+	// know how many later packets arrived when we encounter a gap.
+	unsigned int packetsReceivedAfter = 0;
+	bool lossDetected = false;
+
+	for ( int bit = 31; bit >= -1; --bit )
+	{
+		const unsigned int packet = firstMissing + 1 + bit;
+
+		if ( ( packet < _firstUnacknowledged ) || ( packet >= nextSequenceNumber ) )
+			continue;
+
+		if ( ( bit >= 0 ) && ( receivedMask & ( 1u << bit ) ) )
+		{
+			acknowledgedNewPackets |= MarkAcknowledged( packet, now, RTTSample );
+			++packetsReceivedAfter;
+		}
+		else if ( packetsReceivedAfter >= FAST_RETRANSMIT_THRESHOLD )
+		{
+			lossDetected = true;
+
+			if ( WasTransmittedRecently( packet, now ) == false )
+				ScheduleRetransmission( packet );
+		}
+	}
+
+	if ( RTTSample >= 0 )
+		UpdateRTT( RTTSample );
+
+	// Additive increase, multiplicative decrease.
+	if ( lossDetected )
+		DecreaseRate( now );
+	else if ( acknowledgedNewPackets )
+		_pacingRate = MIN ( _pacingRate + KILOBYTE, MAX_PACING_RATE );
+}
+
+//*****************************************************************************
+//
+void OutgoingPacketBuffer::PrintStatistics ( ) const
+{
+	if ( _selectiveAck == false )
+	{
+		Printf( "no acknowledgements, %u retransmissions\n", _numRetransmissions );
+		return;
+	}
+
+	// The bandwidth-delay product is the amount of data that can be on its way to the client.
+	const int bandwidthDelayProduct = static_cast<int> ( static_cast<SQWORD> ( _pacingRate ) * _smoothedRTT / 1000 );
+
+	Printf( "srtt %d ms, rttvar %d ms, rto %d ms, rate %d KB/s, bdp %d bytes, in flight %u, "
+		"%u retransmissions, %u redundant requests\n",
+		_smoothedRTT, _RTTVariation, _retransmitTimeout, _pacingRate / KILOBYTE, bandwidthDelayProduct,
+		GetPacketsInFlight(), _numRetransmissions, _numSuppressedRequests );
+}
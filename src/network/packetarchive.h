@@ -62,6 +62,7 @@ public:
 	void Clear();
 	unsigned int StorePacket( const NETBUFFER_s& packet );
 	bool FindPacket( unsigned int packetNumber, const BYTE*& data, size_t& size ) const;
+	unsigned int GetNextSequenceNumber( ) const { return _sequenceNumber; }
 
 private:
 	struct Record
@@ -97,8 +98,52 @@ class OutgoingPacketBuffer : public PacketArchive
 	unsigned int _clientIdx;
 	TArray<unsigned int> _scheduledPacketIndices;
 	TArray<NETBUFFER_s> _unsentPackets;
+	// Token bucket (in bytes) limiting the bandwidth used to send out the backlog.
+	int _bandwidthTokens;
+
+	// Per packet transmission state used for selective acknowledgements.
+	struct TransmissionRecord
+	{
+		unsigned int sequenceNumber;
+		unsigned int lastTransmitTime; // I_MSTime of the last (re)transmission.
+		bool retransmitted;
+		bool acknowledged;
+	};
+	TransmissionRecord _transmissions[PACKET_BUFFER_SIZE];
+
+	// Set once the client acknowledged any packet. Clients that never do only
+	// get the packets they explicitly report as missing resent.
+	bool _selectiveAck;
+	// Lowest sequence number not acknowledged by the client yet.
+	unsigned int _firstUnacknowledged;
+
+	// Round trip time estimation (in ms) as described in RFC 6298.
+	bool _hasRTTSample;
+	int _smoothedRTT;
+	int _RTTVariation;
+	int _retransmitTimeout;
+
+	// Congestion controlled sending rate (in bytes per second).
+	int _pacingRate;
+	unsigned int _lastRateDecreaseTime;
+
+	// Statistics.
+	unsigned int _numRetransmissions;
+	unsigned int _numSuppressedRequests;
 private:
-	bool SendPacket( unsigned int packetNumber, const NETADDRESS_s &Address ) const;
+	bool SendPacket( unsigned int packetNumber, const NETADDRESS_s &Address );
+	bool CanSendUnsentPacket ( ) const;
+	void RefillBandwidthTokens ( );
+	void ResetTransmissionState ( );
+	int GetBandwidthLimit ( ) const;
+	unsigned int GetPacketsInFlight ( ) const;
+	void NoteTransmission ( unsigned int packetNumber );
+	bool WasTransmittedRecently ( unsigned int packetNumber, unsigned int now ) const;
+	bool MarkAcknowledged ( unsigned int packetNumber, unsigned int now, int &RTTSample );
+	void UpdateRTT ( int RTTSample );
+	void DecreaseRate ( unsigned int now );
+	void ScheduleRetransmission ( unsigned int packetNumber );
+	void CheckRetransmitTimeout ( );
 public:
 	OutgoingPacketBuffer ( );
 	void SetClientIndex ( const unsigned int ClientIdx );
@@ -108,4 +153,6 @@ public:
 	void ForceSendAll();
 	void Clear();
 	void Tick ( );
+	void AcknowledgePackets ( int lastContiguousPacket, unsigned int receivedMask );
+	void PrintStatistics ( ) const;
 };
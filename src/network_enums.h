@@ -441,6 +441,7 @@ BEGIN_ENUM( CLC )
 	ENUM_ELEMENT( CLC_SETWANTHIDEACCOUNT ),
 	ENUM_ELEMENT( CLC_SETVIDEORESOLUTION ),
 	ENUM_ELEMENT( CLC_RCONSETCVAR ),
+	ENUM_ELEMENT( CLC_ACKNOWLEDGEPACKETS ),
 
 	ENUM_ELEMENT( NUM_CLIENT_COMMANDS )
 }
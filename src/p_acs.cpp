@@ -91,6 +91,7 @@
 #include "cl_main.h"
 
 #include "g_shared/a_pickups.h"
+#include "sv_profile.h"
 
 // [BB] A std::pair inside TArray inside TArray didn't seem to work.
 std::vector<TArray<std::pair<FString, FString> > > g_dbQueries;
@@ -3384,6 +3385,7 @@ void DACSThinker::Serialize (FArchive &arc)
 
 void DACSThinker::Tick ()
 {
+	FServerProfileScope profile( SPP_ACS );
 	DLevelScript *script = Scripts;
 
 	while (script)
@@ -66,6 +66,7 @@
 #include "unlagged.h"
 #include "d_netinf.h"
 #include "v_video.h"
+#include "sv_profile.h"
 
 // [BB] Helper function to handle ZADF_UNBLOCK_PLAYERS.
 bool P_CheckUnblock ( AActor *pActor1, AActor *pActor2 )
@@ -4147,6 +4148,8 @@ static ETraceStatus CheckForActor(FTraceResults &res, void *userdata)
 AActor *P_LineAttack(AActor *t1, angle_t angle, fixed_t distance,
 	int pitch, int damage, FName damageType, const PClass *pufftype, int flags, AActor **victim, int *actualdamage)
 {
+	FServerProfileScope profile( SPP_LINEATTACK );
+
 	// [BB] The only reason the client should try to execute P_LineAttack, is the online hitscan decal fix. 
 	// [CK] And also predicted puffs and blood decals.
 	if ( NETWORK_InClientMode()
@@ -286,7 +286,7 @@ static int GetMapIndex(const char *mapname, int lastindex, const char *lumpname,
 //
 //===========================================================================
 
-MapData *P_OpenMapData(const char * mapname, bool justcheck)
+MapData *P_OpenMapData(const char * mapname, bool justcheck, bool prefetch)
 {
 	MapData * map = new MapData;
 	FileReader * wadReader = NULL;
@@ -384,6 +384,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 					// The next lump is not part of this map anymore
 					if (index < 0) break;
 
+					if (prefetch) Wads.PrefetchLump(lump_name + i);
 					map->MapLumps[index].Reader = Wads.ReopenLumpNum(lump_name + i);
 					strncpy(map->MapLumps[index].Name, lumpname, 8);
 				}
@@ -391,6 +392,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 			else
 			{
 				map->isText = true;
+				if (prefetch) Wads.PrefetchLump(lump_name + 1);
 				map->MapLumps[1].Reader = Wads.ReopenLumpNum(lump_name + 1);
 				for(int i = 2;; i++)
 				{
@@ -427,6 +429,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 						break;
 					}
 					else continue;
+					if (prefetch) Wads.PrefetchLump(lump_name + i);
 					map->MapLumps[index].Reader = Wads.ReopenLumpNum(lump_name + i);
 					strncpy(map->MapLumps[index].Name, lumpname, 8);
 				}
@@ -445,6 +448,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 				return NULL;
 			}
 			map->lumpnum = lump_wad;
+			if (prefetch) Wads.PrefetchLump(lump_wad);
 			map->resource = FResourceFile::OpenResourceFile(Wads.GetLumpFullName(lump_wad), Wads.ReopenLumpNum(lump_wad), true);
 			wadReader = map->resource->GetReader();
 		}
@@ -3984,7 +3988,7 @@ void P_SetupLevel (char *lumpname, int position)
 	P_FreeLevelData ();
 	interpolator.ClearInterpolations();	// [RH] Nothing to interpolate on a fresh level.
 
-	MapData *map = P_OpenMapData(lumpname, true);
+	MapData *map = P_OpenMapData(lumpname, true, true);
 	if (map == NULL)
 	{
 		I_Error("Unable to open map '%s'\n", lumpname);
@@ -94,7 +94,7 @@ struct MapData
 	void GetChecksum(BYTE cksum[16]);
 };
 
-MapData * P_OpenMapData(const char * mapname, bool justcheck);
+MapData * P_OpenMapData(const char * mapname, bool justcheck, bool prefetch = false);	// prefetch hints the OS to read the map lumps ahead
 bool P_CheckMapData(const char * mapname);
 
 // [BB]
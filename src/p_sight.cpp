@@ -24,6 +24,7 @@
 #include "r_state.h"
 
 #include "stats.h"
+#include "sv_profile.h"
 
 static FRandom pr_botchecksight ("BotCheckSight");
 static FRandom pr_checksight ("CheckSight");
@@ -40,7 +41,7 @@ This uses specialized forms of the maputils routines for optimized performance
 
 // Performance meters
 static int sightcounts[6];
-static cycle_t SightCycles;
+cycle_t SightCycles;
 static cycle_t MaxSightCycles;
 
 static TArray<intercept_t> intercepts (128);
@@ -652,6 +653,7 @@ sightcounts[2]++;
 
 bool P_CheckSight (const AActor *t1, const AActor *t2, int flags)
 {
+	FServerProfileScope profile( SPP_SIGHT );
 	SightCycles.Clock();
 
 	bool res;
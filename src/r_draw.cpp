@@ -85,6 +85,12 @@ void (*R_DrawSpanMaskedTranslucent)(void);
 void (*R_DrawSpanAddClamp)(void);
 void (*R_DrawSpanMaskedAddClamp)(void);
 void (STACK_ARGS *rt_map4cols)(int,int,int);
+#ifndef X86_ASM
+void (STACK_ARGS *rt_add4cols)(int,int,int);
+void (STACK_ARGS *rt_addclamp4cols)(int,int,int);
+void (STACK_ARGS *rt_subclamp4cols)(int,int,int);
+void (STACK_ARGS *rt_revsubclamp4cols)(int,int,int);
+#endif
 
 //
 // R_DrawColumn
@@ -102,8 +108,8 @@ fixed_t 		dc_texturemid;
 fixed_t			dc_texturefrac;
 int				dc_color;				// [RH] Color for column filler
 DWORD			dc_srccolor;
-DWORD			*dc_srcblend;			// [RH] Source and destination
-DWORD			*dc_destblend;			// blending lookups
+SPANSTATE DWORD	*dc_srcblend;			// [RH] Source and destination
+SPANSTATE DWORD	*dc_destblend;			// blending lookups
 
 // first pixel in a column (possibly virtual) 
 const BYTE*		dc_source;				
@@ -967,21 +973,21 @@ void R_DrawRevSubClampTranslatedColumnP_C ()
 extern "C" {
 int						ds_color;				// [RH] color for non-textured spans
 
-int 					ds_y;
-int 					ds_x1;
-int 					ds_x2;
+SPANSTATE int			ds_y;
+SPANSTATE int			ds_x1;
+SPANSTATE int			ds_x2;
 
-lighttable_t*			ds_colormap;
+SPANSTATE lighttable_t*	ds_colormap;
 
-dsfixed_t 				ds_xfrac;
-dsfixed_t 				ds_yfrac;
-dsfixed_t 				ds_xstep;
-dsfixed_t 				ds_ystep;
-int						ds_xbits;
-int						ds_ybits;
+SPANSTATE dsfixed_t		ds_xfrac;
+SPANSTATE dsfixed_t		ds_yfrac;
+SPANSTATE dsfixed_t		ds_xstep;
+SPANSTATE dsfixed_t		ds_ystep;
+SPANSTATE int			ds_xbits;
+SPANSTATE int			ds_ybits;
 
 // start of a floor/ceiling tile image 
-const BYTE*				ds_source;
+SPANSTATE const BYTE*	ds_source;
 
 // just for profiling
 int 					dscount;
@@ -2196,6 +2202,22 @@ void R_InitColumnDrawers ()
 	R_DrawSpan					= R_DrawSpanP_C;
 	R_DrawSpanMasked			= R_DrawSpanMaskedP_C;
 	rt_map4cols					= rt_map4cols_c;
+#ifdef RT_SSE2
+	if (CPU.bSSE2)
+	{
+		rt_add4cols				= rt_add4cols_sse2;
+		rt_addclamp4cols		= rt_addclamp4cols_sse2;
+		rt_subclamp4cols		= rt_subclamp4cols_sse2;
+		rt_revsubclamp4cols		= rt_revsubclamp4cols_sse2;
+	}
+	else
+#endif
+	{
+		rt_add4cols				= rt_add4cols_c;
+		rt_addclamp4cols		= rt_addclamp4cols_c;
+		rt_subclamp4cols		= rt_subclamp4cols_c;
+		rt_revsubclamp4cols		= rt_revsubclamp4cols_c;
+	}
 #endif
 	R_DrawSpanTranslucent		= R_DrawSpanTranslucentP_C;
 	R_DrawSpanMaskedTranslucent = R_DrawSpanMaskedTranslucentP_C;
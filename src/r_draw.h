@@ -25,6 +25,16 @@
 
 #include "r_defs.h"
 
+// The span drawers work from the ds_* variables and the blend tables. The C
+// drawers can run on several threads at once (see r_drawthreads.cpp), so
+// each thread has its own copy of these. The assembly drawers need them to
+// be plain globals.
+#ifdef X86_ASM
+#define SPANSTATE
+#else
+#define SPANSTATE thread_local
+#endif
+
 extern "C" int			ylookup[MAXHEIGHT];
 
 extern "C" int			dc_pitch;		// [RH] Distance between rows
@@ -38,8 +48,8 @@ extern "C" fixed_t		dc_texturemid;
 extern "C" fixed_t		dc_texturefrac;
 extern "C" int			dc_color;		// [RH] For flat colors (no texturing)
 extern "C" DWORD		dc_srccolor;
-extern "C" DWORD		*dc_srcblend;
-extern "C" DWORD		*dc_destblend;
+extern "C" SPANSTATE DWORD	*dc_srcblend;
+extern "C" SPANSTATE DWORD	*dc_destblend;
 
 // first pixel in a column
 extern "C" const BYTE*	dc_source;
@@ -144,8 +154,8 @@ void rt_tlaterevsubclamp1col (int hx, int sx, int yl, int yh);
 void STACK_ARGS rt_map4cols_c (int sx, int yl, int yh);
 void STACK_ARGS rt_add4cols_c (int sx, int yl, int yh);
 void STACK_ARGS rt_addclamp4cols_c (int sx, int yl, int yh);
-void STACK_ARGS rt_subclamp4cols (int sx, int yl, int yh);
-void STACK_ARGS rt_revsubclamp4cols (int sx, int yl, int yh);
+void STACK_ARGS rt_subclamp4cols_c (int sx, int yl, int yh);
+void STACK_ARGS rt_revsubclamp4cols_c (int sx, int yl, int yh);
 
 void STACK_ARGS rt_tlate4cols (int sx, int yl, int yh);
 void STACK_ARGS rt_tlateadd4cols (int sx, int yl, int yh);
@@ -165,6 +175,16 @@ void STACK_ARGS rt_addclamp4cols_asm (int sx, int yl, int yh);
 
 extern void (STACK_ARGS *rt_map4cols)(int sx, int yl, int yh);
 
+// SSE2 versions of the four column blenders, for builds without the
+// assembly drawers. They are picked at runtime if the CPU supports them.
+#if !defined(X86_ASM) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define RT_SSE2
+void STACK_ARGS rt_add4cols_sse2 (int sx, int yl, int yh);
+void STACK_ARGS rt_addclamp4cols_sse2 (int sx, int yl, int yh);
+void STACK_ARGS rt_subclamp4cols_sse2 (int sx, int yl, int yh);
+void STACK_ARGS rt_revsubclamp4cols_sse2 (int sx, int yl, int yh);
+#endif
+
 #ifdef X86_ASM
 #define rt_copy1col			rt_copy1col_asm
 #define rt_copy4cols		rt_copy4cols_asm
@@ -172,13 +192,17 @@ extern void (STACK_ARGS *rt_map4cols)(int sx, int yl, int yh);
 #define rt_shaded4cols		rt_shaded4cols_asm
 #define rt_add4cols			rt_add4cols_asm
 #define rt_addclamp4cols	rt_addclamp4cols_asm
+#define rt_subclamp4cols	rt_subclamp4cols_c
+#define rt_revsubclamp4cols	rt_revsubclamp4cols_c
 #else
 #define rt_copy1col			rt_copy1col_c
 #define rt_copy4cols		rt_copy4cols_c
 #define rt_map1col			rt_map1col_c
 #define rt_shaded4cols		rt_shaded4cols_c
-#define rt_add4cols			rt_add4cols_c
-#define rt_addclamp4cols	rt_addclamp4cols_c
+extern void (STACK_ARGS *rt_add4cols)(int sx, int yl, int yh);
+extern void (STACK_ARGS *rt_addclamp4cols)(int sx, int yl, int yh);
+extern void (STACK_ARGS *rt_subclamp4cols)(int sx, int yl, int yh);
+extern void (STACK_ARGS *rt_revsubclamp4cols)(int sx, int yl, int yh);
 #endif
 
 void rt_draw4cols (int sx);
@@ -233,22 +257,22 @@ void	R_FillSpan (void);
 extern "C" void			   R_SetupDrawSlab(const BYTE *colormap);
 extern "C" void STACK_ARGS R_DrawSlab(int dx, fixed_t v, int dy, fixed_t vi, const BYTE *vptr, BYTE *p);
 
-extern "C" int				ds_y;
-extern "C" int				ds_x1;
-extern "C" int				ds_x2;
+extern "C" SPANSTATE int				ds_y;
+extern "C" SPANSTATE int				ds_x1;
+extern "C" SPANSTATE int				ds_x2;
 
-extern "C" lighttable_t*	ds_colormap;
+extern "C" SPANSTATE lighttable_t*	ds_colormap;
 
-extern "C" dsfixed_t		ds_xfrac;
-extern "C" dsfixed_t		ds_yfrac;
-extern "C" dsfixed_t		ds_xstep;
-extern "C" dsfixed_t		ds_ystep;
-extern "C" int				ds_xbits;
-extern "C" int				ds_ybits;
+extern "C" SPANSTATE dsfixed_t		ds_xfrac;
+extern "C" SPANSTATE dsfixed_t		ds_yfrac;
+extern "C" SPANSTATE dsfixed_t		ds_xstep;
+extern "C" SPANSTATE dsfixed_t		ds_ystep;
+extern "C" SPANSTATE int				ds_xbits;
+extern "C" SPANSTATE int				ds_ybits;
 extern "C" fixed_t			ds_alpha;
 
 // start of a 64*64 tile image
-extern "C" const BYTE*		ds_source;
+extern "C" SPANSTATE const BYTE*		ds_source;
 
 extern "C" int				ds_color;		// [RH] For flat color (no texturing)
 
@@ -0,0 +1,299 @@
+/*
+** r_drawt_sse2.cpp
+** SSE2 versions of the four column blenders
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include "templates.h"
+#include "doomtype.h"
+#include "doomdef.h"
+#include "r_defs.h"
+#include "r_draw.h"
+#include "v_video.h"
+#include "v_palette.h"
+#include "r_data/colormaps.h"
+#include "c_dispatch.h"
+#include "v_text.h"
+#include "m_random.h"
+#include "stats.h"
+#include "x86.h"
+
+#ifdef RT_SSE2
+#include <emmintrin.h>
+
+// The blending math is done for all four columns at once. Only the table
+// lookups are still done one pixel at a time, in the same order as the C
+// versions, so the results are exactly the same.
+
+#define RT_FG(i)	fg2rgb[colormap[source[i]]]
+#define RT_BG(i)	bg2rgb[dest[i]]
+
+static inline __m128i rt_LoadFG (const DWORD *fg2rgb, const BYTE *colormap, const BYTE *source)
+{
+	return _mm_setr_epi32 (RT_FG(0), RT_FG(1), RT_FG(2), RT_FG(3));
+}
+
+static inline __m128i rt_LoadBG (const DWORD *bg2rgb, const BYTE *dest)
+{
+	return _mm_setr_epi32 (RT_BG(0), RT_BG(1), RT_BG(2), RT_BG(3));
+}
+
+// Turns four 5:5:5 colors packed the way the Col2RGB8 tables produce them
+// into palette indices.
+static inline void rt_StoreRGB (BYTE *dest, __m128i a)
+{
+	// The indices only have 15 bits, so they can be picked out as words.
+	a = _mm_and_si128 (a, _mm_srli_epi32 (a, 15));
+	dest[0] = RGB32k[0][0][_mm_extract_epi16 (a, 0)];
+	dest[1] = RGB32k[0][0][_mm_extract_epi16 (a, 2)];
+	dest[2] = RGB32k[0][0][_mm_extract_epi16 (a, 4)];
+	dest[3] = RGB32k[0][0][_mm_extract_epi16 (a, 6)];
+}
+
+// Adds all four spans to the screen starting at sx without clamping.
+void STACK_ARGS rt_add4cols_sse2 (int sx, int yl, int yh)
+{
+	int count = yh-yl;
+	if (count < 0)
+		return;
+	count++;
+
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+	const BYTE *colormap = dc_colormap;
+	const BYTE *source = &dc_temp[yl*4];
+	BYTE *dest = ylookup[yl] + sx + dc_destorg;
+	int pitch = dc_pitch;
+	const __m128i lowbits = _mm_set1_epi32 (0x1f07c1f);
+
+	do {
+		__m128i a = _mm_add_epi32 (rt_LoadFG (fg2rgb, colormap, source), rt_LoadBG (bg2rgb, dest));
+		rt_StoreRGB (dest, _mm_or_si128 (a, lowbits));
+		source += 4;
+		dest += pitch;
+	} while (--count);
+}
+
+// Adds all four spans to the screen starting at sx with clamping.
+void STACK_ARGS rt_addclamp4cols_sse2 (int sx, int yl, int yh)
+{
+	int count = yh-yl;
+	if (count < 0)
+		return;
+	count++;
+
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+	const BYTE *colormap = dc_colormap;
+	const BYTE *source = &dc_temp[yl*4];
+	BYTE *dest = ylookup[yl] + sx + dc_destorg;
+	int pitch = dc_pitch;
+	const __m128i lowbits = _mm_set1_epi32 (0x01f07c1f);
+	const __m128i carries = _mm_set1_epi32 (0x40100400);
+	const __m128i colorbits = _mm_set1_epi32 (0x3fffffff);
+
+	do {
+		__m128i a = _mm_add_epi32 (rt_LoadFG (fg2rgb, colormap, source), rt_LoadBG (bg2rgb, dest));
+		__m128i b = _mm_and_si128 (a, carries);
+		a = _mm_and_si128 (_mm_or_si128 (a, lowbits), colorbits);
+		b = _mm_sub_epi32 (b, _mm_srli_epi32 (b, 5));
+		rt_StoreRGB (dest, _mm_or_si128 (a, b));
+		source += 4;
+		dest += pitch;
+	} while (--count);
+}
+
+// Subtracts all four spans to the screen starting at sx with clamping.
+void STACK_ARGS rt_subclamp4cols_sse2 (int sx, int yl, int yh)
+{
+	int count = yh-yl;
+	if (count < 0)
+		return;
+	count++;
+
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+	const BYTE *colormap = dc_colormap;
+	const BYTE *source = &dc_temp[yl*4];
+	BYTE *dest = ylookup[yl] + sx + dc_destorg;
+	int pitch = dc_pitch;
+	const __m128i lowbits = _mm_set1_epi32 (0x01f07c1f);
+	const __m128i carries = _mm_set1_epi32 (0x40100400);
+
+	do {
+		__m128i a = _mm_sub_epi32 (_mm_or_si128 (rt_LoadFG (fg2rgb, colormap, source), carries), rt_LoadBG (bg2rgb, dest));
+		__m128i b = _mm_and_si128 (a, carries);
+		b = _mm_sub_epi32 (b, _mm_srli_epi32 (b, 5));
+		rt_StoreRGB (dest, _mm_or_si128 (_mm_and_si128 (a, b), lowbits));
+		source += 4;
+		dest += pitch;
+	} while (--count);
+}
+
+// Subtracts all four spans from the screen starting at sx with clamping.
+void STACK_ARGS rt_revsubclamp4cols_sse2 (int sx, int yl, int yh)
+{
+	int count = yh-yl;
+	if (count < 0)
+		return;
+	count++;
+
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+	const BYTE *colormap = dc_colormap;
+	const BYTE *source = &dc_temp[yl*4];
+	BYTE *dest = ylookup[yl] + sx + dc_destorg;
+	int pitch = dc_pitch;
+	const __m128i lowbits = _mm_set1_epi32 (0x01f07c1f);
+	const __m128i carries = _mm_set1_epi32 (0x40100400);
+
+	do {
+		__m128i a = _mm_sub_epi32 (_mm_or_si128 (rt_LoadBG (bg2rgb, dest), carries), rt_LoadFG (fg2rgb, colormap, source));
+		__m128i b = _mm_and_si128 (a, carries);
+		b = _mm_sub_epi32 (b, _mm_srli_epi32 (b, 5));
+		rt_StoreRGB (dest, _mm_or_si128 (_mm_and_si128 (a, b), lowbits));
+		source += 4;
+		dest += pitch;
+	} while (--count);
+}
+
+//==========================================================================
+//
+// CCMD benchdrawers
+//
+// Runs the C and SSE2 blenders over the same random input, checks that
+// they produce the same pixels and shows how long each one took.
+//
+//==========================================================================
+
+static FRandom pr_benchdrawers ("BenchDrawers");
+
+CCMD (benchdrawers)
+{
+	static const struct
+	{
+		const char *Name;
+		void (STACK_ARGS *C)(int sx, int yl, int yh);
+		void (STACK_ARGS *SSE2)(int sx, int yl, int yh);
+		bool LessPrecision;
+	} drawers[] =
+	{
+		{ "add",         rt_add4cols_c,         rt_add4cols_sse2,         false },
+		{ "addclamp",    rt_addclamp4cols_c,    rt_addclamp4cols_sse2,    true },
+		{ "subclamp",    rt_subclamp4cols_c,    rt_subclamp4cols_sse2,    true },
+		{ "revsubclamp", rt_revsubclamp4cols_c, rt_revsubclamp4cols_sse2, true },
+	};
+	const int rows = MIN (MAXHEIGHT, 1024);
+	int passes = (argv.argc() > 1) ? MAX (atoi (argv[1]), 1) : 100;
+
+	if (!CPU.bSSE2)
+	{
+		Printf ("This CPU doesn't support SSE2.\n");
+		return;
+	}
+
+	// The blenders draw to ylookup[yl] + sx + dc_destorg with dc_pitch
+	// between rows, so they can be pointed at a private buffer.
+	BYTE *savedtemp = dc_temp;
+	BYTE *saveddestorg = dc_destorg;
+	int savedpitch = dc_pitch;
+	lighttable_t *savedcolormap = dc_colormap;
+	DWORD *savedsrcblend = dc_srcblend, *saveddestblend = dc_destblend;
+
+	TArray<BYTE> source, background, cdest, ssedest;
+	source.Resize (rows * 4);
+	background.Resize (rows * 4);
+	cdest.Resize (rows * 4);
+	ssedest.Resize (rows * 4);
+	for (int i = 0; i < rows * 4; ++i)
+	{
+		source[i] = pr_benchdrawers();
+		background[i] = pr_benchdrawers();
+	}
+
+	dc_temp = &source[0];
+	dc_pitch = 4;
+	dc_colormap = NormalLight.Maps;
+
+	for (size_t d = 0; d < countof(drawers); ++d)
+	{
+		cycle_t ctime, ssetime;
+		int mismatches = 0;
+
+		ctime.Reset();
+		ssetime.Reset();
+		for (int pass = 0; pass < passes; ++pass)
+		{
+			// Cover every translucency level over the passes.
+			int level = pass % 65;
+			if (drawers[d].LessPrecision)
+			{
+				dc_srcblend = Col2RGB8_LessPrecision[level];
+				dc_destblend = Col2RGB8_LessPrecision[64 - level];
+			}
+			else
+			{
+				dc_srcblend = Col2RGB8[level];
+				dc_destblend = Col2RGB8[64 - level];
+			}
+
+			memcpy (&cdest[0], &background[0], rows * 4);
+			memcpy (&ssedest[0], &background[0], rows * 4);
+
+			dc_destorg = &cdest[0] - ylookup[0];
+			ctime.Clock();
+			drawers[d].C (0, 0, rows - 1);
+			ctime.Unclock();
+
+			dc_destorg = &ssedest[0] - ylookup[0];
+			ssetime.Clock();
+			drawers[d].SSE2 (0, 0, rows - 1);
+			ssetime.Unclock();
+
+			if (memcmp (&cdest[0], &ssedest[0], rows * 4) != 0)
+			{
+				mismatches++;
+			}
+		}
+		Printf ("%-12s C: %.3f ms  SSE2: %.3f ms  %s\n", drawers[d].Name, ctime.TimeMS(), ssetime.TimeMS(),
+			mismatches == 0 ? "identical" : TEXTCOLOR_RED "DIFFERENT");
+	}
+
+	dc_temp = savedtemp;
+	dc_destorg = saveddestorg;
+	dc_pitch = savedpitch;
+	dc_colormap = savedcolormap;
+	dc_srcblend = savedsrcblend;
+	dc_destblend = saveddestblend;
+}
+
+#endif
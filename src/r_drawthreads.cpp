@@ -0,0 +1,223 @@
+/*
+** r_drawthreads.cpp
+** Draws queued spans on several threads
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "templates.h"
+#include "c_cvars.h"
+#include "r_local.h"
+#include "r_draw.h"
+#include "r_drawthreads.h"
+#include "workerthreads.h"
+
+// 0 uses one thread per core, 1 draws everything on the main thread.
+CVAR (Int, r_drawthreads, 0, CVAR_ARCHIVE)
+
+#define MAX_SPANBANDS	16
+
+struct FSpanCommand
+{
+	void (*Func)(void);
+	const BYTE *Source;
+	lighttable_t *Colormap;
+	DWORD *SrcBlend;
+	DWORD *DestBlend;
+	dsfixed_t XFrac, YFrac;
+	dsfixed_t XStep, YStep;
+	int Y, X1, X2;
+	int XBits, YBits;
+};
+
+bool SpanQueueActive;
+
+static TArray<FSpanCommand> SpanBands[MAX_SPANBANDS];
+static int NumSpanBands;
+static bool SpansQueued;
+
+static std::mutex SpanBandMutex;
+static std::condition_variable SpanBandsDone;
+static int SpanBandsRunning;
+
+//==========================================================================
+//
+// R_BeginSpanQueue
+//
+//==========================================================================
+
+void R_BeginSpanQueue ()
+{
+#ifndef X86_ASM
+	int bands = r_drawthreads;
+	if (bands <= 0)
+	{
+		bands = (int)std::thread::hardware_concurrency();
+	}
+	NumSpanBands = clamp (bands, 1, MAX_SPANBANDS);
+	SpanQueueActive = NumSpanBands > 1;
+#endif
+}
+
+//==========================================================================
+//
+// R_QueueSpan
+//
+//==========================================================================
+
+void R_QueueSpan ()
+{
+	TArray<FSpanCommand> &band = SpanBands[ds_y % NumSpanBands];
+	FSpanCommand &cmd = band[band.Reserve (1)];
+
+	cmd.Func = spanfunc;
+	cmd.Source = ds_source;
+	cmd.Colormap = ds_colormap;
+	cmd.SrcBlend = dc_srcblend;
+	cmd.DestBlend = dc_destblend;
+	cmd.XFrac = ds_xfrac;
+	cmd.YFrac = ds_yfrac;
+	cmd.XStep = ds_xstep;
+	cmd.YStep = ds_ystep;
+	cmd.Y = ds_y;
+	cmd.X1 = ds_x1;
+	cmd.X2 = ds_x2;
+	cmd.XBits = ds_xbits;
+	cmd.YBits = ds_ybits;
+	SpansQueued = true;
+}
+
+//==========================================================================
+//
+// R_DrawSpanBand
+//
+// Draws one band's spans using the calling thread's drawer state.
+//
+//==========================================================================
+
+static void R_DrawSpanBand (TArray<FSpanCommand> &band)
+{
+	for (unsigned int i = 0; i < band.Size(); ++i)
+	{
+		const FSpanCommand &cmd = band[i];
+
+		ds_source = cmd.Source;
+		ds_colormap = cmd.Colormap;
+		dc_srcblend = cmd.SrcBlend;
+		dc_destblend = cmd.DestBlend;
+		ds_xfrac = cmd.XFrac;
+		ds_yfrac = cmd.YFrac;
+		ds_xstep = cmd.XStep;
+		ds_ystep = cmd.YStep;
+		ds_y = cmd.Y;
+		ds_x1 = cmd.X1;
+		ds_x2 = cmd.X2;
+		ds_xbits = cmd.XBits;
+		ds_ybits = cmd.YBits;
+		cmd.Func ();
+	}
+	band.Clear ();
+}
+
+//==========================================================================
+//
+// R_FlushSpanQueue
+//
+// The main thread draws the first band itself. It restores its own drawer
+// state afterwards, since the caller may still be in the middle of a plane.
+//
+//==========================================================================
+
+void R_FlushSpanQueue ()
+{
+	if (!SpansQueued)
+	{
+		return;
+	}
+	SpansQueued = false;
+
+	SpanBandsRunning = 0;
+	for (int i = 1; i < NumSpanBands; ++i)
+	{
+		if (SpanBands[i].Size() == 0)
+		{
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock(SpanBandMutex);
+			SpanBandsRunning++;
+		}
+		TArray<FSpanCommand> *band = &SpanBands[i];
+		FWorkerThreads::Get().SubmitUrgent([band]()
+		{
+			R_DrawSpanBand (*band);
+			{
+				std::lock_guard<std::mutex> lock(SpanBandMutex);
+				SpanBandsRunning--;
+			}
+			SpanBandsDone.notify_all();
+		});
+	}
+
+	const BYTE *source = ds_source;
+	lighttable_t *colormap = ds_colormap;
+	DWORD *srcblend = dc_srcblend, *destblend = dc_destblend;
+	int xbits = ds_xbits, ybits = ds_ybits;
+
+	R_DrawSpanBand (SpanBands[0]);
+	FWorkerThreads::Get().RunUrgentJobs ();
+
+	ds_source = source;
+	ds_colormap = colormap;
+	dc_srcblend = srcblend;
+	dc_destblend = destblend;
+	ds_xbits = xbits;
+	ds_ybits = ybits;
+
+	std::unique_lock<std::mutex> lock(SpanBandMutex);
+	SpanBandsDone.wait(lock, [] { return SpanBandsRunning == 0; });
+}
+
+//==========================================================================
+//
+// R_EndSpanQueue
+//
+//==========================================================================
+
+void R_EndSpanQueue ()
+{
+	R_FlushSpanQueue ();
+	SpanQueueActive = false;
+}
@@ -950,13 +950,14 @@ void R_MultiresInit ()
 //
 //==========================================================================
 extern cycle_t WallCycles, PlaneCycles, MaskedCycles, WallScanCycles;
-extern cycle_t FrameCycles;
+extern cycle_t FrameCycles, ConvertCycles;
 
 ADD_STAT (fps)
 {
 	FString out;
-	out.Format("frame=%04.1f ms  walls=%04.1f ms  planes=%04.1f ms  masked=%04.1f ms",
-		FrameCycles.TimeMS(), WallCycles.TimeMS(), PlaneCycles.TimeMS(), MaskedCycles.TimeMS());
+	out.Format("frame=%04.1f ms  walls=%04.1f ms  planes=%04.1f ms  masked=%04.1f ms  convert=%04.1f ms",
+		FrameCycles.TimeMS(), WallCycles.TimeMS(), PlaneCycles.TimeMS(), MaskedCycles.TimeMS(),
+		ConvertCycles.TimeMS());
 	return out;
 }
 
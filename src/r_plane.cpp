@@ -60,6 +60,7 @@
 #include "r_plane.h"
 #include "r_segs.h"
 #include "r_3dfloors.h"
+#include "r_drawthreads.h"
 #include "v_palette.h"
 #include "r_data/colormaps.h"
 // [BC] New #includes.
@@ -244,7 +245,14 @@ void R_MapPlane (int y, int x1)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc ();
+	if (SpanQueueActive)
+	{
+		R_QueueSpan ();
+	}
+	else
+	{
+		spanfunc ();
+	}
 }
 
 //==========================================================================
@@ -1045,6 +1053,7 @@ int R_DrawPlanes ()
 
 	ds_color = 3;
 
+	R_BeginSpanQueue ();
 	for (i = 0; i < MAXVISPLANES; i++)
 	{
 		for (pl = visplanes[i]; pl; pl = pl->next)
@@ -1059,6 +1068,7 @@ int R_DrawPlanes ()
 			}
 		}
 	}
+	R_EndSpanQueue ();
 	return vpcount;
 }
 
@@ -1070,6 +1080,7 @@ void R_DrawHeightPlanes(fixed_t height)
 
 	ds_color = 3;
 
+	R_BeginSpanQueue ();
 	for (i = 0; i < MAXVISPLANES; i++)
 	{
 		for (pl = visplanes[i]; pl; pl = pl->next)
@@ -1086,6 +1097,7 @@ void R_DrawHeightPlanes(fixed_t height)
 			}
 		}
 	}
+	R_EndSpanQueue ();
 }
 
 
@@ -1104,13 +1116,17 @@ void R_DrawSinglePlane (visplane_t *pl, fixed_t alpha, bool additive, bool maske
 	if (pl->minx > pl->maxx)
 		return;
 
+	// Only the spans of regular flats are queued. Anything else must not
+	// be drawn before the spans queued so far.
 	if (r_drawflat)
 	{ // [RH] no texture mapping
+		R_FlushSpanQueue ();
 		ds_color += 4;
 		R_MapVisPlane (pl, R_MapColoredPlane);
 	}
 	else if (pl->picnum == skyflatnum)
 	{ // sky flat
+		R_FlushSpanQueue ();
 		R_DrawSkyPlane (pl);
 	}
 	else
@@ -1144,6 +1160,7 @@ void R_DrawSinglePlane (visplane_t *pl, fixed_t alpha, bool additive, bool maske
 		}
 		else
 		{
+			R_FlushSpanQueue ();
 			R_DrawTiltedPlane (pl, alpha, additive, masked);
 		}
 	}
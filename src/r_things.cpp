@@ -149,6 +149,7 @@ int 			newvissprite;
 bool			DrewAVoxel;
 
 static vissprite_t **spritesorter;
+static vissprite_t **spritesorttemp;
 static int spritesortersize = 0;
 static int vsprcount;
 
@@ -169,8 +170,9 @@ void R_DeinitSprites()
 	if (spritesorter != NULL)
 	{
 		delete[] spritesorter;
+		delete[] spritesorttemp;
 		spritesortersize = 0;
-		spritesorter = NULL;
+		spritesorter = spritesorttemp = NULL;
 	}
 
 	// Free offscreen buffer
@@ -1528,6 +1530,65 @@ static void swap(vissprite_t *&a, vissprite_t *&b)
 }
 #endif
 
+//
+// R_RadixSortVisSprites
+//
+// Stable LSD radix sort of spritesorter for the standard depth order. This
+// gives the same result as std::stable_sort with sv_compare, but in linear
+// time, which matters when hundreds of projectiles and particles are in view.
+//
+enum
+{
+	RADIX_BITS = 11,
+	RADIX_SIZE = 1 << RADIX_BITS,
+	RADIX_PASSES = 3,				// idepth is at most 31 bits wide
+	RADIX_MINSPRITES = 64			// below this the comparison sort is faster
+};
+
+static void R_RadixSortVisSprites ()
+{
+	static int counts[RADIX_PASSES][RADIX_SIZE];
+	int i, pass;
+
+	memset (counts, 0, sizeof(counts));
+
+	// sv_compare sorts by descending idepth, so count the inverted depth.
+	for (i = 0; i < vsprcount; i++)
+	{
+		DWORD key = 0x7fffffff - DWORD(spritesorter[i]->idepth);
+		for (pass = 0; pass < RADIX_PASSES; pass++)
+		{
+			counts[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE-1)]++;
+		}
+	}
+
+	for (pass = 0; pass < RADIX_PASSES; pass++)
+	{
+		int *count = counts[pass];
+		int shift = pass * RADIX_BITS;
+
+		// All keys share this digit, so this pass would not change anything.
+		if (count[((0x7fffffff - DWORD(spritesorter[0]->idepth)) >> shift) & (RADIX_SIZE-1)] == vsprcount)
+		{
+			continue;
+		}
+
+		int sum = 0;
+		for (i = 0; i < RADIX_SIZE; i++)
+		{
+			int c = count[i];
+			count[i] = sum;
+			sum += c;
+		}
+		for (i = 0; i < vsprcount; i++)
+		{
+			DWORD key = 0x7fffffff - DWORD(spritesorter[i]->idepth);
+			spritesorttemp[count[(key >> shift) & (RADIX_SIZE-1)]++] = spritesorter[i];
+		}
+		std::swap (spritesorter, spritesorttemp);
+	}
+}
+
 void R_SortVisSprites (bool (*compare)(vissprite_t *, vissprite_t *), size_t first)
 {
 	int i;
@@ -1541,8 +1602,12 @@ void R_SortVisSprites (bool (*compare)(vissprite_t *, vissprite_t *), size_t fir
 	if (spritesortersize < MaxVisSprites)
 	{
 		if (spritesorter != NULL)
+		{
 			delete[] spritesorter;
+			delete[] spritesorttemp;
+		}
 		spritesorter = new vissprite_t *[MaxVisSprites];
+		spritesorttemp = new vissprite_t *[MaxVisSprites];
 		spritesortersize = MaxVisSprites;
 	}
 
@@ -1564,7 +1629,133 @@ void R_SortVisSprites (bool (*compare)(vissprite_t *, vissprite_t *), size_t fir
 		}
 	}
 
-	std::stable_sort(&spritesorter[0], &spritesorter[vsprcount], compare);
+	if (compare == sv_compare && vsprcount >= RADIX_MINSPRITES)
+	{
+		R_RadixSortVisSprites ();
+	}
+	else
+	{
+		std::stable_sort(&spritesorter[0], &spritesorter[vsprcount], compare);
+	}
+}
+
+
+//
+// Drawseg column index
+//
+// R_DrawSprite has to look at every drawseg that overlaps the sprite,
+// from the last one to the first. With many sprites and many drawsegs
+// scanning the whole list for every sprite gets expensive, so for the
+// duration of R_DrawMasked the drawsegs that can affect a sprite are
+// put into buckets of screen columns. A sprite then only merges the
+// buckets it covers. Sprites that are wider than a few buckets still
+// use the plain scan since they would see most drawsegs anyway.
+//
+enum
+{
+	DSBUCKET_SHIFT = 6,
+	MAX_DSBUCKETS = (MAXWIDTH >> DSBUCKET_SHIFT) + 1,
+	MAX_DSMERGE = 8,				// widest sprite, in buckets, that uses the index
+	MIN_INDEXDRAWSEGS = 64			// with fewer drawsegs the plain scan is fine
+};
+
+static TArray<drawseg_t *> DrawSegBuckets[MAX_DSBUCKETS];
+static TArray<drawseg_t *> SpriteClipSegs;
+static drawseg_t *DrawSegIndexFirst, *DrawSegIndexEnd;
+static int DrawSegNumBuckets;
+
+static inline bool R_DrawSegAffectsSprites (const drawseg_t *ds)
+{
+	// kg3D - no clipping on fake segs
+	return !ds->fake && ((ds->silhouette & SIL_BOTH) || ds->maskedtexturecol != -1 || ds->bFogBoundary);
+}
+
+static void R_BuildDrawSegIndex ()
+{
+	DrawSegIndexFirst = DrawSegIndexEnd = NULL;
+	if (vsprcount == 0 || ds_p - firstdrawseg < MIN_INDEXDRAWSEGS)
+	{
+		return;
+	}
+
+	int numbuckets = DrawSegNumBuckets = ((viewwidth - 1) >> DSBUCKET_SHIFT) + 1;
+	for (int i = 0; i < numbuckets; ++i)
+	{
+		DrawSegBuckets[i].Clear();
+	}
+	for (drawseg_t *ds = firstdrawseg; ds < ds_p; ++ds)
+	{
+		if (R_DrawSegAffectsSprites (ds) && ds->x1 <= ds->x2)
+		{
+			int b1 = clamp (ds->x1 >> DSBUCKET_SHIFT, 0, numbuckets - 1);
+			int b2 = clamp (ds->x2 >> DSBUCKET_SHIFT, 0, numbuckets - 1);
+			for (int b = b1; b <= b2; ++b)
+			{
+				DrawSegBuckets[b].Push (ds);
+			}
+		}
+	}
+	DrawSegIndexFirst = firstdrawseg;
+	DrawSegIndexEnd = ds_p;
+}
+
+// Collects the drawsegs that may clip the columns x1..x2, last one first.
+static void R_CollectSpriteClipSegs (int x1, int x2)
+{
+	SpriteClipSegs.Clear();
+
+	int b1 = x1 >> DSBUCKET_SHIFT;
+	int b2 = x2 >> DSBUCKET_SHIFT;
+
+	if (DrawSegIndexFirst != firstdrawseg || DrawSegIndexEnd != ds_p ||
+		b1 < 0 || b2 >= DrawSegNumBuckets || b2 - b1 >= MAX_DSMERGE)
+	{
+		for (drawseg_t *ds = ds_p; ds-- > firstdrawseg; )
+		{
+			if (R_DrawSegAffectsSprites (ds) && ds->x1 <= x2 && ds->x2 >= x1)
+			{
+				SpriteClipSegs.Push (ds);
+			}
+		}
+		return;
+	}
+
+	// Each bucket is in drawseg order, so merge them from the back. A drawseg
+	// spanning several buckets is at the head of all of them at the same time.
+	unsigned int heads[MAX_DSMERGE];
+	int numheads = b2 - b1 + 1;
+	int i;
+
+	for (i = 0; i < numheads; ++i)
+	{
+		heads[i] = DrawSegBuckets[b1 + i].Size();
+	}
+	for (;;)
+	{
+		drawseg_t *best = NULL;
+		for (i = 0; i < numheads; ++i)
+		{
+			if (heads[i] > 0 && DrawSegBuckets[b1 + i][heads[i] - 1] > best)
+			{
+				best = DrawSegBuckets[b1 + i][heads[i] - 1];
+			}
+		}
+		if (best == NULL)
+		{
+			break;
+		}
+		for (i = 0; i < numheads; ++i)
+		{
+			if (heads[i] > 0 && DrawSegBuckets[b1 + i][heads[i] - 1] == best)
+			{
+				heads[i]--;
+			}
+		}
+		if (best->x1 <= x2 && best->x2 >= x1)
+		{
+			SpriteClipSegs.Push (best);
+		}
+	}
 }
 
 
@@ -1862,10 +2053,10 @@ void R_DrawSprite (vissprite_t * /*dummyArg*/, vissprite_t *spr)
 
 	//		for (ds=ds_p-1 ; ds >= drawsegs ; ds--)    old buggy code
 
-	for (ds = ds_p; ds-- > firstdrawseg; )  // new -- killough
+	R_CollectSpriteClipSegs (x1, x2);
+	for (unsigned int d = 0; d < SpriteClipSegs.Size(); ++d)
 	{
-		// kg3D - no clipping on fake segs
-		if(ds->fake) continue;
+		ds = SpriteClipSegs[d];
 		// determine if the drawseg obscures the sprite
 		if (ds->x1 > x2 || ds->x2 < x1 ||
 			(!(ds->silhouette & SIL_BOTH) && ds->maskedtexturecol == -1 &&
@@ -2031,6 +2222,7 @@ void R_DrawHeightPlanes(fixed_t height); // kg3D - fake planes
 void R_DrawMasked (void)
 {
 	R_SortVisSprites (DrewAVoxel ? sv_compare2d : sv_compare, firstvissprite - vissprites);
+	R_BuildDrawSegIndex ();
 
 	if (height_top == NULL)
 	{ // kg3D - no visible 3D floors, normal rendering
@@ -2080,6 +2272,7 @@ void R_DrawMasked (void)
 		R_3D_DeleteHeights();
 		fake3D = 0;
 	}
+	DrawSegIndexFirst = DrawSegIndexEnd = NULL;
 	R_DrawPlayerSprites ();
 }
 
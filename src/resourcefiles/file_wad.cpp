@@ -236,7 +236,7 @@ public:
 	bool Compressed;
 	int	Position;
 
-	int GetFileOffset() { return Position; }
+	int GetFileOffset() { return Compressed ? -1 : Position; }
 	FileReader *GetReader()
 	{
 		if(!Compressed)
@@ -41,6 +41,12 @@
 #include "w_zip.h"
 #include "i_system.h"
 #include "ancientzip.h"
+#include "c_cvars.h"
+#include "stats.h"
+#include "workerthreads.h"
+#include "lumpstore.h"
+#include <list>
+#include <unordered_map>
 
 #define BUFREADCOMMENT (0x400)
 
@@ -99,9 +105,15 @@ static DWORD Zip_FindCentralDir(FileReader * fin)
 
 enum
 {
+	LUMPFZIP_SHARED = 32,		// Cache is mapped from the shared lump store
+	LUMPFZIP_PREFETCHED = 64,
 	LUMPFZIP_NEEDFILESTART = 128
 };
 
+// Upper bound for the memory held by lumps that were decompressed ahead of time
+// but not used yet.
+CVAR (Int, zip_prefetchbudget, 64, CVAR_ARCHIVE)
+
 //==========================================================================
 //
 // Zip Lump
@@ -114,12 +126,18 @@ struct FZipLump : public FResourceLump
 	BYTE	Method;
 	int		CompressedSize;
 	int		Position;
+	DWORD	CRC32;
 
+	virtual ~FZipLump();
 	virtual FileReader *GetReader();
 	virtual int FillCache();
+	virtual void Prefetch();
 
 private:
 	void SetLumpAddress();
+	bool TakePrefetched();
+	static bool Decompress(char *dest, int size, FileReader *src, BYTE method, int compressedsize, WORD gpflags);
+	static char *DecompressInBackground(const char *source, int size, BYTE method, int compressedsize, WORD gpflags);
 	virtual int GetFileOffset() 
 	{ 
 		if (Method != METHOD_STORED) return -1;
@@ -266,6 +284,7 @@ bool FZipFile::Open(bool quiet)
 		lump_p->GPFlags = zip_fh->Flags;
 		lump_p->CompressedSize = LittleLong(zip_fh->CompressedSize);
 		lump_p->Position = LittleLong(zip_fh->LocalHeaderOffset);
+		lump_p->CRC32 = LittleLong(zip_fh->CRC32);
 		lump_p->CheckEmbedded();
 
 		// Ignore some very specific names
@@ -349,9 +368,10 @@ FileReader *FZipLump::GetReader()
 int FZipLump::FillCache()
 {
 	if (Flags & LUMPFZIP_NEEDFILESTART) SetLumpAddress();
-	const char *buffer;
+	const char *buffer = Owner->Reader->GetBuffer();
+	const char *shared;
 
-	if (Method == METHOD_STORED && (buffer = Owner->Reader->GetBuffer()) != NULL)
+	if (Method == METHOD_STORED && buffer != NULL)
 	{
 		// This is an in-memory file so the cache can point directly to the file's data.
 		Cache = const_cast<char*>(buffer) + Position;
@@ -359,56 +379,389 @@ int FZipLump::FillCache()
 		return -1;
 	}
 
+	if ((Flags & LUMPFZIP_PREFETCHED) && TakePrefetched())
+	{
+		RefCount = (Flags & LUMPFZIP_SHARED) ? -1 : 1;
+		return RefCount;
+	}
+
+	// Only lumps of mapped files can be shared, because the key is made from the
+	// compressed data. Making the key hashes all of that data, so it is made only
+	// once and only for lumps the store takes.
+	FSharedLumpStore &store = FSharedLumpStore::Get();
+	bool useshared = Method != METHOD_STORED && buffer != NULL && store.Accepts(LumpSize);
+	FSharedLumpKey key;
+	if (useshared)
+	{
+		key = FSharedLumpKey(buffer + Position, CompressedSize, Method, LumpSize, CRC32);
+	}
+
+	if (useshared && (shared = store.Find(key)) != NULL)
+	{
+		Cache = const_cast<char*>(shared);
+		Flags |= LUMPFZIP_SHARED;
+		RefCount = -1;
+		return -1;
+	}
+
 	Owner->Reader->Seek(Position, SEEK_SET);
 	Cache = new char[LumpSize];
-	switch (Method)
+	if (Method == METHOD_STORED)
 	{
-		case METHOD_STORED:
-		{
-			Owner->Reader->Read(Cache, LumpSize);
-			break;
-		}
+		Owner->Reader->Read(Cache, LumpSize);
+	}
+	else if (!Decompress(Cache, LumpSize, Owner->Reader, Method, CompressedSize, GPFlags))
+	{
+		assert(0);
+		return 0;
+	}
+	else if (useshared && (shared = store.Add(key, Cache)) != NULL)
+	{
+		// From now on the other processes can use this copy too.
+		delete[] Cache;
+		Cache = const_cast<char*>(shared);
+		Flags |= LUMPFZIP_SHARED;
+		RefCount = -1;
+		return -1;
+	}
+	RefCount = 1;
+	return 1;
+}
 
+//==========================================================================
+//
+// Decompresses a lump from a reader that's positioned at its data
+//
+//==========================================================================
+
+bool FZipLump::Decompress(char *dest, int size, FileReader *src, BYTE method, int compressedsize, WORD gpflags)
+{
+	switch (method)
+	{
 		case METHOD_DEFLATE:
 		{
-			FileReaderZ frz(*Owner->Reader, true);
-			frz.Read(Cache, LumpSize);
+			FileReaderZ frz(*src, true);
+			frz.Read(dest, size);
 			break;
 		}
 
 		case METHOD_BZIP2:
 		{
-			FileReaderBZ2 frz(*Owner->Reader);
-			frz.Read(Cache, LumpSize);
+			FileReaderBZ2 frz(*src);
+			frz.Read(dest, size);
 			break;
 		}
 
 		case METHOD_LZMA:
 		{
-			FileReaderLZMA frz(*Owner->Reader, LumpSize, true);
-			frz.Read(Cache, LumpSize);
+			FileReaderLZMA frz(*src, size, true);
+			frz.Read(dest, size);
 			break;
 		}
 
 		case METHOD_IMPLODE:
 		{
 			FZipExploder exploder;
-			exploder.Explode((unsigned char *)Cache, LumpSize, Owner->Reader, CompressedSize, GPFlags);
+			exploder.Explode((unsigned char *)dest, size, src, compressedsize, gpflags);
 			break;
 		}
 
 		case METHOD_SHRINK:
 		{
-			ShrinkLoop((unsigned char *)Cache, LumpSize, Owner->Reader, CompressedSize);
+			ShrinkLoop((unsigned char *)dest, size, src, compressedsize);
 			break;
 		}
 
 		default:
-			assert(0);
-			return 0;
+			return false;
 	}
-	RefCount = 1;
-	return 1;
+	return true;
+}
+
+//==========================================================================
+//
+// Background decompression
+//
+// Lumps of mapped zips can be inflated on the worker threads before they
+// are needed. The results are kept here until FillCache picks them up.
+// Everything in this block is protected by ZipPrefetchMutex.
+//
+//==========================================================================
+
+enum
+{
+	PREFETCH_Queued,
+	PREFETCH_Working,
+	PREFETCH_Done,
+	PREFETCH_Failed
+};
+
+struct FZipPrefetch
+{
+	unsigned int Serial;
+	int State;
+	char *Data;
+	bool Shared;		// Data is mapped from the shared lump store
+	std::list<const FZipLump *>::iterator Order;
+};
+
+static std::mutex ZipPrefetchMutex;
+static std::condition_variable ZipPrefetchFinished;
+static std::unordered_map<const FZipLump *, FZipPrefetch> ZipPrefetches;
+static std::list<const FZipLump *> ZipPrefetchOrder;		// oldest first
+static size_t ZipPrefetchBytes;
+static unsigned int ZipPrefetchSerial;
+static unsigned int ZipPrefetchStats[4];	// submitted, used, waited for, evicted
+
+//==========================================================================
+//
+// Removes an entry and frees its data. The entry must not be in progress.
+//
+//==========================================================================
+
+static void ForgetPrefetch(std::unordered_map<const FZipLump *, FZipPrefetch>::iterator it, int size)
+{
+	if (it->second.Data != NULL)
+	{
+		if (it->second.Shared)
+		{
+			FSharedLumpStore::Release(it->second.Data, size);
+		}
+		else
+		{
+			delete[] it->second.Data;
+		}
+	}
+	ZipPrefetchBytes -= size;
+	ZipPrefetchOrder.erase(it->second.Order);
+	ZipPrefetches.erase(it);
+}
+
+//==========================================================================
+//
+// Queues the lump for decompression on a worker thread
+//
+//==========================================================================
+
+void FZipLump::Prefetch()
+{
+	if (Cache != NULL || Method == METHOD_STORED || LumpSize <= 0 || (Flags & LUMPFZIP_PREFETCHED))
+	{
+		return;
+	}
+
+	const char *buffer = Owner->Reader->GetBuffer();
+	if (buffer == NULL)
+	{
+		// Not mapped, so the workers would have to share the FILE with the main thread.
+		return;
+	}
+	if (Flags & LUMPFZIP_NEEDFILESTART) SetLumpAddress();
+
+	size_t budget = (size_t)MAX<int>(zip_prefetchbudget, 0) << 20;
+	unsigned int serial;
+	{
+		std::lock_guard<std::mutex> lock(ZipPrefetchMutex);
+
+		// Make room by dropping the oldest results nobody has asked for yet.
+		std::list<const FZipLump *>::iterator next;
+		for (std::list<const FZipLump *>::iterator o = ZipPrefetchOrder.begin();
+			o != ZipPrefetchOrder.end() && ZipPrefetchBytes + LumpSize > budget; o = next)
+		{
+			next = o;
+			++next;
+			std::unordered_map<const FZipLump *, FZipPrefetch>::iterator it = ZipPrefetches.find(*o);
+			if (it->second.State == PREFETCH_Done || it->second.State == PREFETCH_Failed)
+			{
+				const_cast<FZipLump *>(*o)->Flags &= ~LUMPFZIP_PREFETCHED;
+				ForgetPrefetch(it, (*o)->LumpSize);
+				ZipPrefetchStats[3]++;
+			}
+		}
+		if (ZipPrefetchBytes + LumpSize > budget)
+		{
+			return;
+		}
+
+		serial = ++ZipPrefetchSerial;
+		FZipPrefetch &entry = ZipPrefetches[this];
+		entry.Serial = serial;
+		entry.State = PREFETCH_Queued;
+		entry.Data = NULL;
+		entry.Shared = false;
+		entry.Order = ZipPrefetchOrder.insert(ZipPrefetchOrder.end(), this);
+		ZipPrefetchBytes += LumpSize;
+		ZipPrefetchStats[0]++;
+	}
+	Flags |= LUMPFZIP_PREFETCHED;
+
+	// The worker only gets copies of what it needs so that it never touches the lump itself.
+	const FZipLump *self = this;
+	const char *source = buffer + Position;
+	int size = LumpSize, compressedsize = CompressedSize;
+	BYTE method = Method;
+	WORD gpflags = GPFlags;
+	DWORD crc = CRC32;
+	bool useshared = FSharedLumpStore::Get().Accepts(size);
+
+	FWorkerThreads::Get().Submit([=]()
+	{
+		{
+			std::lock_guard<std::mutex> lock(ZipPrefetchMutex);
+			std::unordered_map<const FZipLump *, FZipPrefetch>::iterator it = ZipPrefetches.find(self);
+			if (it == ZipPrefetches.end() || it->second.Serial != serial || it->second.State != PREFETCH_Queued)
+			{
+				return;	// cancelled
+			}
+			it->second.State = PREFETCH_Working;
+		}
+
+		char *data = NULL;
+		const char *shared = NULL;
+		if (useshared)
+		{
+			FSharedLumpKey key(source, compressedsize, method, size, crc);
+			if ((shared = FSharedLumpStore::Get().Find(key)) == NULL &&
+				(data = DecompressInBackground(source, size, method, compressedsize, gpflags)) != NULL)
+			{
+				shared = FSharedLumpStore::Get().Add(key, data);
+			}
+		}
+		else
+		{
+			data = DecompressInBackground(source, size, method, compressedsize, gpflags);
+		}
+		if (shared != NULL)
+		{
+			delete[] data;
+			data = const_cast<char *>(shared);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(ZipPrefetchMutex);
+			FZipPrefetch &entry = ZipPrefetches[self];
+			entry.Data = data;
+			entry.Shared = shared != NULL;
+			entry.State = data != NULL ? PREFETCH_Done : PREFETCH_Failed;
+		}
+		ZipPrefetchFinished.notify_all();
+	});
+}
+
+//==========================================================================
+//
+// Decompresses mapped data into a new buffer. Returns NULL if that fails,
+// so that FillCache runs into the same error on the main thread where it
+// can be reported.
+//
+//==========================================================================
+
+char *FZipLump::DecompressInBackground(const char *source, int size, BYTE method, int compressedsize, WORD gpflags)
+{
+	char *data = new char[size];
+	bool ok;
+	try
+	{
+		MemoryReader mr(source, compressedsize);
+		ok = Decompress(data, size, &mr, method, compressedsize, gpflags);
+	}
+	catch (...)
+	{
+		ok = false;
+	}
+	if (!ok)
+	{
+		delete[] data;
+		data = NULL;
+	}
+	return data;
+}
+
+//==========================================================================
+//
+// Moves a prefetched lump into the cache. Returns false if it has to be
+// decompressed the normal way.
+//
+//==========================================================================
+
+bool FZipLump::TakePrefetched()
+{
+	Flags &= ~LUMPFZIP_PREFETCHED;
+
+	std::unique_lock<std::mutex> lock(ZipPrefetchMutex);
+	std::unordered_map<const FZipLump *, FZipPrefetch>::iterator it = ZipPrefetches.find(this);
+	if (it == ZipPrefetches.end())
+	{
+		return false;
+	}
+	if (it->second.State == PREFETCH_Working)
+	{
+		ZipPrefetchStats[2]++;
+		ZipPrefetchFinished.wait(lock, [this] { return ZipPrefetches[this].State != PREFETCH_Working; });
+		it = ZipPrefetches.find(this);
+	}
+
+	char *data = it->second.Data;
+	bool shared = it->second.Shared;
+	it->second.Data = NULL;
+	ForgetPrefetch(it, LumpSize);
+	if (data == NULL)
+	{
+		return false;
+	}
+	ZipPrefetchStats[1]++;
+	Cache = data;
+	if (shared)
+	{
+		Flags |= LUMPFZIP_SHARED;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Drops any pending prefetch so that no worker is left writing to a lump
+// that is gone.
+//
+//==========================================================================
+
+FZipLump::~FZipLump()
+{
+	if ((Flags & LUMPFZIP_SHARED) && Cache != NULL)
+	{
+		FSharedLumpStore::Release(Cache, LumpSize);
+		Cache = NULL;
+	}
+	if (Flags & LUMPFZIP_PREFETCHED)
+	{
+		std::unique_lock<std::mutex> lock(ZipPrefetchMutex);
+		std::unordered_map<const FZipLump *, FZipPrefetch>::iterator it = ZipPrefetches.find(this);
+		if (it != ZipPrefetches.end())
+		{
+			if (it->second.State == PREFETCH_Working)
+			{
+				ZipPrefetchFinished.wait(lock, [this] { return ZipPrefetches[this].State != PREFETCH_Working; });
+				it = ZipPrefetches.find(this);
+			}
+			ForgetPrefetch(it, LumpSize);
+		}
+	}
+}
+
+//==========================================================================
+//
+// Stats
+//
+//==========================================================================
+
+ADD_STAT (zipprefetch)
+{
+	FString out;
+	std::lock_guard<std::mutex> lock(ZipPrefetchMutex);
+	out.Format ("Prefetched = %u, used = %u, waited = %u, evicted = %u, pending = %u (%u KB)",
+		ZipPrefetchStats[0], ZipPrefetchStats[1], ZipPrefetchStats[2], ZipPrefetchStats[3],
+		(unsigned int)ZipPrefetches.size(), (unsigned int)(ZipPrefetchBytes >> 10));
+	return out;
 }
 
 
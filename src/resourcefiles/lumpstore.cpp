@@ -0,0 +1,377 @@
+/*
+** lumpstore.cpp
+** A cache of decompressed lumps that several processes can map at once
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <process.h>
+#define USE_WINDOWS_DWORD
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <atomic>
+
+#include "lumpstore.h"
+#include "md5.h"
+#include "m_crc32.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "cmdlib.h"
+#include "c_console.h"
+#include "stats.h"
+#include "templates.h"
+
+// Lumps smaller than a page would take up a whole page each when mapped,
+// which is more than they cost when simply kept on the heap.
+#define SHAREDLUMP_MINSIZE	4096
+
+// Default cap for the store directory, in megabytes.
+#define SHAREDLUMP_DEFAULTMAX	1024
+
+//==========================================================================
+//
+// FSharedLumpKey :: FSharedLumpKey
+//
+//==========================================================================
+
+FSharedLumpKey::FSharedLumpKey (const char *compressed, int compressedsize, int method, int size, DWORD crc)
+: Size(size), CRC(crc)
+{
+	MD5Context md5;
+	BYTE methodbyte = (BYTE)method;
+
+	md5.Update((const BYTE *)compressed, compressedsize);
+	md5.Update(&methodbyte, 1);
+	md5.Final(Hash);
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: Get
+//
+//==========================================================================
+
+FSharedLumpStore &FSharedLumpStore::Get ()
+{
+	static FSharedLumpStore store;
+	return store;
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: FSharedLumpStore
+//
+// The store is used if -sharedlumps is on the command line, optionally
+// followed by the directory to use instead of the cache path. The size of
+// the directory is capped at -sharedlumpsmax megabytes.
+//
+//==========================================================================
+
+FSharedLumpStore::FSharedLumpStore ()
+: bEnabled(false), MaxBytes(0), DirectoryBytes(0), Mapped(0), Stored(0), Rejected(0), Trimmed(0), MappedBytes(0)
+{
+	if (!Args->CheckParm("-sharedlumps"))
+	{
+		return;
+	}
+
+	const char *dir = Args->CheckValue("-sharedlumps");
+	if (dir != NULL)
+	{
+		Directory = NicePath(dir);
+	}
+	else
+	{
+		Directory = M_GetCachePath(true);
+		Directory << "/lumps";
+	}
+	FixPathSeperator(Directory);
+	if (Directory.IsNotEmpty() && Directory[Directory.Len() - 1] != '/')
+	{
+		Directory << '/';
+	}
+	CreatePath(Directory);
+	bEnabled = DirEntryExists(Directory);
+	if (bEnabled)
+	{
+		const char *max = Args->CheckValue("-sharedlumpsmax");
+		int megabytes = max != NULL ? atoi(max) : SHAREDLUMP_DEFAULTMAX;
+		MaxBytes = (size_t)MAX(megabytes, 1) << 20;
+		DirectoryBytes = TrimDirectory(Directory, MaxBytes);
+		Printf("Sharing decompressed lumps through %s (%u of %u MB used)\n", Directory.GetChars(),
+			(unsigned int)(DirectoryBytes >> 20), (unsigned int)(MaxBytes >> 20));
+	}
+	else
+	{
+		Printf("Can't use %s for shared lumps\n", Directory.GetChars());
+	}
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: Accepts
+//
+//==========================================================================
+
+bool FSharedLumpStore::Accepts (int size) const
+{
+	return bEnabled && size >= SHAREDLUMP_MINSIZE;
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: GetPath
+//
+//==========================================================================
+
+FString FSharedLumpStore::GetPath (const FSharedLumpKey &key) const
+{
+	FString path = Directory;
+	for (int i = 0; i < 16; ++i)
+	{
+		path.AppendFormat("%02x", key.Hash[i]);
+	}
+	path.AppendFormat("-%d.lmp", key.Size);
+	return path;
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: Map
+//
+// Maps a stored lump read-only. Files of the wrong size or, if asked for,
+// with the wrong contents are ignored.
+//
+//==========================================================================
+
+const char *FSharedLumpStore::Map (const char *path, const FSharedLumpKey &key, bool verify)
+{
+	const char *data;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return NULL;
+	}
+	LARGE_INTEGER filesize;
+	if (!GetFileSizeEx(file, &filesize) || filesize.QuadPart != key.Size)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+	{
+		return NULL;
+	}
+	// The view keeps the mapping alive on its own.
+	data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == NULL)
+	{
+		return NULL;
+	}
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size != key.Size)
+	{
+		close(fd);
+		return NULL;
+	}
+	void *view = mmap(NULL, key.Size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED)
+	{
+		return NULL;
+	}
+	data = (const char *)view;
+#endif
+
+	if (verify && CalcCRC32((const BYTE *)data, key.Size) != key.CRC)
+	{
+		Release(data, key.Size);
+		std::lock_guard<std::mutex> lock(StatsMutex);
+		Rejected++;
+		return NULL;
+	}
+
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	Mapped++;
+	MappedBytes += key.Size;
+	return data;
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: Find
+//
+// Can be called from any thread.
+//
+//==========================================================================
+
+const char *FSharedLumpStore::Find (const FSharedLumpKey &key)
+{
+	if (!Accepts(key.Size))
+	{
+		return NULL;
+	}
+	FString path = GetPath(key);
+	const char *data = Map(path, key, true);
+	if (data != NULL)
+	{
+		// Keep it from being trimmed before the lumps nobody uses anymore.
+		TouchFile(path);
+	}
+	return data;
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: Add
+//
+// Writes a freshly decompressed lump to the store and maps it. The file is
+// written under a temporary name first, so other processes never see it
+// half done. If the directory grows too large, the least recently used
+// lumps are deleted. Processes that still have them mapped keep their
+// copy. Can be called from any thread.
+//
+//==========================================================================
+
+const char *FSharedLumpStore::Add (const FSharedLumpKey &key, const char *data)
+{
+	static std::atomic<unsigned int> tempcounter(0);
+
+	if (!Accepts(key.Size))
+	{
+		return NULL;
+	}
+	// Don't let a lump that didn't decompress properly in.
+	if (CalcCRC32((const BYTE *)data, key.Size) != key.CRC)
+	{
+		return NULL;
+	}
+
+	FString path = GetPath(key);
+	FString temppath;
+#ifdef _WIN32
+	temppath.Format("%s.%d-%u.tmp", path.GetChars(), _getpid(), tempcounter++);
+#else
+	temppath.Format("%s.%d-%u.tmp", path.GetChars(), (int)getpid(), tempcounter++);
+#endif
+
+	FILE *file = fopen(temppath, "wb");
+	if (file == NULL)
+	{
+		return NULL;
+	}
+	bool ok = fwrite(data, 1, key.Size, file) == (size_t)key.Size;
+	ok = fclose(file) == 0 && ok;
+
+	// If another process got there first, its copy is just as good.
+	if (!ok || rename(temppath, path) != 0)
+	{
+		remove(temppath);
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(StatsMutex);
+			Stored++;
+		}
+		std::lock_guard<std::mutex> lock(TrimMutex);
+		DirectoryBytes += key.Size;
+		if (DirectoryBytes > MaxBytes)
+		{
+			// Leave some room so that not every new lump causes another scan.
+			DirectoryBytes = TrimDirectory(Directory, MaxBytes - MaxBytes / 4);
+			std::lock_guard<std::mutex> statslock(StatsMutex);
+			Trimmed++;
+		}
+	}
+	return Map(path, key, false);
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: Release
+//
+//==========================================================================
+
+void FSharedLumpStore::Release (const char *data, int size)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast<char *>(data), size);
+#endif
+}
+
+//==========================================================================
+//
+// FSharedLumpStore :: GetStats
+//
+//==========================================================================
+
+FString FSharedLumpStore::GetStats ()
+{
+	FString out;
+
+	if (!bEnabled)
+	{
+		out = "Not enabled";
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(StatsMutex);
+		out.Format("Mapped = %u (%u KB), stored = %u, rejected = %u, trimmed %u times",
+			Mapped, (unsigned int)(MappedBytes >> 10), Stored, Rejected, Trimmed);
+	}
+	return out;
+}
+
+ADD_STAT (sharedlumps)
+{
+	return FSharedLumpStore::Get().GetStats();
+}
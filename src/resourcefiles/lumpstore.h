@@ -0,0 +1,100 @@
+/*
+** lumpstore.h
+** A cache of decompressed lumps that several processes can map at once
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#ifndef __LUMPSTORE_H
+#define __LUMPSTORE_H
+
+#include <mutex>
+#include "doomtype.h"
+#include "zstring.h"
+
+// Identifies the decompressed contents of a lump. The hash covers the
+// compressed data and the compression method, so equal lumps in different
+// archives share one entry. The CRC, which zips store for every file,
+// catches truncated or damaged entries.
+struct FSharedLumpKey
+{
+	FSharedLumpKey () {}
+	FSharedLumpKey (const char *compressed, int compressedsize, int method, int size, DWORD crc);
+
+	BYTE Hash[16];
+	int Size;
+	DWORD CRC;
+};
+
+// With -sharedlumps, decompressed lumps are written to a directory, one
+// file per lump, and used from there through read-only shared mappings.
+// Every process that maps the same file uses the same physical pages, so
+// servers running the same mods on one machine decompress each lump only
+// once and keep only one copy of it in memory. When the directory grows
+// past its cap, the lumps that were used least recently are deleted.
+class FSharedLumpStore
+{
+public:
+	static FSharedLumpStore &Get ();
+
+	bool IsEnabled () const { return bEnabled; }
+
+	// Making a key hashes all of the lump's compressed data, so check this
+	// first to see whether the store would take a lump of this size at all.
+	bool Accepts (int size) const;
+
+	// Both return the mapped lump or NULL. The mapping must be given back
+	// with Release.
+	const char *Find (const FSharedLumpKey &key);
+	const char *Add (const FSharedLumpKey &key, const char *data);
+	static void Release (const char *data, int size);
+
+	FString GetStats ();
+
+private:
+	FSharedLumpStore ();
+
+	FString GetPath (const FSharedLumpKey &key) const;
+	const char *Map (const char *path, const FSharedLumpKey &key, bool verify);
+
+	FString Directory;
+	bool bEnabled;
+
+	std::mutex TrimMutex;
+	size_t MaxBytes;
+	size_t DirectoryBytes;		// What this process knows to be in the directory
+
+	std::mutex StatsMutex;
+	unsigned int Mapped, Stored, Rejected, Trimmed;
+	size_t MappedBytes;
+};
+
+#endif
@@ -264,7 +264,7 @@ FResourceFile *FResourceFile::OpenResourceFile(const char *filename, FileReader
 	{
 		try
 		{
-			file = new FileReader(filename);
+			file = MappedFileReader::OpenFile(filename);
 		}
 		catch (CRecoverableError &)
 		{
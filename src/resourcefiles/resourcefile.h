@@ -42,6 +42,7 @@ struct FResourceLump
 	virtual FileReader *NewReader();
 	virtual int GetFileOffset() { return -1; }
 	virtual int GetIndexNum() const { return 0; }
+	virtual void Prefetch() {}	// Starts decompressing the lump in the background, if supported
 	void LumpNameSetup(const char *iname);
 	void CheckEmbedded();
 
@@ -23,6 +23,7 @@
 #include "templates.h"
 #include "doomstat.h"
 #include "v_text.h"
+#include "startupprofile.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -51,6 +52,7 @@
 FScanner::FScanner()
 {
 	ScriptOpen = false;
+	ProfileLump = -1;
 }
 
 //==========================================================================
@@ -61,7 +63,7 @@ FScanner::FScanner()
 
 FScanner::~FScanner()
 {
-	// Humm... Nothing to do in here.
+	EndLumpProfile();
 }
 
 //==========================================================================
@@ -73,6 +75,7 @@ FScanner::~FScanner()
 FScanner::FScanner(const FScanner &other)
 {
 	ScriptOpen = false;
+	ProfileLump = -1;
 	*this = other;
 }
 
@@ -85,6 +88,7 @@ FScanner::FScanner(const FScanner &other)
 FScanner::FScanner(int lumpnum)
 {
 	ScriptOpen = false;
+	ProfileLump = -1;
 	OpenLumpNum(lumpnum);
 }
 
@@ -110,6 +114,7 @@ FScanner &FScanner::operator=(const FScanner &other)
 	ScriptOpen = true;
 	ScriptName = other.ScriptName;
 	ScriptBuffer = other.ScriptBuffer;
+	ScriptStartPtr = other.ScriptStartPtr;
 	ScriptPtr = other.ScriptPtr;
 	ScriptEndPtr = other.ScriptEndPtr;
 	AlreadyGot = other.AlreadyGot;
@@ -214,12 +219,28 @@ void FScanner::OpenMem (const char *name, const char *buffer, int size)
 void FScanner :: OpenLumpNum (int lump)
 {
 	Close ();
+	if (StartupProfile.TracksLumps())
 	{
-		FMemLump mem = Wads.ReadLump(lump);
-		ScriptBuffer = mem.GetString();
+		ProfileLump = lump;
+		ProfileStart = FStartupProfiler::Now();
 	}
 	ScriptName = Wads.GetLumpFullPath(lump);
 	LumpNum = lump;
+
+	// A lump stored uncompressed in a mapped file can be scanned right where
+	// it is, provided it already ends with the newline the scanner needs.
+	const char *text = Wads.GetLumpMemory(lump);
+	int length = Wads.LumpLength(lump);
+	if (text != NULL && length > 0 && text[length - 1] == '\n')
+	{
+		PrepareScript (text, length);
+		return;
+	}
+
+	{
+		FMemLump mem = Wads.ReadLump(lump);
+		ScriptBuffer = mem.GetString();
+	}
 	PrepareScript ();
 }
 
@@ -249,9 +270,22 @@ void FScanner::PrepareScript ()
 			ScriptBuffer += '\n';
 		}
 	}
+	PrepareScript (ScriptBuffer.GetChars(), ScriptBuffer.Len());
+}
+
+//==========================================================================
+//
+// FScanner :: PrepareScript
+//
+// Starts scanning the given text, which must end with a '\n' and stay
+// around until the scanner is closed.
+//
+//==========================================================================
 
-	ScriptPtr = &ScriptBuffer[0];
-	ScriptEndPtr = &ScriptBuffer[ScriptBuffer.Len()];
+void FScanner::PrepareScript (const char *text, size_t length)
+{
+	ScriptStartPtr = ScriptPtr = text;
+	ScriptEndPtr = text + length;
 	Line = 1;
 	End = false;
 	ScriptOpen = true;
@@ -274,6 +308,7 @@ void FScanner::PrepareScript ()
 
 void FScanner::Close ()
 {
+	EndLumpProfile();
 	ScriptOpen = false;
 	ScriptBuffer = "";
 	BigStringBuffer = "";
@@ -281,6 +316,21 @@ void FScanner::Close ()
 	String = StringBuffer;
 }
 
+//==========================================================================
+//
+// FScanner :: EndLumpProfile
+//
+//==========================================================================
+
+void FScanner::EndLumpProfile ()
+{
+	if (ProfileLump >= 0)
+	{
+		StartupProfile.AddLump (ProfileLump, ProfileStart);
+		ProfileLump = -1;
+	}
+}
+
 //==========================================================================
 //
 // FScanner :: SavePos
@@ -341,9 +391,11 @@ void FScanner::RestorePos (const FScanner::SavedPos &pos)
 
 bool FScanner::isText()
 {
-	for(unsigned int i=0;i<ScriptBuffer.Len();i++)
+	// Scripts opened in place don't use ScriptBuffer, so check the text that was
+	// passed to PrepareScript.
+	for(const char *p = ScriptStartPtr; p < ScriptEndPtr; p++)
 	{
-		int c = ScriptBuffer[i];
+		int c = (unsigned char)*p;
 		if (c < ' ' && c != '\n' && c != '\r' && c != '\t') return false;
 	}
 	return true;
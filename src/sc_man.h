@@ -78,7 +78,9 @@ public:
 
 protected:
 	void PrepareScript();
+	void PrepareScript(const char *text, size_t length);
 	void CheckOpen();
+	void EndLumpProfile();
 	bool ScanString(bool tokens);
 
 	// Strings longer than this minus one will be dynamically allocated.
@@ -86,6 +88,7 @@ protected:
 
 	bool ScriptOpen;
 	FString ScriptBuffer;
+	const char *ScriptStartPtr;
 	const char *ScriptPtr;
 	const char *ScriptEndPtr;
 	char StringBuffer[MAX_STRING_SIZE];
@@ -97,6 +100,8 @@ protected:
 	int LastGotLine;
 	bool CMode;
 	bool Escape;
+	int ProfileLump;		// Lump being timed for the startup profile, or -1
+	double ProfileStart;
 };
 
 enum
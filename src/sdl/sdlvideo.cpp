@@ -399,7 +399,7 @@ void SDLFB::Update ()
 
 	if (NotPaletted)
 	{
-		GPfx.Convert (MemBuffer, Pitch,
+		GPfx.ConvertThreaded (MemBuffer, Pitch,
 			Screen->pixels, Screen->pitch, Width, Height,
 			FRACUNIT, FRACUNIT, 0, 0);
 	}
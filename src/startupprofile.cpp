@@ -0,0 +1,309 @@
+/*
+** startupprofile.cpp
+** Measures where the time goes during startup
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include <chrono>
+#include <algorithm>
+
+#include "startupprofile.h"
+#include "m_argv.h"
+#include "c_dispatch.h"
+#include "w_wad.h"
+#include "doomtype.h"
+
+FStartupProfiler StartupProfile;
+
+//==========================================================================
+//
+// FStartupProfiler :: Node
+//
+//==========================================================================
+
+FStartupProfiler::Node::~Node ()
+{
+	for (unsigned int i = 0; i < Children.Size(); ++i)
+	{
+		delete Children[i];
+	}
+}
+
+FStartupProfiler::Node *FStartupProfiler::Node::FindChild (const char *name, bool lump)
+{
+	for (unsigned int i = 0; i < Children.Size(); ++i)
+	{
+		if (Children[i]->bLump == lump && Children[i]->Name.Compare(name) == 0)
+		{
+			return Children[i];
+		}
+	}
+	Node *child = new Node;
+	child->Name = name;
+	child->Start = 0;
+	child->Time = 0;
+	child->Count = 0;
+	child->bLump = lump;
+	child->Parent = this;
+	Children.Push(child);
+	return child;
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: FStartupProfiler
+//
+//==========================================================================
+
+FStartupProfiler::FStartupProfiler ()
+: Root(NULL), Current(NULL), bTrackLumps(false), bFinished(false)
+{
+}
+
+FStartupProfiler::~FStartupProfiler ()
+{
+	Clear ();
+}
+
+void FStartupProfiler::Clear ()
+{
+	if (Root != NULL)
+	{
+		delete Root;
+	}
+	Root = Current = NULL;
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: Now
+//
+//==========================================================================
+
+double FStartupProfiler::Now ()
+{
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: Start
+//
+// Called at the beginning of every (re)start.
+//
+//==========================================================================
+
+void FStartupProfiler::Start ()
+{
+	Clear ();
+	Root = new Node;
+	Root->Name = "Startup";
+	Root->Start = Now();
+	Root->Time = 0;
+	Root->Count = 1;
+	Root->bLump = false;
+	Root->Parent = NULL;
+	Current = Root;
+	bTrackLumps = Args->CheckParm ("-profilestartup") != 0;
+	bFinished = false;
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: Enter
+//
+//==========================================================================
+
+void FStartupProfiler::Enter (const char *name)
+{
+	if (Current == NULL)
+	{
+		return;
+	}
+	Current = Current->FindChild (name, false);
+	Current->Start = Now();
+	Current->Count++;
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: Leave
+//
+//==========================================================================
+
+void FStartupProfiler::Leave ()
+{
+	if (Current == NULL || Current == Root)
+	{
+		return;
+	}
+	Current->Time += Now() - Current->Start;
+	Current = Current->Parent;
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: Phase
+//
+// Ends whatever was running at the top level and starts the next phase.
+//
+//==========================================================================
+
+void FStartupProfiler::Phase (const char *name)
+{
+	while (Current != NULL && Current != Root)
+	{
+		Leave ();
+	}
+	Enter (name);
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: AddLump
+//
+// Called by FScanner when it's done with a lump it opened at start.
+//
+//==========================================================================
+
+void FStartupProfiler::AddLump (int lump, double start)
+{
+	if (Current == NULL || !bTrackLumps)
+	{
+		return;
+	}
+	Node *node = Current->FindChild (Wads.GetLumpFullPath (lump), true);
+	node->Time += Now() - start;
+	node->Count++;
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: Finish
+//
+//==========================================================================
+
+void FStartupProfiler::Finish ()
+{
+	if (Root == NULL || bFinished)
+	{
+		return;
+	}
+	while (Current != Root)
+	{
+		Leave ();
+	}
+	Root->Time = Now() - Root->Start;
+	Current = NULL;
+	bFinished = true;
+
+	if (bTrackLumps)
+	{
+		Print ();
+	}
+}
+
+//==========================================================================
+//
+// FStartupProfiler :: Print
+//
+//==========================================================================
+
+void FStartupProfiler::Print () const
+{
+	if (Root == NULL)
+	{
+		Printf ("No startup profile has been recorded.\n");
+	}
+	else if (!bFinished)
+	{
+		Printf ("Startup has not finished yet.\n");
+	}
+	else
+	{
+		PrintNode (Root, 0);
+	}
+}
+
+void FStartupProfiler::PrintNode (const Node *node, int depth) const
+{
+	// Lumps are listed slowest first and only the worst offenders are shown.
+	static const unsigned int MAX_LUMPS = 5;
+
+	if (node->Count > 1)
+	{
+		Printf ("%*s%-*s %9.2f ms (%u times)\n", depth * 2, "", 40 - depth * 2, node->Name.GetChars(), node->Time, node->Count);
+	}
+	else
+	{
+		Printf ("%*s%-*s %9.2f ms\n", depth * 2, "", 40 - depth * 2, node->Name.GetChars(), node->Time);
+	}
+
+	TArray<const Node *> lumps;
+	double lumptime = 0;
+	for (unsigned int i = 0; i < node->Children.Size(); ++i)
+	{
+		if (node->Children[i]->bLump)
+		{
+			lumps.Push (node->Children[i]);
+			lumptime += node->Children[i]->Time;
+		}
+		else
+		{
+			PrintNode (node->Children[i], depth + 1);
+		}
+	}
+	if (lumps.Size() > 0)
+	{
+		std::sort (&lumps[0], &lumps[0] + lumps.Size(), [](const Node *a, const Node *b) { return a->Time > b->Time; });
+		for (unsigned int i = 0; i < lumps.Size() && i < MAX_LUMPS; ++i)
+		{
+			PrintNode (lumps[i], depth + 1);
+		}
+		if (lumps.Size() > MAX_LUMPS)
+		{
+			Printf ("%*s(%u lumps, %.2f ms in total)\n", depth * 2 + 2, "", lumps.Size(), lumptime);
+		}
+	}
+}
+
+//==========================================================================
+//
+// CCMD startupprofile
+//
+//==========================================================================
+
+CCMD (startupprofile)
+{
+	StartupProfile.Print ();
+}
@@ -0,0 +1,90 @@
+/*
+** startupprofile.h
+** Measures where the time goes during startup
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#ifndef __STARTUPPROFILE_H
+#define __STARTUPPROFILE_H
+
+#include "tarray.h"
+#include "zstring.h"
+
+// Startup is divided into phases, which can be further divided with Enter
+// and Leave. With -profilestartup every script lump opened by FScanner is
+// recorded below the section that parsed it, and the results are printed
+// once startup is done.
+class FStartupProfiler
+{
+public:
+	FStartupProfiler ();
+	~FStartupProfiler ();
+
+	void Start ();
+	void Phase (const char *name);
+	void Enter (const char *name);
+	void Leave ();
+	void Finish ();
+	void Print () const;
+
+	bool TracksLumps () const { return bTrackLumps; }
+	void AddLump (int lump, double start);
+
+	static double Now ();	// in milliseconds
+
+private:
+	struct Node
+	{
+		FString Name;
+		double Start;
+		double Time;
+		unsigned int Count;
+		bool bLump;
+		Node *Parent;
+		TArray<Node *> Children;
+
+		~Node ();
+		Node *FindChild (const char *name, bool lump);
+	};
+
+	void Clear ();
+	void PrintNode (const Node *node, int depth) const;
+
+	Node *Root;
+	Node *Current;
+	bool bTrackLumps;
+	bool bFinished;
+};
+
+extern FStartupProfiler StartupProfile;
+
+#endif
@@ -52,6 +52,7 @@
 //-----------------------------------------------------------------------------
 
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <stdarg.h>
 #include <time.h>
@@ -123,8 +124,10 @@
 #include "d_protocol.h"
 #include "p_enemy.h"
 #include "network/packetarchive.h"
+#include "network/fullupdate.h"
 #include "p_lnspec.h"
 #include "unlagged.h"
+#include "sv_profile.h"
 
 //*****************************************************************************
 //	MISC CRAP THAT SHOULDN'T BE HERE BUT HAS TO BE BECAUSE OF SLOPPY CODING
@@ -139,6 +142,7 @@ void SERVERCONSOLE_ReListPlayers( void );
 EXTERN_CVAR( Bool, sv_cheats );
 EXTERN_CVAR( Bool, sv_showwarnings );
 EXTERN_CVAR( Bool, sv_unlagged_debugactors )
+EXTERN_CVAR( Bool, sv_selectiveack )
 
 //*****************************************************************************
 //	PROTOTYPES
@@ -149,6 +153,7 @@ static	bool	server_Ignore( BYTESTREAM_s *pByteStream );
 static	bool	server_Say( BYTESTREAM_s *pByteStream );
 static	bool	server_ClientMove( BYTESTREAM_s *pByteStream );
 static	bool	server_MissingPacket( BYTESTREAM_s *pByteStream );
+static	bool	server_AcknowledgePackets( BYTESTREAM_s *pByteStream );
 static	bool	server_UpdateClientPing( BYTESTREAM_s *pByteStream );
 static	bool	server_WeaponSelect( BYTESTREAM_s *pByteStream );
 static	bool	server_Taunt( BYTESTREAM_s *pByteStream );
@@ -177,6 +182,8 @@ static	bool	server_CheckJoinPassword( const FString& clientPassword );
 static	bool	server_InfoCheat( BYTESTREAM_s* pByteStream );
 static	bool	server_CheckLogin( const ULONG ulClient );
 static	void	server_PrintWithIP( FString message, const NETADDRESS_s &address );
+static	void	server_AnnouncePendingCountries( void );
+static	void	server_SendActorSnapshot( ULONG ulClient );
 
 // [RC]
 #ifdef CREATE_PACKET_LOG
@@ -195,6 +202,27 @@ static	LONG			g_lCurrentClient;
 // Number of ticks that have passed since start of... level?
 static	LONG			g_lGameTime = 0;
 
+// The tic scheduler. Tic n is due at g_qwTicBaseTime + n / TICRATE seconds,
+// so rounding never accumulates into drift.
+static	QWORD			g_qwTicBaseTime = 0;
+static	QWORD			g_qwScheduledTics = 0;
+
+// How late tics started (in microseconds) and how often the scheduler woke
+// up, over the last TICTIMING_WINDOW tics and over the window before it.
+enum { TICTIMING_WINDOW = 10 * TICRATE };
+
+struct TICTIMING_s
+{
+	ULONG	ulTics;
+	ULONG	ulWakeups;
+	ULONG	ulCatchUpTics;
+	double	dTotalLateUS;
+	double	dMaxLateUS;
+};
+
+static	TICTIMING_s		g_TicTiming;
+static	TICTIMING_s		g_LastTicTiming;
+
 #ifndef NO_SERVER_GUI
 // Storage for commands issued through various menu options to be executed all at once.
 static	TArray<FString>	g_ServerCommandQueue;
@@ -549,32 +577,94 @@ void			SERVERCONSOLE_UpdateStatistics( void );
 //*****************************************************************************
 //
 void SERVERCONSOLE_UpdateScoreboard( void );
-void SERVER_Tick( void )
+//*****************************************************************************
+//
+static QWORD server_GetNanoTime( void )
 {
-	LONG			lNowTime;
-	LONG			lNewTics;
-	LONG			lPreviousTics;
-	LONG			lCurTics;
-	ULONG			ulIdx;
+	return static_cast<QWORD>( std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now( ).time_since_epoch( )).count( ));
+}
 
-	I_DoSelect();
-	lPreviousTics = static_cast<LONG> ( g_lGameTime / (( 1.0 / TICRATE ) * 1000.0 ) );
+//*****************************************************************************
+//
+static QWORD server_GetTicDeadline( QWORD qwTic )
+{
+	return g_qwTicBaseTime + qwTic * 1000000000 / TICRATE;
+}
 
-	lNowTime = I_MSTime( );
-	lNewTics = static_cast<LONG> ( lNowTime / (( 1.0 / TICRATE ) * 1000.0 ) );
+//*****************************************************************************
+//
+// Blocks until the next tic is due and returns how many tics should run.
+// Packets are handled as they arrive while waiting.
+static LONG server_WaitForTics( void )
+{
+	QWORD qwNow = server_GetNanoTime( );
 
-	lCurTics = lNewTics - lPreviousTics;
-	while ( lCurTics <= 0 )
+	if ( g_qwTicBaseTime == 0 )
 	{
+		g_qwTicBaseTime = qwNow;
+		g_qwScheduledTics = 0;
+	}
+
+	QWORD qwDeadline = server_GetTicDeadline( g_qwScheduledTics );
+	while ( qwNow < qwDeadline )
+	{
+		// Sleep until a packet or console input arrives or the tic is due.
 		// [BB] Recieve packets whenever possible (not only once each tic) to allow
 		// for an accurate ping measurement.
-		SERVER_GetPackets( );
+		if ( I_DoSelect( static_cast<ULONG>(( qwDeadline - qwNow + 999 ) / 1000 )))
+			SERVER_GetPackets( );
+
+		g_TicTiming.ulWakeups++;
+		qwNow = server_GetNanoTime( );
+	}
 
-		I_Sleep( 1 );
-		lNowTime = I_MSTime( );
-		lNewTics = static_cast<LONG> ( lNowTime / (( 1.0 / TICRATE ) * 1000.0 ) );
-		lCurTics = lNewTics - lPreviousTics;
+	// Run every tic that is due by now, keeping them on the fixed grid.
+	LONG lTics = 0;
+	while ( qwDeadline <= qwNow )
+	{
+		const double dLateUS = ( qwNow - qwDeadline ) / 1000.0;
+		g_TicTiming.dTotalLateUS += dLateUS;
+		g_TicTiming.dMaxLateUS = MAX( g_TicTiming.dMaxLateUS, dLateUS );
+		g_TicTiming.ulTics++;
+
+		lTics++;
+		qwDeadline = server_GetTicDeadline( ++g_qwScheduledTics );
 	}
+	g_TicTiming.ulCatchUpTics += lTics - 1;
+
+	if ( g_TicTiming.ulTics >= TICTIMING_WINDOW )
+	{
+		g_LastTicTiming = g_TicTiming;
+		memset( &g_TicTiming, 0, sizeof( g_TicTiming ));
+	}
+
+	return ( lTics );
+}
+
+//*****************************************************************************
+//
+ADD_STAT( tictiming )
+{
+	FString	out;
+	const TICTIMING_s &Timing = g_LastTicTiming.ulTics ? g_LastTicTiming : g_TicTiming;
+
+	out.Format( "Tics: %lu, late avg %.0f us, max %.0f us, catch-up tics %lu, wakeups per tic %.1f",
+		Timing.ulTics, Timing.ulTics ? Timing.dTotalLateUS / Timing.ulTics : 0.0, Timing.dMaxLateUS,
+		Timing.ulCatchUpTics, Timing.ulTics ? static_cast<double>( Timing.ulWakeups ) / Timing.ulTics : 0.0 );
+	return ( out );
+}
+
+//*****************************************************************************
+//
+void SERVER_Tick( void )
+{
+	LONG			lNowTime;
+	LONG			lCurTics;
+	ULONG			ulIdx;
+
+	lCurTics = server_WaitForTics( );
+	lNowTime = I_MSTime( );
 
 #ifdef NO_SERVER_GUI
 	// console input
@@ -593,13 +683,18 @@ void SERVER_Tick( void )
 	{
 		//DObject::BeginFrame ();
 
+		SERVERPROFILE_BeginTick( );
+
 		// Recieve packets.
+		SERVERPROFILE_EnterPhase( SPP_GETPACKETS );
 		SERVER_GetPackets( );
 
 		// We have to record player positions before their mobj moves.
 		// [BB] Tick the unlagged module.
+		SERVERPROFILE_EnterPhase( SPP_UNLAGGED );
 		UNLAGGED_Tick( );
 
+		SERVERPROFILE_EnterPhase( SPP_GAMETICKER );
 		G_Ticker ();
 
 		// However we need to spawn the unlagged debug actors here i.e. after having processed their
@@ -611,6 +706,8 @@ void SERVER_Tick( void )
 		gametic++;
 		maketic++;
 
+		SERVERPROFILE_EnterPhase( SPP_OTHER );
+
 		// Update the scoreboard if we have a new second to display.
 		if ( timelimit && (( level.time % TICRATE ) == 0 ) && ( level.time != iOldTime ))
 		{
@@ -642,15 +739,19 @@ void SERVER_Tick( void )
 		}
 
 		// Drop anyone who's been disconnected.
+		SERVERPROFILE_EnterPhase( SPP_TIMEOUTS );
 		SERVER_CheckTimeouts( );
 
 		// Send out player's true position, etc.
+		SERVERPROFILE_EnterPhase( SPP_WRITECOMMANDS );
 		SERVER_WriteCommands( );
 
 		// Check everyone's PacketBuffer for anything that needs to be sent.
+		SERVERPROFILE_EnterPhase( SPP_SENDPACKETS );
 		SERVER_SendOutPackets( );
 
 		// [BB] Send out sheduled packets, respecting sv_maxpacketspertick.
+		SERVERPROFILE_EnterPhase( SPP_SAVEDPACKETS );
 		for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 		{
 			if ( g_aClients[ulIdx].State == CLS_FREE )
@@ -660,20 +761,28 @@ void SERVER_Tick( void )
 		}
 
 		// Potentially send an update to the master server.
+		SERVERPROFILE_EnterPhase( SPP_MASTER );
 		SERVER_MASTER_Tick( );
 
 		// Time out any old RCON sessions.
+		SERVERPROFILE_EnterPhase( SPP_RCON );
 		SERVER_RCON_Tick( );
 
 		// Broadcast the server signal so it can be detected on a LAN.
+		SERVERPROFILE_EnterPhase( SPP_MASTER );
 		SERVER_MASTER_Broadcast( );
 
 		// Potentially re-parse the banfile.
+		SERVERPROFILE_EnterPhase( SPP_BAN );
 		SERVERBAN_Tick( );
 
+		SERVERPROFILE_EnterPhase( SPP_OTHER );
+
 		// Print stats and get out.
 		FStat::PrintStat( );
 
+		server_AnnouncePendingCountries( );
+
 		for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 		{
 			if (( SERVER_IsValidClient( ulIdx ) == false ) || ( players[ulIdx].bSpectating ))
@@ -726,6 +835,8 @@ void SERVER_Tick( void )
 			SERVERCONSOLE_UpdateStatistics( );
 		}
 
+		SERVERPROFILE_EndTick( );
+
 		//DObject::EndFrame ();
 	}
 /*
@@ -1514,8 +1625,16 @@ void SERVER_ConnectNewPlayer( BYTESTREAM_s *pByteStream )
 		// [K6/BB] Show the player's country on connect, if the GeoIP db is available.
 		FString countryInfo;
 		// [BB] All players see the connect message, so only show the country code if the player doesn't want it to be hidden.
+		// We don't wait for the country to be looked up. If it isn't known yet, it's announced
+		// on its own once it is.
 		if ( NETWORK_IsGeoIPAvailable() && ( SERVER_GetClient( g_lCurrentClient )->bWantHideCountry == false ) )
-			countryInfo.AppendFormat ( " (from: %s)", NETWORK_GetCountryCodeFromAddress ( SERVER_GetClient( g_lCurrentClient )->Address ).GetChars() );
+		{
+			const FString country = NETWORK_GetCountryCodeFromAddress ( SERVER_GetClient( g_lCurrentClient )->Address );
+			if ( country.IsNotEmpty() )
+				countryInfo.AppendFormat ( " (from: %s)", country.GetChars() );
+			else
+				SERVER_GetClient( g_lCurrentClient )->bCountryPending = true;
+		}
 
 		FString message;
 		message.Format( "%s{ip} %s.%s\n", players[g_lCurrentClient].userinfo.GetName(),
@@ -1539,6 +1658,9 @@ void SERVER_ConnectNewPlayer( BYTESTREAM_s *pByteStream )
 	if ( g_aClients[g_lCurrentClient].State != CLS_SPAWNED )
 		SERVERCONSOLE_ReListPlayers( );
 
+	// Launchers need to see the new player.
+	SERVER_MASTER_InvalidateServerInfo( );
+
 	// Update this client's state. He's in the game now!
 	g_aClients[g_lCurrentClient].State = CLS_SPAWNED;
 
@@ -1764,6 +1886,7 @@ void SERVER_SetupNewConnection( BYTESTREAM_s *pByteStream, bool bNewPlayer )
 
 	// [BB] Save whether the clients wants his country to be hidden.
 	g_aClients[lClient].bWantHideCountry = !!( connectFlags & CCF_HIDECOUNTRY );
+	g_aClients[lClient].bCountryPending = false;
 
 	// [TP] Save whether or not the player wants to hide his account.
 	g_aClients[lClient].WantHideAccount = !!pByteStream->ReadByte();
@@ -1782,6 +1905,10 @@ void SERVER_SetupNewConnection( BYTESTREAM_s *pByteStream, bool bNewPlayer )
 	g_aClients[lClient].State = CLS_CHALLENGE;
 	g_aClients[lClient].Address = AddressFrom;
 
+	// Look up where the client is from while it's loading the level.
+	if ( NETWORK_IsGeoIPAvailable() )
+		NETWORK_RequestCountryCode( AddressFrom );
+
 	{
 		// Make sure the version matches.
 		if ( stricmp( clientVersion.GetChars(), DOTVERSIONSTR ) != 0 )
@@ -2131,6 +2258,7 @@ bool SERVER_GetUserInfo( BYTESTREAM_s *pByteStream, bool bAllowKick, bool bEnfor
 
 	// Also, update the scoreboard.
 	SERVERCONSOLE_UpdatePlayerInfo( g_lCurrentClient, UDF_NAME );
+	SERVER_MASTER_InvalidateServerInfo( );
 
 	// Success!
 	return ( true );
@@ -2243,11 +2371,9 @@ void SERVER_ClientError( ULONG ulClient, ULONG ulErrorCode )
 //
 void SERVER_SendFullUpdate( ULONG ulClient )
 {
-	AActor						*pActor;
 	ULONG						ulIdx;
 	player_t*					pPlayer;
 	AInventory					*pInventory;
-	TThinkerIterator<AActor>	Iterator;
 
 	// Send active players to the client.
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
@@ -2421,7 +2547,73 @@ void SERVER_SendFullUpdate( ULONG ulClient )
 		SERVERCOMMANDS_SetMapTime( ulClient, SVCF_ONLYTHISCLIENT );
 
 	// Go through all the items on the map, and tell the client to spawn those of which
-	// are important.
+	// are important. The result doesn't depend on the client, so if somebody else got
+	// a full update during this tic, just send him the same commands.
+	if ( FULLUPDATE_ReplayActorSnapshot( ulClient ) == false )
+	{
+		FULLUPDATE_BeginCapture( ulClient );
+		server_SendActorSnapshot( ulClient );
+		FULLUPDATE_EndCapture( );
+	}
+
+	// Tell clients the found/total item/secrets count.
+	if ( GAMEMODE_GetCurrentFlags() & GMF_COOPERATIVE )
+	{
+		SERVERCOMMANDS_SetMapNumFoundItems( ulClient, SVCF_ONLYTHISCLIENT );
+		SERVERCOMMANDS_SetMapNumTotalItems( ulClient, SVCF_ONLYTHISCLIENT );
+		SERVERCOMMANDS_SetMapNumFoundSecrets( ulClient, SVCF_ONLYTHISCLIENT );
+		SERVERCOMMANDS_SetMapNumTotalSecrets( ulClient, SVCF_ONLYTHISCLIENT );
+	}
+
+	// Also let the client know about any cameras set to textures.
+	FCanvasTextureInfo::UpdateToClient( ulClient );
+
+	// Send out any translations that have been edited since the start of the level.
+	for ( ulIdx = 0; ulIdx < g_EditedTranslationList.Size( ); ulIdx++ )
+	{
+		if ( g_EditedTranslationList[ulIdx].ulType == DLevelScript::PCD_TRANSLATIONRANGE1 )
+			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulPal1, g_EditedTranslationList[ulIdx].ulPal2 );
+		else
+			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulR1, g_EditedTranslationList[ulIdx].ulG1, g_EditedTranslationList[ulIdx].ulB1, g_EditedTranslationList[ulIdx].ulR2, g_EditedTranslationList[ulIdx].ulG2, g_EditedTranslationList[ulIdx].ulB2 );
+	}
+
+	// [BB] If the sky differs from the standard sky, let the client know about it.
+	if ( level.info 
+	     && ( ( stricmp( level.skypic1, level.info->skypic1 ) != 0 )
+	          || ( stricmp( level.skypic2, level.info->skypic2 ) != 0 ) )
+	   )
+	{
+		SERVERCOMMANDS_SetMapSky( ulClient, SVCF_ONLYTHISCLIENT );
+	}
+
+	// [EP] If the sky scroll speed is changed, let the client know about it.
+	if ( level.info && level.skyspeed1 != level.info->skyspeed1 )
+		SERVERCOMMANDS_SetMapSkyScrollSpeed( /*isSky1 =*/ true );
+	if ( level.info && level.skyspeed2 != level.info->skyspeed2 )
+		SERVERCOMMANDS_SetMapSkyScrollSpeed( /*isSky1 =*/ false );
+
+	// [BB]
+	SERVERCOMMANDS_SetDefaultSkybox( ulClient, SVCF_ONLYTHISCLIENT ); 
+
+	// [BB] Inform the client about the values of server mod cvars.
+	SERVER_SyncServerModCVars ( ulClient );
+
+	// [TP] Inform the client of the state of the join queue
+	SERVERCOMMANDS_SyncJoinQueue( ulClient, SVCF_ONLYTHISCLIENT );
+
+	// [BB] Let the client know that the full update is completed.
+	SERVERCOMMANDS_FullUpdateCompleted( ulClient );
+	// [BB] The client will let us know that it received the update.
+	SERVER_GetClient ( ulClient )->bFullUpdateIncomplete = true;
+}
+
+//*****************************************************************************
+//
+static void server_SendActorSnapshot( ULONG ulClient )
+{
+	AActor						*pActor;
+	TThinkerIterator<AActor>	Iterator;
+
 	while (( pActor = Iterator.Next( )))
 	{
 		// If the actor doesn't have a network ID, don't spawn it (it
@@ -2603,56 +2795,6 @@ void SERVER_SendFullUpdate( ULONG ulClient )
 				SERVERCOMMANDS_SetThingFrame( pActor, pActor->state, ulClient, SVCF_ONLYTHISCLIENT, false );
 		}
 	}
-
-	// Tell clients the found/total item/secrets count.
-	if ( GAMEMODE_GetCurrentFlags() & GMF_COOPERATIVE )
-	{
-		SERVERCOMMANDS_SetMapNumFoundItems( ulClient, SVCF_ONLYTHISCLIENT );
-		SERVERCOMMANDS_SetMapNumTotalItems( ulClient, SVCF_ONLYTHISCLIENT );
-		SERVERCOMMANDS_SetMapNumFoundSecrets( ulClient, SVCF_ONLYTHISCLIENT );
-		SERVERCOMMANDS_SetMapNumTotalSecrets( ulClient, SVCF_ONLYTHISCLIENT );
-	}
-
-	// Also let the client know about any cameras set to textures.
-	FCanvasTextureInfo::UpdateToClient( ulClient );
-
-	// Send out any translations that have been edited since the start of the level.
-	for ( ulIdx = 0; ulIdx < g_EditedTranslationList.Size( ); ulIdx++ )
-	{
-		if ( g_EditedTranslationList[ulIdx].ulType == DLevelScript::PCD_TRANSLATIONRANGE1 )
-			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulPal1, g_EditedTranslationList[ulIdx].ulPal2 );
-		else
-			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulR1, g_EditedTranslationList[ulIdx].ulG1, g_EditedTranslationList[ulIdx].ulB1, g_EditedTranslationList[ulIdx].ulR2, g_EditedTranslationList[ulIdx].ulG2, g_EditedTranslationList[ulIdx].ulB2 );
-	}
-
-	// [BB] If the sky differs from the standard sky, let the client know about it.
-	if ( level.info 
-	     && ( ( stricmp( level.skypic1, level.info->skypic1 ) != 0 )
-	          || ( stricmp( level.skypic2, level.info->skypic2 ) != 0 ) )
-	   )
-	{
-		SERVERCOMMANDS_SetMapSky( ulClient, SVCF_ONLYTHISCLIENT );
-	}
-
-	// [EP] If the sky scroll speed is changed, let the client know about it.
-	if ( level.info && level.skyspeed1 != level.info->skyspeed1 )
-		SERVERCOMMANDS_SetMapSkyScrollSpeed( /*isSky1 =*/ true );
-	if ( level.info && level.skyspeed2 != level.info->skyspeed2 )
-		SERVERCOMMANDS_SetMapSkyScrollSpeed( /*isSky1 =*/ false );
-
-	// [BB]
-	SERVERCOMMANDS_SetDefaultSkybox( ulClient, SVCF_ONLYTHISCLIENT ); 
-
-	// [BB] Inform the client about the values of server mod cvars.
-	SERVER_SyncServerModCVars ( ulClient );
-
-	// [TP] Inform the client of the state of the join queue
-	SERVERCOMMANDS_SyncJoinQueue( ulClient, SVCF_ONLYTHISCLIENT );
-
-	// [BB] Let the client know that the full update is completed.
-	SERVERCOMMANDS_FullUpdateCompleted( ulClient );
-	// [BB] The client will let us know that it received the update.
-	SERVER_GetClient ( ulClient )->bFullUpdateIncomplete = true;
 }
 
 //*****************************************************************************
@@ -2903,6 +3045,7 @@ void SERVER_DisconnectClient( ULONG ulClient, bool bBroadcast, bool bSaveInfo )
 
 	// Redo the scoreboard.
 	SERVERCONSOLE_ReListPlayers( );
+	SERVER_MASTER_InvalidateServerInfo( );
 
 	// [RC] Update clients using the RCON utility.
 	SERVER_RCON_UpdateInfo( SVRCU_PLAYERDATA );
@@ -4337,6 +4480,7 @@ bool SERVER_ProcessCommand( LONG lCommand, BYTESTREAM_s *pByteStream )
 	case CLC_QUIT:
 	case CLC_CLIENTMOVE:
 	case CLC_MISSINGPACKET:
+	case CLC_ACKNOWLEDGEPACKETS:
 	case CLC_PONG:
 	case CLC_SPECTATE:
 	case CLC_SPECTATEINFO:
@@ -4429,6 +4573,10 @@ bool SERVER_ProcessCommand( LONG lCommand, BYTESTREAM_s *pByteStream )
 
 		// Client is missing a packet; it's our job to resend it!
 		return ( server_MissingPacket( pByteStream ));
+	case CLC_ACKNOWLEDGEPACKETS:
+
+		// Client tells us which packets it received.
+		return ( server_AcknowledgePackets( pByteStream ));
 	case CLC_PONG:
 
 		// Ping response from client.
@@ -5346,6 +5494,19 @@ static bool server_MissingPacket( BYTESTREAM_s *pByteStream )
 	return ( false );
 }
 
+//*****************************************************************************
+//
+static bool server_AcknowledgePackets( BYTESTREAM_s *pByteStream )
+{
+	const LONG lLastContiguousPacket = pByteStream->ReadLong();
+	const ULONG ulReceivedMask = static_cast<ULONG>( pByteStream->ReadLong() );
+
+	if ( sv_selectiveack )
+		g_aClients[g_lCurrentClient].SavedPackets.AcknowledgePackets( lLastContiguousPacket, ulReceivedMask );
+
+	return ( false );
+}
+
 //*****************************************************************************
 //
 static bool server_UpdateClientPing( BYTESTREAM_s *pByteStream )
@@ -6600,6 +6761,34 @@ static void server_PrintWithIP( FString message, const NETADDRESS_s &address )
 	SERVERCOMMANDS_Print( message, PRINT_HIGH );
 }
 
+//*****************************************************************************
+//
+// Prints the countries that weren't looked up yet when their players connected.
+//
+static void server_AnnouncePendingCountries( void )
+{
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		if ( g_aClients[ulIdx].bCountryPending == false )
+			continue;
+
+		if ( SERVER_IsValidClient( ulIdx ) == false )
+		{
+			g_aClients[ulIdx].bCountryPending = false;
+			continue;
+		}
+
+		const FString country = NETWORK_GetCountryCodeFromAddress ( g_aClients[ulIdx].Address );
+		if ( country.IsEmpty() )
+			continue;
+
+		FString message;
+		message.Format( "%s{ip} is from %s.\n", players[ulIdx].userinfo.GetName(), country.GetChars() );
+		server_PrintWithIP( message, g_aClients[ulIdx].Address );
+		g_aClients[ulIdx].bCountryPending = false;
+	}
+}
+
 //*****************************************************************************
 //
 FString CLIENT_s::GetAccountName() const
@@ -7024,6 +7213,22 @@ CCMD( kickfromgame_idx )
 	Cmd_forcespec_idx( argv, who, key );
 }
 
+//*****************************************************************************
+CCMD( dumpreliablestats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		if ( SERVER_IsValidClient( ulIdx ) == false )
+			continue;
+
+		Printf( "%s: ", players[ulIdx].userinfo.GetName() );
+		g_aClients[ulIdx].SavedPackets.PrintStatistics( );
+	}
+}
+
 //*****************************************************************************
 #ifdef	_DEBUG
 CCMD( testchecksum )
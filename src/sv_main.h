@@ -291,6 +291,10 @@ struct CLIENT_s
 	// [BB] Client doesn't want his country to be revealed to the other players.
 	bool			bWantHideCountry;
 
+	// The connect message was printed before the client's country was looked up, so it's
+	// announced separately once the lookup is done.
+	bool			bCountryPending;
+
 	// [TP] Client doesn't want his account to be revealed to the other players.
 	bool			WantHideAccount;
 
@@ -520,6 +524,7 @@ void		SERVER_MASTER_Destruct( void );
 void		SERVER_MASTER_Tick( void );
 void		SERVER_MASTER_Broadcast( void );
 void		SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ulTime, ULONG ulFlags2, bool bBroadcasting );
+void		SERVER_MASTER_InvalidateServerInfo( void );
 const char	*SERVER_MASTER_GetGameName( void );
 NETADDRESS_s SERVER_MASTER_GetMasterAddress( void );
 void		SERVER_MASTER_HandleVerificationRequest( BYTESTREAM_s *pByteStream );
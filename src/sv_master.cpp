@@ -71,6 +71,33 @@
 #include "version.h"
 #include "d_dehacked.h"
 
+//*****************************************************************************
+//	DEFINES
+
+// Number of distinct flag combinations we keep a serialized reply for.
+#define	MAX_SERVERINFO_CACHE_ENTRIES	8
+
+//*****************************************************************************
+//	STRUCTURES
+
+//*****************************************************************************
+struct SERVERINFOCACHE_s
+{
+	// The (already sanitized) flags this reply was built for.
+	ULONG			ulBits;
+	ULONG			ulBits2;
+
+	// Server info epoch and gametic the reply was built at.
+	ULONG			ulEpoch;
+	LONG			lGametic;
+
+	// Everything after the launcher's time stamp.
+	TArray<BYTE>	Data;
+
+	// Has this entry been filled yet?
+	bool			bUsed;
+};
+
 //--------------------------------------------------------------------------------------------------------------------------------------------------
 //-- VARIABLES -------------------------------------------------------------------------------------------------------------------------------------
 //--------------------------------------------------------------------------------------------------------------------------------------------------
@@ -91,6 +118,21 @@ static	LONG				g_lStoredQueryIPHead;
 static	LONG				g_lStoredQueryIPTail;
 static	TArray<int>			g_OptionalWadIndices;
 
+// Maps the IPs in g_StoredQueryIPs to the gametic at which they may query us again.
+static	TMap<ULONG, LONG>	g_StoredQueryIPMap;
+
+// Recently sent server info replies, so that we don't need to build them for every launcher.
+static	SERVERINFOCACHE_s	g_ServerInfoCache[MAX_SERVERINFO_CACHE_ENTRIES];
+
+// Bumped whenever something that launchers are shown changes.
+static	ULONG				g_ulServerInfoEpoch;
+
+// Launcher query statistics.
+static	ULONG				g_ulNumServerInfoCacheHits;
+static	ULONG				g_ulNumServerInfoCacheMisses;
+static	ULONG				g_ulNumQueriesIgnored;
+static	ULONG				g_ulNumQueriesBanned;
+
 extern	NETADDRESS_s		g_LocalAddress;
 
 FString g_VersionWithOS;
@@ -98,6 +140,14 @@ FString g_VersionWithOS;
 //*****************************************************************************
 //	CONSOLE VARIABLES
 
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- PROTOTYPES ------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static	ULONG		server_master_GetIPKey( const NETADDRESS_s &Address );
+static	void		server_master_PopStoredQueryIP( void );
+static	void		server_master_WriteServerInfo( ULONG ulBits, ULONG ulBits2 );
+
 //--------------------------------------------------------------------------------------------------------------------------------------------------
 //-- FUNCTIONS -------------------------------------------------------------------------------------------------------------------------------------
 //--------------------------------------------------------------------------------------------------------------------------------------------------
@@ -124,6 +174,11 @@ void SERVER_MASTER_Construct( void )
 
 	g_lStoredQueryIPHead = 0;
 	g_lStoredQueryIPTail = 0;
+	g_StoredQueryIPMap.Clear( );
+
+	g_ulServerInfoEpoch = 0;
+	for ( ULONG ulIdx = 0; ulIdx < MAX_SERVERINFO_CACHE_ENTRIES; ulIdx++ )
+		g_ServerInfoCache[ulIdx].bUsed = false;
 
 #ifndef _WIN32
 	struct utsname u_name;
@@ -157,10 +212,7 @@ void SERVER_MASTER_Destruct( void )
 void SERVER_MASTER_Tick( void )
 {
 	while (( g_lStoredQueryIPHead != g_lStoredQueryIPTail ) && ( gametic >= g_StoredQueryIPs[g_lStoredQueryIPHead].lNextAllowedGametic ))
-	{
-		g_lStoredQueryIPHead++;
-		g_lStoredQueryIPHead = g_lStoredQueryIPHead % MAX_STORED_QUERY_IPS;
-	}
+		server_master_PopStoredQueryIP( );
 
 	// Send an update to the master server every 30 seconds.
 	if ( gametic % ( TICRATE * 30 ))
@@ -270,36 +322,27 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 
 	if ( bBroadcasting == false )
 	{
-		// First, check to see if we've been queried by this address recently.
-		if ( g_lStoredQueryIPHead != g_lStoredQueryIPTail )
+		// First, check to see if we've been queried by this address recently. If so, then
+		// ignore it, since it queried us less than sv_queryignoretime seconds ago.
+		const LONG *plNextAllowedGametic = g_StoredQueryIPMap.CheckKey( server_master_GetIPKey( Address ));
+		if (( plNextAllowedGametic != NULL ) && ( gametic < *plNextAllowedGametic ))
 		{
-			ulIdx = g_lStoredQueryIPHead;
-			while ( ulIdx != (ULONG)g_lStoredQueryIPTail )
-			{
-				// Check to see if this IP exists in our stored query IP list. If it does, then
-				// ignore it, since it queried us less than 10 seconds ago.
-				if ( Address.CompareNoPort( g_StoredQueryIPs[ulIdx].Address ))
-				{
-					// Write our header.
-					g_MasterServerBuffer.ByteStream.WriteLong( SERVER_LAUNCHER_IGNORING );
+			// Write our header.
+			g_MasterServerBuffer.ByteStream.WriteLong( SERVER_LAUNCHER_IGNORING );
 
-					// Send the time the launcher sent to us.
-					g_MasterServerBuffer.ByteStream.WriteLong( ulTime );
+			// Send the time the launcher sent to us.
+			g_MasterServerBuffer.ByteStream.WriteLong( ulTime );
 
-					// Send the packet.
-	//				NETWORK_LaunchPacket( &g_MasterServerBuffer, Address, true );
-					NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
+			// Send the packet.
+			NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
 
-					if ( sv_showlauncherqueries )
-						Printf( "Ignored IP launcher challenge.\n" );
+			if ( sv_showlauncherqueries )
+				Printf( "Ignored IP launcher challenge.\n" );
 
-					// Nothing more to do here.
-					return;
-				}
+			g_ulNumQueriesIgnored++;
 
-				ulIdx++;
-				ulIdx = ulIdx % MAX_STORED_QUERY_IPS;
-			}
+			// Nothing more to do here.
+			return;
 		}
 	
 		// Now, check to see if this IP has been banend from this server.
@@ -318,30 +361,26 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 			if ( sv_showlauncherqueries )
 				Printf( "Denied BANNED IP launcher challenge.\n" );
 
+			g_ulNumQueriesBanned++;
+
 			// Nothing more to do here.
 			return;
 		}
 
 		// This IP didn't exist in the list. and it wasn't banned. 
-		// So, add it, and keep it there for 10 seconds.
+		// So, add it, and keep it there for sv_queryignoretime seconds. If the list
+		// is full, the oldest entry has to make room for it.
+		if ((( g_lStoredQueryIPTail + 1 ) % MAX_STORED_QUERY_IPS ) == g_lStoredQueryIPHead )
+			server_master_PopStoredQueryIP( );
+
 		g_StoredQueryIPs[g_lStoredQueryIPTail].Address = Address;
 		g_StoredQueryIPs[g_lStoredQueryIPTail].lNextAllowedGametic = gametic + ( TICRATE * ( sv_queryignoretime ));
+		g_StoredQueryIPMap[server_master_GetIPKey( Address )] = g_StoredQueryIPs[g_lStoredQueryIPTail].lNextAllowedGametic;
 
 		g_lStoredQueryIPTail++;
 		g_lStoredQueryIPTail = g_lStoredQueryIPTail % MAX_STORED_QUERY_IPS;
-		if ( g_lStoredQueryIPTail == g_lStoredQueryIPHead )
-			Printf( "SERVER_MASTER_SendServerInfo: WARNING! g_lStoredQueryIPTail == g_lStoredQueryIPHead\n" );
 	}
 
-	// Write our header.
-	g_MasterServerBuffer.ByteStream.WriteLong( SERVER_LAUNCHER_CHALLENGE );
-
-	// Send the time the launcher sent to us.
-	g_MasterServerBuffer.ByteStream.WriteLong( ulTime );
-
-	// Send our version. [K6] ...with OS
-	g_MasterServerBuffer.ByteStream.WriteString( g_VersionWithOS.GetChars() );
-
 	// Send the information about the data that will be sent.
 	ulBits = ulFlags;
 
@@ -378,6 +417,104 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 	if ( ulFlags2 == 0 )
 		ulBits &= ~SQF_EXTENDED_INFO;
 
+	if ( ulBits & SQF_EXTENDED_INFO )
+		ulBits2 = ulFlags2 & SQF2_ALL;
+	else
+		ulBits2 = 0;
+
+	// Write our header.
+	g_MasterServerBuffer.ByteStream.WriteLong( SERVER_LAUNCHER_CHALLENGE );
+
+	// Send the time the launcher sent to us.
+	g_MasterServerBuffer.ByteStream.WriteLong( ulTime );
+
+	// Everything that follows only depends on the flags and the state of the server, so
+	// see if we've already built it recently. Pings and times change constantly without
+	// bumping the epoch, so replies are only reused for a second.
+	SERVERINFOCACHE_s *pEntry = NULL;
+	SERVERINFOCACHE_s *pOldestEntry = &g_ServerInfoCache[0];
+	for ( ulIdx = 0; ulIdx < MAX_SERVERINFO_CACHE_ENTRIES; ulIdx++ )
+	{
+		SERVERINFOCACHE_s &Entry = g_ServerInfoCache[ulIdx];
+
+		if (( Entry.bUsed ) && ( Entry.ulBits == ulBits ) && ( Entry.ulBits2 == ulBits2 ))
+		{
+			pEntry = &Entry;
+			break;
+		}
+
+		if (( Entry.bUsed == false ) || (( pOldestEntry->bUsed ) && ( Entry.lGametic < pOldestEntry->lGametic )))
+			pOldestEntry = &Entry;
+	}
+
+	if (( pEntry != NULL ) && ( pEntry->ulEpoch == g_ulServerInfoEpoch ) && (( gametic - pEntry->lGametic ) < TICRATE ))
+	{
+		g_MasterServerBuffer.ByteStream.WriteBuffer( &pEntry->Data[0], pEntry->Data.Size( ));
+		g_ulNumServerInfoCacheHits++;
+	}
+	else
+	{
+		const LONG lStart = g_MasterServerBuffer.CalcSize( );
+		server_master_WriteServerInfo( ulBits, ulBits2 );
+
+		// Store the reply for the next launcher that asks the same thing.
+		if ( pEntry == NULL )
+			pEntry = pOldestEntry;
+
+		pEntry->ulBits = ulBits;
+		pEntry->ulBits2 = ulBits2;
+		pEntry->ulEpoch = g_ulServerInfoEpoch;
+		pEntry->lGametic = gametic;
+		pEntry->bUsed = true;
+		pEntry->Data.Resize( g_MasterServerBuffer.CalcSize( ) - lStart );
+		memcpy( &pEntry->Data[0], g_MasterServerBuffer.pbData + lStart, pEntry->Data.Size( ));
+		g_ulNumServerInfoCacheMisses++;
+	}
+
+//	NETWORK_LaunchPacket( &g_MasterServerBuffer, Address, true );
+	NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
+}
+
+//*****************************************************************************
+//
+void SERVER_MASTER_InvalidateServerInfo( void )
+{
+	g_ulServerInfoEpoch++;
+}
+
+//*****************************************************************************
+//
+static ULONG server_master_GetIPKey( const NETADDRESS_s &Address )
+{
+	return (( static_cast<ULONG>( Address.abIP[0] ) << 24 ) | ( Address.abIP[1] << 16 ) | ( Address.abIP[2] << 8 ) | Address.abIP[3] );
+}
+
+//*****************************************************************************
+//
+static void server_master_PopStoredQueryIP( void )
+{
+	const STORED_QUERY_IP_s &StoredIP = g_StoredQueryIPs[g_lStoredQueryIPHead];
+	const ULONG ulKey = server_master_GetIPKey( StoredIP.Address );
+	const LONG *plNextAllowedGametic = g_StoredQueryIPMap.CheckKey( ulKey );
+
+	// Only forget the IP if it wasn't stored again later on.
+	if (( plNextAllowedGametic != NULL ) && ( *plNextAllowedGametic == StoredIP.lNextAllowedGametic ))
+		g_StoredQueryIPMap.Remove( ulKey );
+
+	g_lStoredQueryIPHead++;
+	g_lStoredQueryIPHead = g_lStoredQueryIPHead % MAX_STORED_QUERY_IPS;
+}
+
+//*****************************************************************************
+//
+// Writes the part of the server info reply that follows the launcher's time stamp.
+static void server_master_WriteServerInfo( ULONG ulBits, ULONG ulBits2 )
+{
+	ULONG		ulIdx;
+
+	// Send our version. [K6] ...with OS
+	g_MasterServerBuffer.ByteStream.WriteString( g_VersionWithOS.GetChars() );
+
 	g_MasterServerBuffer.ByteStream.WriteLong( ulBits );
 
 	// Send the server name.
@@ -607,9 +744,6 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 	// [SB] handle extended flags
 	if ( ulBits & SQF_EXTENDED_INFO ) 
 	{
-		ulBits2 = ulFlags2;
-		ulBits2 &= SQF2_ALL;
-
 		g_MasterServerBuffer.ByteStream.WriteLong( ulBits2 );
 
 		// [SB] send MD5 hashes of PWADs
@@ -621,9 +755,6 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 				g_MasterServerBuffer.ByteStream.WriteString( NETWORK_GetPWADList()[i].checksum );
 		}
 	}
-
-//	NETWORK_LaunchPacket( &g_MasterServerBuffer, Address, true );
-	NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
 }
 
 //*****************************************************************************
@@ -724,6 +855,17 @@ CVAR( String, sv_hostemail, "", CVAR_ARCHIVE|CVAR_NOSETBYACS|CVAR_SERVERINFO )
 // [BB] Client and server use this now, therefore the name doesn't begin with "sv_"
 CVAR( String, masterhostname, "master.zandronum.com", CVAR_ARCHIVE|CVAR_GLOBALCONFIG|CVAR_NOSETBYACS )
 
+CCMD( dumplauncherquerystats )
+{
+	const ULONG ulNumAnswered = g_ulNumServerInfoCacheHits + g_ulNumServerInfoCacheMisses;
+
+	Printf( "Answered queries: %lu (%lu from cache, %.1f%%)\n", ulNumAnswered, g_ulNumServerInfoCacheHits,
+		( ulNumAnswered > 0 ) ? ( 100.0 * g_ulNumServerInfoCacheHits / ulNumAnswered ) : 0.0 );
+	Printf( "Ignored queries: %lu\n", g_ulNumQueriesIgnored );
+	Printf( "Banned queries: %lu\n", g_ulNumQueriesBanned );
+	Printf( "Stored query IPs: %u\n", g_StoredQueryIPMap.CountUsed( ));
+}
+
 CCMD( wads )
 {
 	Printf( "IWAD: %s\n", NETWORK_GetIWAD( ) );
@@ -0,0 +1,394 @@
+/*
+** sv_profile.cpp
+** Per-phase timings of the server tick
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "sv_profile.h"
+#include "benchmark.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "dobject.h"
+#include "network.h"
+#include "tarray.h"
+#include "zstring.h"
+
+//*****************************************************************************
+//	DEFINES
+
+enum
+{
+	// Ticks kept for the percentiles. At 35 tics per second this is about a minute.
+	PROFILE_HISTORY = 2048,
+
+	// The slow tick report is printed at most this often.
+	SLOWTICK_INTERVAL = TICRATE,
+
+	// How often sv_profile_statsfile is rewritten.
+	STATSFILE_INTERVAL = 5 * TICRATE,
+
+	// Thinker classes listed in reports.
+	TOP_THINKERCLASSES = 10
+};
+
+static const char *g_pszPhaseNames[NUM_SERVERPROFILEPHASES] =
+{
+	"getpackets",
+	"unlagged",
+	"gameticker",
+	"timeouts",
+	"writecommands",
+	"sendpackets",
+	"savedpackets",
+	"master",
+	"rcon",
+	"ban",
+	"other",
+	"thinkers",
+	"acs",
+	"lineattack",
+	"sight",
+	"commands",
+};
+
+struct THINKERCLASSPROFILE_s
+{
+	THINKERCLASSPROFILE_s( ) : dMS( 0 ), ulCount( 0 ) { }
+
+	double	dMS;
+	ULONG	ulCount;
+};
+
+//*****************************************************************************
+//	VARIABLES
+
+bool	g_bServerProfileActive = false;
+
+static	cycle_t		g_PhaseCycles[NUM_SERVERPROFILEPHASES];
+static	ULONG		g_ulPhaseCalls[NUM_SERVERPROFILEPHASES];
+static	int			g_iPhaseDepth[NUM_SERVERPROFILEPHASES];
+static	int			g_iCurrentPhase = -1;
+
+// One column per phase plus the whole tick, PROFILE_HISTORY rows deep.
+static	float		g_fHistory[NUM_SERVERPROFILEPHASES + 1][PROFILE_HISTORY];
+static	ULONG		g_ulHistoryPos = 0;
+static	ULONG		g_ulHistoryCount = 0;
+static	float		g_fMaxTick = 0;
+
+static	TMap<const PClass *, THINKERCLASSPROFILE_s>	g_TickThinkers;
+static	TMap<const PClass *, THINKERCLASSPROFILE_s>	g_TotalThinkers;
+static	bool		g_bProfilingThinkers = false;
+
+static	LONG		g_lLastSlowTickReport = -SLOWTICK_INTERVAL;
+static	ULONG		g_ulSuppressedSlowTicks = 0;
+static	ULONG		g_ulTicksSinceStatsFile = 0;
+
+//*****************************************************************************
+//	CONSOLE VARIABLES
+
+// Times the phases of every server tick.
+CVAR( Bool, sv_profile, false, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// Also times every thinker by class. This costs a timer per thinker per tick.
+CVAR( Bool, sv_profile_thinkers, false, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// Ticks that take longer than this many milliseconds are reported. 0 disables the report.
+CVAR( Float, sv_profile_slowtick, 50.f, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// If set, the percentiles of all phases are written to this file every few seconds.
+CVAR( String, sv_profile_statsfile, "", CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+//*****************************************************************************
+//	FUNCTIONS
+
+void SERVERPROFILE_BeginTick( void )
+{
+	if ( sv_profile == false )
+		return;
+
+	for ( ULONG ulIdx = 0; ulIdx < NUM_SERVERPROFILEPHASES; ulIdx++ )
+	{
+		g_PhaseCycles[ulIdx].Reset( );
+		g_ulPhaseCalls[ulIdx] = 0;
+		g_iPhaseDepth[ulIdx] = 0;
+	}
+	g_iCurrentPhase = -1;
+	g_bProfilingThinkers = sv_profile_thinkers;
+	g_TickThinkers.Clear( );
+	g_bServerProfileActive = true;
+}
+
+//*****************************************************************************
+//
+void SERVERPROFILE_EnterPhase( SERVERPROFILEPHASE_e Phase )
+{
+	if ( g_bServerProfileActive == false )
+		return;
+
+	if ( g_iCurrentPhase >= 0 )
+		g_PhaseCycles[g_iCurrentPhase].Unclock( );
+
+	g_PhaseCycles[Phase].Clock( );
+	g_ulPhaseCalls[Phase]++;
+	g_iCurrentPhase = Phase;
+}
+
+//*****************************************************************************
+//
+void SERVERPROFILE_StartTimer( SERVERPROFILEPHASE_e Phase )
+{
+	// Only the outermost call is timed so recursion isn't counted twice.
+	if ( g_iPhaseDepth[Phase]++ == 0 )
+		g_PhaseCycles[Phase].Clock( );
+	g_ulPhaseCalls[Phase]++;
+}
+
+//*****************************************************************************
+//
+void SERVERPROFILE_StopTimer( SERVERPROFILEPHASE_e Phase )
+{
+	if ( --g_iPhaseDepth[Phase] == 0 )
+		g_PhaseCycles[Phase].Unclock( );
+}
+
+//*****************************************************************************
+//
+bool SERVERPROFILE_IsProfilingThinkers( void )
+{
+	return ( g_bServerProfileActive && g_bProfilingThinkers );
+}
+
+//*****************************************************************************
+//
+void SERVERPROFILE_AddThinkerTime( const PClass *pClass, double dMS )
+{
+	THINKERCLASSPROFILE_s &Tick = g_TickThinkers[pClass];
+	Tick.dMS += dMS;
+	Tick.ulCount++;
+
+	THINKERCLASSPROFILE_s &Total = g_TotalThinkers[pClass];
+	Total.dMS += dMS;
+	Total.ulCount++;
+}
+
+//*****************************************************************************
+//
+// Lists the thinker classes that took the most time, slowest first.
+static void serverprofile_PrintTopThinkers( TMap<const PClass *, THINKERCLASSPROFILE_s> &Map, const char *pszTitle )
+{
+	TArray<TMap<const PClass *, THINKERCLASSPROFILE_s>::Pair *>	Sorted;
+	TMap<const PClass *, THINKERCLASSPROFILE_s>::Iterator		it( Map );
+	TMap<const PClass *, THINKERCLASSPROFILE_s>::Pair			*pPair;
+
+	while ( it.NextPair( pPair ))
+		Sorted.Push( pPair );
+
+	if ( Sorted.Size( ) == 0 )
+		return;
+
+	std::sort( &Sorted[0], &Sorted[0] + Sorted.Size( ),
+		[]( TMap<const PClass *, THINKERCLASSPROFILE_s>::Pair *a, TMap<const PClass *, THINKERCLASSPROFILE_s>::Pair *b )
+		{ return a->Value.dMS > b->Value.dMS; } );
+
+	Printf( "%s\n", pszTitle );
+	for ( ULONG ulIdx = 0; ulIdx < Sorted.Size( ) && ulIdx < TOP_THINKERCLASSES; ulIdx++ )
+	{
+		Printf( "  %-32s %9.3f ms %8lu calls\n", Sorted[ulIdx]->Key->TypeName.GetChars( ),
+			Sorted[ulIdx]->Value.dMS, Sorted[ulIdx]->Value.ulCount );
+	}
+}
+
+//*****************************************************************************
+//
+static void serverprofile_ReportSlowTick( float fTotal )
+{
+	if ( gametic - g_lLastSlowTickReport < SLOWTICK_INTERVAL )
+	{
+		g_ulSuppressedSlowTicks++;
+		return;
+	}
+
+	Printf( "Slow tick %d on %s: %.3f ms", gametic, level.mapname, fTotal );
+	if ( g_ulSuppressedSlowTicks > 0 )
+		Printf( " (%lu more slow ticks since the last report)", g_ulSuppressedSlowTicks );
+	Printf( "\n" );
+
+	for ( ULONG ulIdx = 0; ulIdx < NUM_SERVERPROFILEPHASES; ulIdx++ )
+	{
+		Printf( "  %-14s %9.3f ms %6lu calls\n", g_pszPhaseNames[ulIdx],
+			g_PhaseCycles[ulIdx].TimeMS( ), g_ulPhaseCalls[ulIdx] );
+	}
+	serverprofile_PrintTopThinkers( g_TickThinkers, "Thinker classes in this tick:" );
+
+	g_lLastSlowTickReport = gametic;
+	g_ulSuppressedSlowTicks = 0;
+}
+
+//*****************************************************************************
+//
+// Fills Sorted with the recorded times of one column, sorted.
+static void serverprofile_GetSortedHistory( ULONG ulColumn, TArray<float> &Sorted )
+{
+	Sorted.Resize( g_ulHistoryCount );
+	for ( ULONG ulIdx = 0; ulIdx < g_ulHistoryCount; ulIdx++ )
+		Sorted[ulIdx] = g_fHistory[ulColumn][ulIdx];
+
+	if ( g_ulHistoryCount > 0 )
+		std::sort( &Sorted[0], &Sorted[0] + g_ulHistoryCount );
+}
+
+//*****************************************************************************
+//
+static const char *serverprofile_ColumnName( ULONG ulColumn )
+{
+	return ( ulColumn < NUM_SERVERPROFILEPHASES ) ? g_pszPhaseNames[ulColumn] : "tick";
+}
+
+//*****************************************************************************
+//
+// Writes the percentiles of every phase as JSON, for external monitoring.
+static void serverprofile_WriteStatsFile( const char *pszFileName )
+{
+	FString	TempName;
+	TempName.Format( "%s.tmp", pszFileName );
+
+	FILE *pFile = fopen( TempName, "w" );
+	if ( pFile == NULL )
+		return;
+
+	TArray<float>	Sorted;
+
+	fprintf( pFile, "{\n\t\"gametic\": %d,\n\t\"ticks\": %lu,\n\t\"phases\": {\n", gametic, g_ulHistoryCount );
+	for ( ULONG ulColumn = 0; ulColumn <= NUM_SERVERPROFILEPHASES; ulColumn++ )
+	{
+		serverprofile_GetSortedHistory( ulColumn, Sorted );
+		fprintf( pFile, "\t\t\"%s\": { \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+			serverprofile_ColumnName( ulColumn ), BENCHMARK_Percentile( Sorted, 50 ),
+			BENCHMARK_Percentile( Sorted, 99 ), Sorted.Size( ) ? Sorted[Sorted.Size( ) - 1] : 0.f,
+			( ulColumn < NUM_SERVERPROFILEPHASES ) ? "," : "" );
+	}
+	fprintf( pFile, "\t}\n}\n" );
+	fclose( pFile );
+
+	// Replace the old file in one step so readers never see a partial one.
+	// Windows can't rename over an existing file, so there it briefly
+	// doesn't exist at all.
+#ifdef _WIN32
+	remove( pszFileName );
+#endif
+	if ( rename( TempName, pszFileName ) != 0 )
+		remove( TempName );
+}
+
+//*****************************************************************************
+//
+void SERVERPROFILE_EndTick( void )
+{
+	if ( g_bServerProfileActive == false )
+		return;
+
+	if ( g_iCurrentPhase >= 0 )
+		g_PhaseCycles[g_iCurrentPhase].Unclock( );
+	g_iCurrentPhase = -1;
+	g_bServerProfileActive = false;
+
+	float fTotal = 0;
+	for ( ULONG ulIdx = 0; ulIdx < NUM_SERVERPROFILEPHASES; ulIdx++ )
+	{
+		const float fMS = static_cast<float>( g_PhaseCycles[ulIdx].TimeMS( ));
+		g_fHistory[ulIdx][g_ulHistoryPos] = fMS;
+		if ( ulIdx < NUM_SERVERTICKPHASES )
+			fTotal += fMS;
+	}
+	g_fHistory[NUM_SERVERPROFILEPHASES][g_ulHistoryPos] = fTotal;
+	g_ulHistoryPos = ( g_ulHistoryPos + 1 ) % PROFILE_HISTORY;
+	if ( g_ulHistoryCount < PROFILE_HISTORY )
+		g_ulHistoryCount++;
+	g_fMaxTick = MAX( g_fMaxTick, fTotal );
+
+	if (( sv_profile_slowtick > 0 ) && ( fTotal > sv_profile_slowtick ))
+		serverprofile_ReportSlowTick( fTotal );
+
+	if (( ++g_ulTicksSinceStatsFile >= STATSFILE_INTERVAL ) && ( strlen( sv_profile_statsfile ) > 0 ))
+	{
+		g_ulTicksSinceStatsFile = 0;
+		serverprofile_WriteStatsFile( sv_profile_statsfile );
+	}
+}
+
+//*****************************************************************************
+//	CONSOLE COMMANDS
+
+CCMD( sv_profile_dump )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	if ( g_ulHistoryCount == 0 )
+	{
+		Printf( "No server ticks have been profiled yet. Set sv_profile to true first.\n" );
+		return;
+	}
+
+	TArray<float>	Sorted;
+
+	Printf( "Last %lu ticks (slowest tick since reset: %.3f ms):\n", g_ulHistoryCount, g_fMaxTick );
+	Printf( "  %-14s %9s %9s %9s %9s\n", "phase", "mean", "p50", "p99", "max" );
+	for ( ULONG ulColumn = 0; ulColumn <= NUM_SERVERPROFILEPHASES; ulColumn++ )
+	{
+		double dSum = 0;
+
+		serverprofile_GetSortedHistory( ulColumn, Sorted );
+		for ( ULONG ulIdx = 0; ulIdx < Sorted.Size( ); ulIdx++ )
+			dSum += Sorted[ulIdx];
+
+		Printf( "  %-14s %9.3f %9.3f %9.3f %9.3f\n", serverprofile_ColumnName( ulColumn ),
+			dSum / Sorted.Size( ), BENCHMARK_Percentile( Sorted, 50 ),
+			BENCHMARK_Percentile( Sorted, 99 ), Sorted[Sorted.Size( ) - 1] );
+	}
+	serverprofile_PrintTopThinkers( g_TotalThinkers, "Thinker classes since reset:" );
+}
+
+//*****************************************************************************
+//
+CCMD( sv_profile_reset )
+{
+	g_ulHistoryPos = 0;
+	g_ulHistoryCount = 0;
+	g_fMaxTick = 0;
+	g_TotalThinkers.Clear( );
+}
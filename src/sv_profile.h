@@ -0,0 +1,112 @@
+/*
+** sv_profile.h
+** Per-phase timings of the server tick
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#ifndef __SV_PROFILE_H__
+#define __SV_PROFILE_H__
+
+#include "stats.h"
+
+class PClass;
+
+//*****************************************************************************
+//	DEFINES
+
+enum SERVERPROFILEPHASE_e
+{
+	// The parts of SERVER_Tick, in the order they run.
+	SPP_GETPACKETS,
+	SPP_UNLAGGED,
+	SPP_GAMETICKER,
+	SPP_TIMEOUTS,
+	SPP_WRITECOMMANDS,
+	SPP_SENDPACKETS,
+	SPP_SAVEDPACKETS,
+	SPP_MASTER,
+	SPP_RCON,
+	SPP_BAN,
+	SPP_OTHER,
+
+	// Hot spots inside the phases above. Their time is included there too.
+	SPP_THINKERS,
+	SPP_ACS,
+	SPP_LINEATTACK,
+	SPP_SIGHT,
+	SPP_COMMANDS,
+
+	NUM_SERVERPROFILEPHASES,
+	NUM_SERVERTICKPHASES = SPP_OTHER + 1
+};
+
+//*****************************************************************************
+//	PROTOTYPES
+
+void	SERVERPROFILE_BeginTick( void );
+void	SERVERPROFILE_EnterPhase( SERVERPROFILEPHASE_e Phase );
+void	SERVERPROFILE_EndTick( void );
+
+void	SERVERPROFILE_StartTimer( SERVERPROFILEPHASE_e Phase );
+void	SERVERPROFILE_StopTimer( SERVERPROFILEPHASE_e Phase );
+
+bool	SERVERPROFILE_IsProfilingThinkers( void );
+void	SERVERPROFILE_AddThinkerTime( const PClass *pClass, double dMS );
+
+// True only while a profiled server tick is running, so the timers cost
+// a single test everywhere else.
+extern	bool	g_bServerProfileActive;
+
+//*****************************************************************************
+//
+// Times a hot spot for as long as it is in scope.
+class FServerProfileScope
+{
+public:
+	FServerProfileScope( SERVERPROFILEPHASE_e Phase ) : _phase( Phase ), _active( g_bServerProfileActive )
+	{
+		if ( _active )
+			SERVERPROFILE_StartTimer( _phase );
+	}
+
+	~FServerProfileScope( )
+	{
+		if ( _active )
+			SERVERPROFILE_StopTimer( _phase );
+	}
+
+private:
+	SERVERPROFILEPHASE_e	_phase;
+	bool					_active;
+};
+
+#endif	// __SV_PROFILE_H__
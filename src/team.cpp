@@ -1043,6 +1043,7 @@ void TEAM_SetScore( ULONG ulTeamIdx, LONG lScore, bool bAnnouncer )
 
 		// Also, update the scoreboard.
 		SERVERCONSOLE_UpdateScoreboard( );
+		SERVER_MASTER_InvalidateServerInfo( );
 	}
 
 	// Implement the pointlimit.
@@ -1300,6 +1301,7 @@ void TEAM_SetFragCount( ULONG ulTeamIdx, LONG lFragCount, bool bAnnounce )
 
 		// Also, update the scoreboard.
 		SERVERCONSOLE_UpdateScoreboard( );
+		SERVER_MASTER_InvalidateServerInfo( );
 	}
 }
 
@@ -1366,6 +1368,7 @@ void TEAM_SetWinCount( ULONG ulTeamIdx, LONG lWinCount, bool bAnnounce )
 
 		// Also, update the scoreboard.
 		SERVERCONSOLE_UpdateScoreboard( );
+		SERVER_MASTER_InvalidateServerInfo( );
 	}
 }
 
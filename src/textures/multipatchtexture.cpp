@@ -159,6 +159,7 @@ public:
 	FTextureFormat GetFormat();
 	bool UseBasePalette() ;
 	void Unload ();
+	void PrefetchPixels ();
 	virtual void SetFrontSkyLayer ();
 
 	int CopyTrueColorPixels(FBitmap *bmp, int x, int y, int rotate, FCopyInfo *inf = NULL);
@@ -364,6 +365,38 @@ void FMultiPatchTexture::Unload ()
 	}
 }
 
+//==========================================================================
+//
+// FMultiPatchTexture :: PrefetchPixels
+//
+// Composition stays on the main thread, but the patches can be decoded
+// ahead of it. Translucent textures are composited in true color, which
+// doesn't use the patches' pixels.
+//
+//==========================================================================
+
+void FMultiPatchTexture::PrefetchPixels ()
+{
+	if (!bRedirect && Pixels != NULL)
+	{
+		return;
+	}
+	for (int i = 0; i < NumParts; ++i)
+	{
+		if (Parts[i].op != OP_COPY)
+		{
+			return;
+		}
+	}
+	for (int i = 0; i < NumParts; ++i)
+	{
+		if (!Parts[i].Texture->bHasCanvas)
+		{
+			Parts[i].Texture->PrefetchPixels ();
+		}
+	}
+}
+
 //==========================================================================
 //
 // FMultiPatchTexture :: GetPixels
@@ -64,6 +64,7 @@ public:
 	const BYTE *GetColumn (unsigned int column, const Span **spans_out);
 	const BYTE *GetPixels ();
 	void Unload ();
+	void PrefetchPixels ();
 
 protected:
 	BYTE *Pixels;
@@ -72,6 +73,7 @@ protected:
 
 
 	virtual void MakeTexture ();
+	BYTE *DecodePixels (FileReader &lump) const;
 	void HackHack (int newheight);
 };
 
@@ -179,6 +181,7 @@ FPatchTexture::~FPatchTexture ()
 
 void FPatchTexture::Unload ()
 {
+	CancelDecode ();
 	if (Pixels != NULL)
 	{
 		delete[] Pixels;
@@ -192,9 +195,23 @@ void FPatchTexture::Unload ()
 //
 //==========================================================================
 
-const BYTE *FPatchTexture::GetPixels ()
+void FPatchTexture::PrefetchPixels ()
 {
 	if (Pixels == NULL)
+	{
+		QueueDecode ();
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+const BYTE *FPatchTexture::GetPixels ()
+{
+	if (Pixels == NULL && (Pixels = TakeDecodedPixels ()) == NULL)
 	{
 		MakeTexture ();
 	}
@@ -209,7 +226,7 @@ const BYTE *FPatchTexture::GetPixels ()
 
 const BYTE *FPatchTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && (Pixels = TakeDecodedPixels ()) == NULL)
 	{
 		MakeTexture ();
 	}
@@ -244,15 +261,30 @@ const BYTE *FPatchTexture::GetColumn (unsigned int column, const Span **spans_ou
 
 void FPatchTexture::MakeTexture ()
 {
+	FWadLump lump = Wads.OpenLumpNum (SourceLump);
+	Pixels = DecodePixels (lump);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+BYTE *FPatchTexture::DecodePixels (FileReader &lump) const
+{
+	BYTE *pixels;
 	BYTE *remap, remaptable[256];
 	int numspans;
 	const column_t *maxcol;
 	int x;
 
-	FMemLump lump = Wads.ReadLump (SourceLump);
-	const patch_t *patch = (const patch_t *)lump.GetMem();
+	TArray<BYTE> data;
+	data.Resize (lump.GetLength());
+	lump.Read (&data[0], data.Size());
+	const patch_t *patch = (const patch_t *)&data[0];
 
-	maxcol = (const column_t *)((const BYTE *)patch + Wads.LumpLength (SourceLump) - 3);
+	maxcol = (const column_t *)((const BYTE *)patch + data.Size() - 3);
 
 	// Check for badly-sized patches
 #if 0	// Such textures won't be created so there's no need to check here
@@ -284,11 +316,11 @@ void FPatchTexture::MakeTexture ()
 
 	if (hackflag)
 	{
-		Pixels = new BYTE[Width * Height];
+		pixels = new BYTE[Width * Height];
 		BYTE *out;
 
 		// Draw the image to the buffer
-		for (x = 0, out = Pixels; x < Width; ++x)
+		for (x = 0, out = pixels; x < Width; ++x)
 		{
 			const BYTE *in = (const BYTE *)patch + LittleLong(patch->columnofs[x]) + 3;
 
@@ -298,7 +330,7 @@ void FPatchTexture::MakeTexture ()
 				out++, in++;
 			}
 		}
-		return;
+		return pixels;
 	}
 
 	// Add a little extra space at the end if the texture's height is not
@@ -307,13 +339,13 @@ void FPatchTexture::MakeTexture ()
 
 	numspans = Width;
 
-	Pixels = new BYTE[numpix];
-	memset (Pixels, 0, numpix);
+	pixels = new BYTE[numpix];
+	memset (pixels, 0, numpix);
 
 	// Draw the image to the buffer
 	for (x = 0; x < Width; ++x)
 	{
-		BYTE *outtop = Pixels + x*Height;
+		BYTE *outtop = pixels + x*Height;
 		const column_t *column = (const column_t *)((const BYTE *)patch + LittleLong(patch->columnofs[x]));
 		int top = -1;
 
@@ -351,9 +383,9 @@ void FPatchTexture::MakeTexture ()
 			column = (const column_t *)((const BYTE *)column + column->length + 4);
 		}
 	}
+	return pixels;
 }
 
-
 //==========================================================================
 //
 // Fix for certain special patches on single-patch textures.
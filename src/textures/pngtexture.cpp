@@ -57,6 +57,7 @@ public:
 	const BYTE *GetColumn (unsigned int column, const Span **spans_out);
 	const BYTE *GetPixels ();
 	void Unload ();
+	void PrefetchPixels ();
 	FTextureFormat GetFormat ();
 	int CopyTrueColorPixels(FBitmap *bmp, int x, int y, int rotate, FCopyInfo *inf = NULL);
 	bool UseBasePalette();
@@ -76,6 +77,7 @@ protected:
 	DWORD StartOfIDAT;
 
 	void MakeTexture ();
+	BYTE *DecodePixels (FileReader &lump) const;
 
 	friend class FTexture;
 };
@@ -360,6 +362,7 @@ FPNGTexture::~FPNGTexture ()
 
 void FPNGTexture::Unload ()
 {
+	CancelDecode ();
 	if (Pixels != NULL)
 	{
 		delete[] Pixels;
@@ -373,6 +376,20 @@ void FPNGTexture::Unload ()
 //
 //==========================================================================
 
+void FPNGTexture::PrefetchPixels ()
+{
+	if (Pixels == NULL)
+	{
+		QueueDecode ();
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 FTextureFormat FPNGTexture::GetFormat()
 {
 #if 0
@@ -396,7 +413,7 @@ FTextureFormat FPNGTexture::GetFormat()
 
 const BYTE *FPNGTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && (Pixels = TakeDecodedPixels ()) == NULL)
 	{
 		MakeTexture ();
 	}
@@ -430,7 +447,7 @@ const BYTE *FPNGTexture::GetColumn (unsigned int column, const Span **spans_out)
 
 const BYTE *FPNGTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && (Pixels = TakeDecodedPixels ()) == NULL)
 	{
 		MakeTexture ();
 	}
@@ -456,31 +473,43 @@ void FPNGTexture::MakeTexture ()
 		lump = new FileReader(SourceFile.GetChars());
 	}
 
-	Pixels = new BYTE[Width*Height];
+	Pixels = DecodePixels (*lump);
+	delete lump;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+BYTE *FPNGTexture::DecodePixels (FileReader &lump) const
+{
+	BYTE *pixels = new BYTE[Width*Height];
 	if (StartOfIDAT == 0)
 	{
-		memset (Pixels, 0x99, Width*Height);
+		memset (pixels, 0x99, Width*Height);
 	}
 	else
 	{
 		DWORD len, id;
-		lump->Seek (StartOfIDAT, SEEK_SET);
-		lump->Read(&len, 4);
-		lump->Read(&id, 4);
+		lump.Seek (StartOfIDAT, SEEK_SET);
+		lump.Read(&len, 4);
+		lump.Read(&id, 4);
 
 		if (ColorType == 0 || ColorType == 3)	/* Grayscale and paletted */
 		{
-			M_ReadIDAT (lump, Pixels, Width, Height, Width, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+			M_ReadIDAT (&lump, pixels, Width, Height, Width, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
 
 			if (Width == Height)
 			{
 				if (PaletteMap != NULL)
 				{
-					FlipSquareBlockRemap (Pixels, Width, Height, PaletteMap);
+					FlipSquareBlockRemap (pixels, Width, Height, PaletteMap);
 				}
 				else
 				{
-					FlipSquareBlock (Pixels, Width, Height);
+					FlipSquareBlock (pixels, Width, Height);
 				}
 			}
 			else
@@ -488,14 +517,14 @@ void FPNGTexture::MakeTexture ()
 				BYTE *newpix = new BYTE[Width*Height];
 				if (PaletteMap != NULL)
 				{
-					FlipNonSquareBlockRemap (newpix, Pixels, Width, Height, Width, PaletteMap);
+					FlipNonSquareBlockRemap (newpix, pixels, Width, Height, Width, PaletteMap);
 				}
 				else
 				{
-					FlipNonSquareBlock (newpix, Pixels, Width, Height, Width);
+					FlipNonSquareBlock (newpix, pixels, Width, Height, Width);
 				}
-				BYTE *oldpix = Pixels;
-				Pixels = newpix;
+				BYTE *oldpix = pixels;
+				pixels = newpix;
 				delete[] oldpix;
 			}
 		}
@@ -506,9 +535,9 @@ void FPNGTexture::MakeTexture ()
 			BYTE *in, *out;
 			int x, y, pitch, backstep;
 
-			M_ReadIDAT (lump, tempix, Width, Height, Width*bytesPerPixel, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+			M_ReadIDAT (&lump, tempix, Width, Height, Width*bytesPerPixel, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
 			in = tempix;
-			out = Pixels;
+			out = pixels;
 
 			// Convert from source format to paletted, column-major.
 			// Formats with alpha maps are reduced to only 1 bit of alpha.
@@ -574,7 +603,7 @@ void FPNGTexture::MakeTexture ()
 			delete[] tempix;
 		}
 	}
-	delete lump;
+	return pixels;
 }
 
 //===========================================================================
@@ -45,6 +45,9 @@
 #include "v_video.h"
 #include "m_fixed.h"
 #include "textures/textures.h"
+#include "stats.h"
+#include "workerthreads.h"
+#include <unordered_map>
 
 typedef bool (*CheckFunc)(FileReader & file);
 typedef FTexture * (*CreateFunc)(FileReader & file, int lumpnum);
@@ -147,7 +150,7 @@ FTexture::FTexture (const char *name, int lumpnum)
   WidthBits(0), HeightBits(0), xScale(FRACUNIT), yScale(FRACUNIT), SourceLump(lumpnum),
   UseType(TEX_Any), bNoDecals(false), bNoRemap0(false), bWorldPanning(false),
   bMasked(true), bAlphaTexture(false), bHasCanvas(false), bWarped(0), bComplex(false), bMultiPatch(false), bKeepAround(false),
-  Rotations(0xFFFF), SkyOffset(0), Width(0), Height(0), WidthMask(0), Native(NULL)
+  Rotations(0xFFFF), SkyOffset(0), Width(0), Height(0), WidthMask(0), Native(NULL), bDecodeQueued(false)
 {
 	id.SetInvalid();
 	if (name != NULL)
@@ -599,6 +602,230 @@ const BYTE *FDummyTexture::GetPixels ()
 	return NULL;
 }
 
+//==========================================================================
+//
+// Background decoding
+//
+// The lump is read on the main thread and handed to a worker, which runs
+// the texture's DecodePixels on it. The result waits here until the
+// texture asks for its pixels. Everything in this block is protected by
+// DecodeMutex.
+//
+//==========================================================================
+
+enum
+{
+	DECODE_Queued,
+	DECODE_Working,
+	DECODE_Done
+};
+
+struct FTextureDecode
+{
+	int State;
+	BYTE *Source;
+	long SourceLength;
+	BYTE *Pixels;		// NULL if decoding failed
+};
+
+static std::mutex DecodeMutex;
+static std::condition_variable DecodeFinished;
+static std::unordered_map<const FTexture *, FTextureDecode> Decodes;
+static unsigned int DecodeStats[5];	// queued, used, waited for, decoded on the main thread, failed
+
+//==========================================================================
+//
+// FTexture :: PrefetchPixels
+//
+//==========================================================================
+
+void FTexture::PrefetchPixels ()
+{
+}
+
+//==========================================================================
+//
+// FTexture :: QueueDecode
+//
+//==========================================================================
+
+void FTexture::QueueDecode ()
+{
+	if (bDecodeQueued || SourceLump < 0)
+	{
+		return;
+	}
+
+	long len = Wads.LumpLength (SourceLump);
+	if (len <= 0)
+	{
+		return;
+	}
+	BYTE *source = new BYTE[len];
+	Wads.ReadLump (SourceLump, source);
+
+	{
+		std::lock_guard<std::mutex> lock(DecodeMutex);
+		FTextureDecode &entry = Decodes[this];
+		entry.State = DECODE_Queued;
+		entry.Source = source;
+		entry.SourceLength = len;
+		entry.Pixels = NULL;
+		DecodeStats[0]++;
+	}
+	bDecodeQueued = true;
+
+	const FTexture *self = this;
+	FWorkerThreads::Get().Submit([self]()
+	{
+		BYTE *source;
+		long len;
+		{
+			std::lock_guard<std::mutex> lock(DecodeMutex);
+			std::unordered_map<const FTexture *, FTextureDecode>::iterator it = Decodes.find(self);
+			if (it == Decodes.end() || it->second.State != DECODE_Queued)
+			{
+				return;	// cancelled, or already taken care of by a newer job
+			}
+			it->second.State = DECODE_Working;
+			source = it->second.Source;
+			len = it->second.SourceLength;
+		}
+
+		BYTE *pixels;
+		try
+		{
+			MemoryReader lump((const char *)source, len);
+			pixels = self->DecodePixels (lump);
+		}
+		catch (...)
+		{
+			// Let the main thread run into this again so that it gets reported.
+			pixels = NULL;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(DecodeMutex);
+			std::unordered_map<const FTexture *, FTextureDecode>::iterator it = Decodes.find(self);
+			if (it != Decodes.end())
+			{
+				FTextureDecode &entry = it->second;
+				delete[] entry.Source;
+				entry.Source = NULL;
+				entry.Pixels = pixels;
+				entry.State = DECODE_Done;
+				if (pixels == NULL)
+				{
+					DecodeStats[4]++;
+				}
+			}
+			else
+			{
+				delete[] pixels;
+			}
+		}
+		DecodeFinished.notify_all();
+	});
+}
+
+//==========================================================================
+//
+// Removes the texture's entry, waiting for the worker if it is busy with it.
+//
+//==========================================================================
+
+static BYTE *FinishDecode (const FTexture *tex, bool cancel)
+{
+	std::unique_lock<std::mutex> lock(DecodeMutex);
+	std::unordered_map<const FTexture *, FTextureDecode>::iterator it = Decodes.find(tex);
+	if (it == Decodes.end())
+	{
+		return NULL;
+	}
+	if (it->second.State == DECODE_Working)
+	{
+		if (!cancel) DecodeStats[2]++;
+		// A missing entry counts as finished. Don't use operator[] here, it would insert one.
+		DecodeFinished.wait(lock, [tex]
+		{
+			std::unordered_map<const FTexture *, FTextureDecode>::const_iterator entry = Decodes.find(tex);
+			return entry == Decodes.end() || entry->second.State != DECODE_Working;
+		});
+		it = Decodes.find(tex);
+		if (it == Decodes.end())
+		{
+			return NULL;
+		}
+	}
+	else if (it->second.State == DECODE_Queued && !cancel)
+	{
+		DecodeStats[3]++;
+	}
+
+	BYTE *pixels = it->second.Pixels;
+	if (it->second.Source != NULL)
+	{
+		delete[] it->second.Source;
+	}
+	Decodes.erase(it);
+	if (pixels != NULL && !cancel)
+	{
+		DecodeStats[1]++;
+	}
+	return pixels;
+}
+
+//==========================================================================
+//
+// FTexture :: TakeDecodedPixels
+//
+// A decode that hasn't started yet is dropped, since the main thread
+// would otherwise just sit there waiting for it.
+//
+//==========================================================================
+
+BYTE *FTexture::TakeDecodedPixels ()
+{
+	if (!bDecodeQueued)
+	{
+		return NULL;
+	}
+	bDecodeQueued = false;
+	return FinishDecode (this, false);
+}
+
+//==========================================================================
+//
+// FTexture :: CancelDecode
+//
+// Must be called by the destructor of every texture that queues itself,
+// before anything DecodePixels uses is gone.
+//
+//==========================================================================
+
+void FTexture::CancelDecode ()
+{
+	if (bDecodeQueued)
+	{
+		bDecodeQueued = false;
+		BYTE *pixels = FinishDecode (this, true);
+		if (pixels != NULL)
+		{
+			delete[] pixels;
+		}
+	}
+}
+
+ADD_STAT (texdecode)
+{
+	FString out;
+	std::lock_guard<std::mutex> lock(DecodeMutex);
+	out.Format ("Queued = %u, used = %u, stalls = %u (waited %u, decoded here %u), failed = %u, pending = %u",
+		DecodeStats[0], DecodeStats[1], DecodeStats[2] + DecodeStats[3], DecodeStats[2], DecodeStats[3],
+		DecodeStats[4], (unsigned int)Decodes.size());
+	return out;
+}
+
 //==========================================================================
 //
 // Debug stuff
@@ -1242,6 +1242,20 @@ void FTextureManager::PrecacheLevel (void)
 	memset (hitlist, 0, cnt);
 
 	screen->GetHitlist(hitlist);
+
+	// The software renderer needs the paletted pixels, so get the worker
+	// threads started on them. They are queued in the same order as they
+	// are precached below.
+	if (currentrenderer == 0)
+	{
+		for (int i = cnt - 1; i >= 0; i--)
+		{
+			if (hitlist[i] && ByIndex(i) != NULL)
+			{
+				ByIndex(i)->PrefetchPixels();
+			}
+		}
+	}
 	for (int i = cnt - 1; i >= 0; i--)
 	{
 		Renderer->PrecacheTexture(ByIndex(i), hitlist[i]);
@@ -2,6 +2,7 @@
 #define __TEXTURES_H
 
 #include "doomtype.h"
+#include <atomic>
 
 struct FloatRect
 {
@@ -302,10 +303,22 @@ public:
 
 	virtual void HackHack (int newheight);	// called by FMultipatchTexture to discover corrupt patches.
 
+	// Starts decoding the pixels on a worker thread, if this kind of texture supports it.
+	virtual void PrefetchPixels ();
+
 protected:
 	WORD Width, Height, WidthMask;
 	static BYTE GrayMap[256];
 	FNativeTexture *Native;
+	bool bDecodeQueued;		// Not a bitfield, because the decoding thread reads the ones above
+
+	// Decodes the texture's lump into a new pixel buffer. This can run on a
+	// worker thread, so it may only read members that stay the same while
+	// the texture is loaded and must not print anything.
+	virtual BYTE *DecodePixels (FileReader &lump) const { return NULL; }
+	void QueueDecode ();
+	BYTE *TakeDecodedPixels ();		// Returns NULL if the texture has to be decoded the normal way
+	void CancelDecode ();
 
 	FTexture (const char *name = NULL, int lumpnum = -1);
 
@@ -332,9 +345,24 @@ public:
 
 public:
 
+	// The material is published with a release store once it is complete, so
+	// that the wall queue's threads can look it up without locking.
+	class FMaterialPointer
+	{
+		std::atomic<FMaterial *> Ptr;
+
+	public:
+		FMaterialPointer () : Ptr(NULL) {}
+		FMaterialPointer (const FMaterialPointer &other) : Ptr(other.Get()) {}
+		FMaterialPointer &operator= (const FMaterialPointer &other) { Publish(other.Get()); return *this; }
+
+		FMaterial *Get () const { return Ptr.load(std::memory_order_acquire); }
+		void Publish (FMaterial *mat) { Ptr.store(mat, std::memory_order_release); }
+	};
+
 	struct MiscGLInfo
 	{
-		FMaterial *Material;
+		FMaterialPointer Material;
 		FGLTexture *SystemTexture;
 		FTexture *Brightmap;
 		FTexture *DecalTexture;					// This is needed for decals of UseType TEX_MiscPatch-
@@ -63,6 +63,7 @@
 #include "thingdef.h"
 #include "thingdef_exp.h"
 #include "a_sharedglobal.h"
+#include "startupprofile.h"
 
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 void InitThingdef();
@@ -347,17 +348,26 @@ void LoadActors ()
 	GlobalSymbols.ReleaseSymbols();
 	DropItemList.Clear();
 	FScriptPosition::ResetErrorCounter();
+	StartupProfile.Enter ("InitThingdef");
 	InitThingdef();
+	StartupProfile.Leave ();
+
+	// Parsing and resolving are timed separately, so -profilestartup
+	// shows whether the time goes into the scanner or into the expressions.
+	StartupProfile.Enter ("ParseDecorate");
 	lastlump = 0;
 	while ((lump = Wads.FindLump ("DECORATE", &lastlump)) != -1)
 	{
 		FScanner sc(lump);
 		ParseDecorate (sc);
 	}
+	StartupProfile.Leave ();
 	if (FScriptPosition::ErrorCounter > 0)
 	{
 		I_Error("%d errors while parsing DECORATE scripts", FScriptPosition::ErrorCounter);
 	}
+	StartupProfile.Enter ("FinishThingdef");
 	FinishThingdef();
+	StartupProfile.Leave ();
 }
 
@@ -32,10 +32,25 @@
 **
 */
 
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
 #include "doomtype.h"
+#include "templates.h"
 #include "i_system.h"
+#include "c_cvars.h"
+#include "stats.h"
 #include "v_palette.h"
 #include "v_pfx.h"
+#include "workerthreads.h"
+
+// 0 uses one thread per core, 1 converts everything on the main thread.
+CVAR (Int, vid_convertthreads, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+#define MAX_CONVERTBANDS	16
+#define MIN_THREADEDPIXELS	(256*1024)
+#define MIN_BANDROWS		32
 
 extern "C"
 {
@@ -43,6 +58,12 @@ extern "C"
 	PfxState GPfx;
 }
 
+cycle_t ConvertCycles;
+
+static std::mutex ConvertBandMutex;
+static std::condition_variable ConvertBandsDone;
+static int ConvertBandsRunning;
+
 static bool AnalyzeMask (DWORD mask, BYTE *shift);
 
 static void Palette16Generic (const PalEntry *pal);
@@ -148,6 +169,79 @@ void PfxState::SetFormat (int bits, uint32 redMask, uint32 greenMask, uint32 blu
 	}
 }
 
+//==========================================================================
+//
+// PfxState :: ConvertThreaded
+//
+// Each band starts at the source row and fraction it would have reached
+// had the whole surface been converted in one pass, so the result is
+// identical to calling Convert directly. The main thread converts the
+// first band itself.
+//
+//==========================================================================
+
+void PfxState::ConvertThreaded (BYTE *src, int srcpitch,
+	void *dest, int destpitch, int destwidth, int destheight,
+	fixed_t xstep, fixed_t ystep, fixed_t xfrac, fixed_t yfrac)
+{
+	ConvertCycles.Reset();
+	ConvertCycles.Clock();
+
+	int bands = vid_convertthreads;
+	if (bands <= 0)
+	{
+		bands = (int)std::thread::hardware_concurrency();
+	}
+	bands = clamp (bands, 1, MAX_CONVERTBANDS);
+	bands = MIN (bands, destheight / MIN_BANDROWS);
+
+	if (bands <= 1 || destwidth * destheight < MIN_THREADEDPIXELS)
+	{
+		Convert (src, srcpitch, dest, destpitch, destwidth, destheight,
+			xstep, ystep, xfrac, yfrac);
+		ConvertCycles.Unclock();
+		return;
+	}
+
+	void (*convert)(BYTE *, int, void *, int, int, int, fixed_t, fixed_t, fixed_t, fixed_t) = Convert;
+	int rowsperband = (destheight + bands - 1) / bands;
+
+	ConvertBandsRunning = 0;
+	for (int top = rowsperband; top < destheight; top += rowsperband)
+	{
+		int rows = MIN (rowsperband, destheight - top);
+		SQWORD yf = yfrac + (SQWORD)top * ystep;
+		BYTE *bandsrc = src + (yf >> FRACBITS) * srcpitch;
+		BYTE *banddest = (BYTE *)dest + top * destpitch;
+		fixed_t bandyfrac = (fixed_t)(yf & (FRACUNIT - 1));
+
+		{
+			std::lock_guard<std::mutex> lock(ConvertBandMutex);
+			ConvertBandsRunning++;
+		}
+		FWorkerThreads::Get().SubmitUrgent([=]()
+		{
+			convert (bandsrc, srcpitch, banddest, destpitch, destwidth, rows,
+				xstep, ystep, xfrac, bandyfrac);
+			{
+				std::lock_guard<std::mutex> lock(ConvertBandMutex);
+				ConvertBandsRunning--;
+			}
+			ConvertBandsDone.notify_all();
+		});
+	}
+
+	convert (src, srcpitch, dest, destpitch, destwidth, rowsperband,
+		xstep, ystep, xfrac, yfrac);
+	FWorkerThreads::Get().RunUrgentJobs ();
+
+	{
+		std::unique_lock<std::mutex> lock(ConvertBandMutex);
+		ConvertBandsDone.wait(lock, [] { return ConvertBandsRunning == 0; });
+	}
+	ConvertCycles.Unclock();
+}
+
 static bool AnalyzeMask (DWORD mask, BYTE *shiftout)
 {
 	BYTE shift = 0;
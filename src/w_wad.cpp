@@ -49,13 +49,13 @@
 #include "c_dispatch.h"
 #include "w_wad.h"
 #include "w_zip.h"
-#include "m_crc32.h"
 #include "v_text.h"
 #include "templates.h"
 #include "gi.h"
 #include "doomerrors.h"
 #include "resourcefiles/resourcefile.h"
 #include "md5.h"
+#include "stats.h"
 // [TP]
 #include "c_cvars.h"
 
@@ -80,6 +80,21 @@ struct FWadCollection::LumpRecord
 	FResourceLump *lump;
 };
 
+// Open addressing slots for the lookup tables. Each slot holds the highest
+// numbered lump with its key, the others are chained through NextLumpIndex.
+struct FWadCollection::NameSlot
+{
+	QWORD		name;
+	int			namespc;
+	DWORD		lump;		// NULL_INDEX if the slot is empty
+};
+
+struct FWadCollection::FullNameSlot
+{
+	DWORD		hash;
+	DWORD		lump;		// NULL_INDEX if the slot is empty
+};
+
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 extern bool nospriterename;
 
@@ -115,9 +130,9 @@ void uppercopy (char *to, const char *from)
 }
 
 FWadCollection::FWadCollection ()
-: FirstLumpIndex(NULL), NextLumpIndex(NULL),
-  FirstLumpIndex_FullName(NULL), NextLumpIndex_FullName(NULL), 
-  NumLumps(0)
+: NameIndex(NULL), NextLumpIndex(NULL),
+  FullNameIndex(NULL), NextLumpIndex_FullName(NULL), 
+  IndexMask(0), NumLumps(0)
 {
 }
 
@@ -128,20 +143,20 @@ FWadCollection::~FWadCollection ()
 
 void FWadCollection::DeleteAll ()
 {
-	if (FirstLumpIndex != NULL)
+	if (NameIndex != NULL)
 	{
-		delete[] FirstLumpIndex;
-		FirstLumpIndex = NULL;
+		delete[] NameIndex;
+		NameIndex = NULL;
 	}
 	if (NextLumpIndex != NULL)
 	{
 		delete[] NextLumpIndex;
 		NextLumpIndex = NULL;
 	}
-	if (FirstLumpIndex_FullName != NULL)
+	if (FullNameIndex != NULL)
 	{
-		delete[] FirstLumpIndex_FullName;
-		FirstLumpIndex_FullName = NULL;
+		delete[] FullNameIndex;
+		FullNameIndex = NULL;
 	}
 	if (NextLumpIndex_FullName != NULL)
 	{
@@ -227,10 +242,6 @@ void FWadCollection::InitMultipleFiles (/*TArray<FString> &filenames*/) // [BB]
 	RenameSprites();
 
 	// [RH] Set up hash table
-	FirstLumpIndex = new DWORD[NumLumps];
-	NextLumpIndex = new DWORD[NumLumps];
-	FirstLumpIndex_FullName = new DWORD[NumLumps];
-	NextLumpIndex_FullName = new DWORD[NumLumps];
 	InitHashChains ();
 	LumpInfo.ShrinkToFit();
 	Files.ShrinkToFit();
@@ -287,7 +298,7 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadinfo, bool bL
 		{
 			try
 			{
-				wadinfo = new FileReader(filename);
+				wadinfo = MappedFileReader::OpenFile(filename);
 			}
 			catch (CRecoverableError &err)
 			{ // Didn't find file
@@ -429,12 +440,8 @@ int FWadCollection::GetNumWads () const
 
 int FWadCollection::CheckNumForName (const char *name, int space)
 {
-	union
-	{
-		char uname[8];
-		QWORD qname;
-	};
-	DWORD i;
+	QWORD qname;
+	DWORD i, j;
 
 	if (name == NULL)
 	{
@@ -448,25 +455,25 @@ int FWadCollection::CheckNumForName (const char *name, int space)
 		return -1;
 	}
 
-	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumLumps];
+	qname = PackLumpName (name);
+	i = FindNameSlot (qname, space);
+	i = (i != NULL_INDEX) ? NameIndex[i].lump : NULL_INDEX;
 
-	while (i != NULL_INDEX)
+	// If the lump is from one of the special namespaces exclusive to Zips
+	// the check has to be done differently:
+	// If we find a lump with this name in the global namespace that does not come
+	// from a Zip return that. WADs don't know these namespaces and single lumps must
+	// work as well. Whichever of the two was added last wins.
+	if (space > ns_specialzipdirectory && (j = FindNameSlot (qname, ns_global)) != NULL_INDEX)
 	{
-		FResourceLump *lump = LumpInfo[i].lump;
-
-		if (lump->qwName == qname)
+		for (j = NameIndex[j].lump; j != NULL_INDEX && (i == NULL_INDEX || j > i); j = NextLumpIndex[j])
 		{
-			if (lump->Namespace == space) break;
-			// If the lump is from one of the special namespaces exclusive to Zips
-			// the check has to be done differently:
-			// If we find a lump with this name in the global namespace that does not come
-			// from a Zip return that. WADs don't know these namespaces and single lumps must
-			// work as well.
-			if (space > ns_specialzipdirectory && lump->Namespace == ns_global && 
-				!(lump->Flags & LUMPF_ZIPFILE)) break;
+			if (!(LumpInfo[j].lump->Flags & LUMPF_ZIPFILE))
+			{
+				i = j;
+				break;
+			}
 		}
-		i = NextLumpIndex[i];
 	}
 
 	return i != NULL_INDEX ? i : -1;
@@ -474,12 +481,6 @@ int FWadCollection::CheckNumForName (const char *name, int space)
 
 int FWadCollection::CheckNumForName (const char *name, int space, int wadnum, bool exact)
 {
-	FResourceLump *lump;
-	union
-	{
-		char uname[8];
-		QWORD qname;
-	};
 	DWORD i;
 
 	if (wadnum < 0)
@@ -487,16 +488,18 @@ int FWadCollection::CheckNumForName (const char *name, int space, int wadnum, bo
 		return CheckNumForName (name, space);
 	}
 
-	uppercopy (uname, name);
-	i = FirstLumpIndex[LumpNameHash (uname) % NumLumps];
+	i = FindNameSlot (PackLumpName (name), space);
+	if (i == NULL_INDEX)
+	{
+		return -1;
+	}
+	i = NameIndex[i].lump;
 
 	// If exact is true if will only find lumps in the same WAD, otherwise
 	// also those in earlier WADs.
 
 	while (i != NULL_INDEX &&
-		(lump = LumpInfo[i].lump, lump->qwName != qname ||
-		lump->Namespace != space ||
-		 (exact? (LumpInfo[i].wadnum != wadnum) : (LumpInfo[i].wadnum > wadnum)) ))
+		(exact? (LumpInfo[i].wadnum != wadnum) : (LumpInfo[i].wadnum > wadnum)))
 	{
 		i = NextLumpIndex[i];
 	}
@@ -544,14 +547,9 @@ int FWadCollection::CheckNumForFullName (const char *name, bool trynormal, int n
 		return -1;
 	}
 
-	i = FirstLumpIndex_FullName[MakeKey (name) % NumLumps];
-
-	while (i != NULL_INDEX && stricmp(name, LumpInfo[i].lump->FullName))
-	{
-		i = NextLumpIndex_FullName[i];
-	}
+	i = FindFullNameSlot (name, MakeKey (name));
 
-	if (i != NULL_INDEX) return i;
+	if (i != NULL_INDEX) return FullNameIndex[i].lump;
 
 	if (trynormal && strlen(name) <= 8 && !strpbrk(name, "./"))
 	{
@@ -569,10 +567,13 @@ int FWadCollection::CheckNumForFullName (const char *name, int wadnum)
 		return CheckNumForFullName (name);
 	}
 
-	i = FirstLumpIndex_FullName[MakeKey (name) % NumLumps];
+	i = FindFullNameSlot (name, MakeKey (name));
+	if (i == NULL_INDEX)
+	{
+		return -1;
+	}
 
-	while (i != NULL_INDEX && 
-		(stricmp(name, LumpInfo[i].lump->FullName) || LumpInfo[i].wadnum != wadnum))
+	for (i = FullNameIndex[i].lump; i != NULL_INDEX && LumpInfo[i].wadnum != wadnum; )
 	{
 		i = NextLumpIndex_FullName[i];
 	}
@@ -655,65 +656,218 @@ int FWadCollection::GetLumpFlags (int lump)
 
 //==========================================================================
 //
-// W_LumpNameHash
-//
-// NOTE: s should already be uppercase, in contrast to the BOOM version.
+// PackLumpName
 //
-// Hash function used for lump names.
-// Must be mod'ed with table size.
-// Can be used for any 8-character names.
+// Returns the name the way it's stored in FResourceLump::qwName, so that
+// names can be compared as a single integer. The uppercasing is done on
+// all eight characters at once.
 //
 //==========================================================================
 
-DWORD FWadCollection::LumpNameHash (const char *s)
+QWORD FWadCollection::PackLumpName (const char *name)
 {
-	const DWORD *table = GetCRCTable ();;
-	DWORD hash = 0xffffffff;
+	union
+	{
+		char cname[8];
+		QWORD qname;
+	};
 	int i;
 
-	for (i = 8; i > 0 && *s; --i, ++s)
+	for (i = 0; i < 8 && name[i]; i++)
+		cname[i] = name[i];
+	for (; i < 8; i++)
+		cname[i] = 0;
+
+	// A byte is a lowercase letter if adding 0x1f to its low 7 bits sets the top bit,
+	// adding 0x05 doesn't, and the top bit wasn't already set. Clearing 0x20 from each
+	// of those bytes can't borrow from the next one.
+	QWORD low = qname & QWORD(0x7f7f7f7f7f7f7f7f);
+	QWORD islower = (low + QWORD(0x1f1f1f1f1f1f1f1f)) & ~(low + QWORD(0x0505050505050505)) & ~qname & QWORD(0x8080808080808080);
+	return qname - (islower >> 2);
+}
+
+//==========================================================================
+//
+// Hashes for the lookup tables
+//
+//==========================================================================
+
+static inline DWORD HashLumpKey (QWORD name, int namespc)
+{
+	QWORD key = (name ^ (QWORD(namespc) * QWORD(0x9e3779b97f4a7c15))) * QWORD(0xff51afd7ed558ccd);
+	return DWORD(key >> 32);
+}
+
+//==========================================================================
+//
+// FindNameSlot
+//
+// Returns the slot for this name and namespace or NULL_INDEX.
+//
+//==========================================================================
+
+DWORD FWadCollection::FindNameSlot (QWORD name, int namespc) const
+{
+	if (NameIndex == NULL)
+	{
+		return NULL_INDEX;
+	}
+	for (DWORD i = HashLumpKey (name, namespc) & IndexMask; NameIndex[i].lump != NULL_INDEX; i = (i + 1) & IndexMask)
 	{
-		hash = CRC1 (hash, *s, table);
+		if (NameIndex[i].name == name && NameIndex[i].namespc == namespc)
+		{
+			return i;
+		}
 	}
-	return hash ^ 0xffffffff;
+	return NULL_INDEX;
+}
+
+//==========================================================================
+//
+// FindFullNameSlot
+//
+// The full hash is compared first so that stricmp only runs on real matches.
+//
+//==========================================================================
+
+DWORD FWadCollection::FindFullNameSlot (const char *name, DWORD hash) const
+{
+	if (FullNameIndex == NULL)
+	{
+		return NULL_INDEX;
+	}
+	for (DWORD i = hash & IndexMask; FullNameIndex[i].lump != NULL_INDEX; i = (i + 1) & IndexMask)
+	{
+		if (FullNameIndex[i].hash == hash && !stricmp (name, LumpInfo[FullNameIndex[i].lump].lump->FullName))
+		{
+			return i;
+		}
+	}
+	return NULL_INDEX;
 }
 
 //==========================================================================
 //
 // W_InitHashChains
 //
-// Prepares the lumpinfos for hashing.
+// Builds the lookup tables once all files have been added. Lumps are added
+// in order, so each chain runs from the newest lump to the oldest.
 // (Hey! This looks suspiciously like something from Boom! :-)
 //
 //==========================================================================
 
 void FWadCollection::InitHashChains (void)
 {
-	char name[8];
 	unsigned int i, j;
 
-	// Mark all buckets as empty
-	memset (FirstLumpIndex, 255, NumLumps*sizeof(FirstLumpIndex[0]));
+	// Keep the tables at most half full.
+	for (IndexMask = 15; IndexMask < NumLumps * 2; IndexMask = IndexMask * 2 + 1)
+	{
+	}
+
+	NameIndex = new NameSlot[IndexMask + 1];
+	FullNameIndex = new FullNameSlot[IndexMask + 1];
+	NextLumpIndex = new DWORD[NumLumps];
+	NextLumpIndex_FullName = new DWORD[NumLumps];
+
+	// Mark all slots as empty
+	for (i = 0; i <= IndexMask; i++)
+	{
+		NameIndex[i].lump = NULL_INDEX;
+		FullNameIndex[i].lump = NULL_INDEX;
+	}
 	memset (NextLumpIndex, 255, NumLumps*sizeof(NextLumpIndex[0]));
-	memset (FirstLumpIndex_FullName, 255, NumLumps*sizeof(FirstLumpIndex_FullName[0]));
 	memset (NextLumpIndex_FullName, 255, NumLumps*sizeof(NextLumpIndex_FullName[0]));
 
 	// Now set up the chains
 	for (i = 0; i < (unsigned)NumLumps; i++)
 	{
-		uppercopy (name, LumpInfo[i].lump->Name);
-		j = LumpNameHash (name) % NumLumps;
-		NextLumpIndex[i] = FirstLumpIndex[j];
-		FirstLumpIndex[j] = i;
+		FResourceLump *lump = LumpInfo[i].lump;
+
+		j = FindNameSlot (lump->qwName, lump->Namespace);
+		if (j == NULL_INDEX)
+		{
+			for (j = HashLumpKey (lump->qwName, lump->Namespace) & IndexMask; NameIndex[j].lump != NULL_INDEX; j = (j + 1) & IndexMask)
+			{
+			}
+			NameIndex[j].name = lump->qwName;
+			NameIndex[j].namespc = lump->Namespace;
+		}
+		NextLumpIndex[i] = NameIndex[j].lump;
+		NameIndex[j].lump = i;
 
 		// Do the same for the full paths
-		if (LumpInfo[i].lump->FullName!=NULL)
+		if (lump->FullName != NULL)
 		{
-			j = MakeKey(LumpInfo[i].lump->FullName) % NumLumps;
-			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
-			FirstLumpIndex_FullName[j] = i;
+			DWORD hash = MakeKey (lump->FullName);
+
+			j = FindFullNameSlot (lump->FullName, hash);
+			if (j == NULL_INDEX)
+			{
+				for (j = hash & IndexMask; FullNameIndex[j].lump != NULL_INDEX; j = (j + 1) & IndexMask)
+				{
+				}
+				FullNameIndex[j].hash = hash;
+			}
+			NextLumpIndex_FullName[i] = FullNameIndex[j].lump;
+			FullNameIndex[j].lump = i;
+		}
+	}
+}
+
+//==========================================================================
+//
+// CCMD benchlumplookups
+//
+// Times the name lookups that dominate startup for large mods.
+//
+//==========================================================================
+
+CCMD (benchlumplookups)
+{
+	int passes = (argv.argc() > 1) ? MAX (atoi (argv[1]), 1) : 10;
+	unsigned int lookups = 0, fulllookups = 0;
+	int found = 0;
+	cycle_t names, fullnames;
+	char name[9];
+
+	names.Reset();
+	fullnames.Reset();
+	for (int pass = 0; pass < passes; ++pass)
+	{
+		names.Clock();
+		for (int i = 0; i < Wads.GetNumLumps(); ++i)
+		{
+			Wads.GetLumpName (name, i);
+			name[8] = 0;
+			for (int j = 0; j < 8 && name[j]; ++j)
+			{
+				name[j] = tolower (name[j]);
+			}
+			found += (Wads.CheckNumForName (name, Wads.GetLumpNamespace (i)) >= 0);
+			found += (Wads.CheckNumForName (name, ns_sprites) >= 0);
+			lookups += 2;
 		}
+		names.Unclock();
+
+		fullnames.Clock();
+		for (int i = 0; i < Wads.GetNumLumps(); ++i)
+		{
+			const char *fullname = Wads.GetLumpFullName (i);
+			if (fullname != NULL)
+			{
+				found += (Wads.CheckNumForFullName (fullname) >= 0);
+				fulllookups++;
+			}
+		}
+		fullnames.Unclock();
 	}
+
+	Printf ("%u name lookups: %.3f ms (%.1f ns each)\n", lookups, names.TimeMS(),
+		lookups ? names.TimeMS() * 1e6 / lookups : 0.);
+	Printf ("%u full name lookups: %.3f ms (%.1f ns each)\n", fulllookups, fullnames.TimeMS(),
+		fulllookups ? fullnames.TimeMS() * 1e6 / fulllookups : 0.);
+	DPrintf ("%d found\n", found);
 }
 
 //==========================================================================
@@ -1337,6 +1491,104 @@ int FWadCollection::GetWadnumFromWadFullName ( const char *FullName ) const
 	return -1;
 }
 
+//==========================================================================
+//
+// PrefetchLump
+//
+// Tells the OS that the lump is going to be read soon, if it's stored
+// uncompressed in a mapped file. Compressed lumps are decompressed in
+// the background instead.
+//
+//==========================================================================
+
+void FWadCollection::PrefetchLump (int lump) const
+{
+	if ((unsigned)lump >= (unsigned)NumLumps)
+	{
+		return;
+	}
+
+	FResourceLump *l = LumpInfo[lump].lump;
+	if (l->Owner == NULL || l->Owner->Reader == NULL)
+	{
+		return;
+	}
+
+	int offset = l->GetFileOffset();
+	if (offset >= 0)
+	{
+		l->Owner->Reader->Prefetch(offset, l->LumpSize);
+	}
+	else
+	{
+		l->Prefetch();
+	}
+}
+
+//==========================================================================
+//
+// GetLumpMemory
+//
+// Lumps that are stored uncompressed in a mapped file can be used directly
+// from the mapping. The pointer stays valid for as long as the file is open.
+//
+//==========================================================================
+
+const char *FWadCollection::GetLumpMemory (int lump) const
+{
+	if ((unsigned)lump >= (unsigned)NumLumps)
+	{
+		return NULL;
+	}
+
+	FResourceLump *l = LumpInfo[lump].lump;
+	if (l->Owner == NULL || l->Owner->Reader == NULL || (l->Flags & LUMPF_BLOODCRYPT))
+	{
+		return NULL;
+	}
+
+	const char *buffer = l->Owner->Reader->GetBuffer();
+	if (buffer == NULL)
+	{
+		return NULL;
+	}
+	int offset = l->GetFileOffset();
+	return offset >= 0 ? buffer + offset : NULL;
+}
+
+//==========================================================================
+//
+// PrefetchLumps
+//
+// Prefetches a batch of lumps, e.g. everything a map is going to need.
+//
+//==========================================================================
+
+void FWadCollection::PrefetchLumps (const TArray<int> &lumps) const
+{
+	for (unsigned int i = 0; i < lumps.Size(); ++i)
+	{
+		PrefetchLump (lumps[i]);
+	}
+}
+
+//==========================================================================
+//
+// PrefetchNamespace
+//
+//==========================================================================
+
+void FWadCollection::PrefetchNamespace (int namespc) const
+{
+	for (DWORD i = 0; i < NumLumps; ++i)
+	{
+		if (LumpInfo[i].lump->Namespace == namespc)
+		{
+			PrefetchLump (i);
+		}
+	}
+}
+
 //==========================================================================
 //
 // IsUncompressedFile
@@ -1504,7 +1756,8 @@ FWadLump::FWadLump(FResourceLump *lump, bool alwayscache)
 {
 	FileReader *f = lump->GetReader();
 
-	if (f != NULL && f->GetFile() != NULL && !alwayscache)
+	// Lumps in mapped files are read from the mapping, which doesn't need a copy.
+	if (f != NULL && f->GetFile() != NULL && f->GetBuffer() == NULL && !alwayscache)
 	{
 		// Uncompressed lump in a file
 		File = f->GetFile();
@@ -187,7 +187,7 @@ public:
 	int FindLumpMulti (const char **names, int *lastlump, bool anyns = false, int *nameindex = NULL); // same with multiple possible names
 	bool CheckLumpName (int lump, const char *name);	// [RH] True if lump's name == name
 
-	static DWORD LumpNameHash (const char *name);		// [RH] Create hash key from an 8-char name
+	static QWORD PackLumpName (const char *name);		// Uppercases and zero pads an 8-char name into a single key
 
 	int LumpLength (int lump) const;
 	int GetLumpOffset (int lump);					// [RH] Returns offset of lump in the wadfile
@@ -201,6 +201,10 @@ public:
 	bool CheckLumpName (int lump, const char *name) const;	// [RH] Returns true if the names match
 
 	bool IsUncompressedFile(int lump) const;
+	void PrefetchLump (int lump) const;				// Hints that the lump is going to be read soon
+	void PrefetchLumps (const TArray<int> &lumps) const;
+	void PrefetchNamespace (int namespc) const;
+	const char *GetLumpMemory (int lump) const;		// Returns the lump's data if it can be read in place, otherwise NULL
 	bool IsEncryptedFile(int lump) const;
 
 	int GetNumLumps () const;
@@ -229,17 +233,24 @@ protected:
 	TArray<FResourceFile *> Files;
 	TArray<LumpRecord> LumpInfo;
 
-	DWORD *FirstLumpIndex;	// [RH] Hashing stuff moved out of lumpinfo structure
-	DWORD *NextLumpIndex;
+	struct NameSlot;
+	struct FullNameSlot;
 
-	DWORD *FirstLumpIndex_FullName;	// The same information for fully qualified paths from .zips
+	NameSlot *NameIndex;			// [RH] Hashing stuff moved out of lumpinfo structure
+	DWORD *NextLumpIndex;			// Next lower lump with the same name and namespace
+
+	FullNameSlot *FullNameIndex;	// The same information for fully qualified paths from .zips
 	DWORD *NextLumpIndex_FullName;
 
+	DWORD IndexMask;				// Both indices have IndexMask+1 slots
+
 	DWORD NumLumps;					// Not necessarily the same as LumpInfo.Size()
 	DWORD NumWads;
 
 	void SkinHack (int baselump);
 	void InitHashChains ();								// [RH] Set up the lumpinfo hashing
+	DWORD FindNameSlot (QWORD name, int namespc) const;
+	DWORD FindFullNameSlot (const char *name, DWORD hash) const;
 
 private:
 	void RenameSprites();
@@ -1135,7 +1135,7 @@ void DDrawFB::Update ()
 				LOG3 ("Copy %dx%d (%d)\n", Width, Height, BufferPitch);
 				if (UsePfx)
 				{
-					GPfx.Convert (MemBuffer, BufferPitch,
+					GPfx.ConvertThreaded (MemBuffer, BufferPitch,
 						writept, Pitch, Width << PixelDoubling, Height << PixelDoubling,
 						FRACUNIT >> PixelDoubling, FRACUNIT >> PixelDoubling, 0, 0);
 				}
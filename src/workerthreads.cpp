@@ -0,0 +1,215 @@
+/*
+** workerthreads.cpp
+** A small pool of threads for background work
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#include "workerthreads.h"
+
+static thread_local bool InWorkerThread;
+
+//==========================================================================
+//
+// FWorkerThreads :: FWorkerThreads
+//
+//==========================================================================
+
+FWorkerThreads::FWorkerThreads (int numthreads)
+: Running(0), Quit(false)
+{
+	if (numthreads < 1)
+	{
+		numthreads = 1;
+	}
+	for (int i = 0; i < numthreads; ++i)
+	{
+		Threads.push_back(std::thread(&FWorkerThreads::WorkerLoop, this));
+	}
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: ~FWorkerThreads
+//
+// Jobs that haven't been started yet are dropped.
+//
+//==========================================================================
+
+FWorkerThreads::~FWorkerThreads ()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Quit = true;
+		UrgentJobs.clear();
+		Jobs.clear();
+	}
+	JobReady.notify_all();
+	for (size_t i = 0; i < Threads.size(); ++i)
+	{
+		Threads[i].join();
+	}
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: Submit
+//
+//==========================================================================
+
+void FWorkerThreads::Submit (std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Jobs.push_back(std::move(job));
+	}
+	JobReady.notify_one();
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: SubmitUrgent
+//
+//==========================================================================
+
+void FWorkerThreads::SubmitUrgent (std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		UrgentJobs.push_back(std::move(job));
+	}
+	JobReady.notify_one();
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: RunUrgentJobs
+//
+// Runs the urgent jobs that no worker has started yet on the calling
+// thread.
+//
+//==========================================================================
+
+void FWorkerThreads::RunUrgentJobs ()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (!UrgentJobs.empty())
+	{
+		std::function<void()> job = std::move(UrgentJobs.front());
+		UrgentJobs.pop_front();
+		++Running;
+		lock.unlock();
+
+		job();
+
+		lock.lock();
+		--Running;
+	}
+	if (Jobs.empty() && Running == 0)
+	{
+		JobsDone.notify_all();
+	}
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: Wait
+//
+// Blocks until all submitted jobs have finished.
+//
+//==========================================================================
+
+void FWorkerThreads::Wait ()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	JobsDone.wait(lock, [this] { return UrgentJobs.empty() && Jobs.empty() && Running == 0; });
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: WorkerLoop
+//
+//==========================================================================
+
+void FWorkerThreads::WorkerLoop ()
+{
+	InWorkerThread = true;
+
+	std::unique_lock<std::mutex> lock(Mutex);
+	for (;;)
+	{
+		JobReady.wait(lock, [this] { return Quit || !UrgentJobs.empty() || !Jobs.empty(); });
+		if (Quit)
+		{
+			return;
+		}
+
+		std::deque<std::function<void()> > &queue = UrgentJobs.empty() ? Jobs : UrgentJobs;
+		std::function<void()> job = std::move(queue.front());
+		queue.pop_front();
+		++Running;
+		lock.unlock();
+
+		job();
+
+		lock.lock();
+		--Running;
+		if (UrgentJobs.empty() && Jobs.empty() && Running == 0)
+		{
+			JobsDone.notify_all();
+		}
+	}
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: IsWorkerThread
+//
+//==========================================================================
+
+bool FWorkerThreads::IsWorkerThread ()
+{
+	return InWorkerThread;
+}
+
+//==========================================================================
+//
+// FWorkerThreads :: Get
+//
+// Leaves one core for the main thread.
+//
+//==========================================================================
+
+FWorkerThreads &FWorkerThreads::Get ()
+{
+	static FWorkerThreads pool((int)std::thread::hardware_concurrency() - 1);
+	return pool;
+}
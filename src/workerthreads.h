@@ -0,0 +1,87 @@
+/*
+** workerthreads.h
+** A small pool of threads for background work
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 Zandronum Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+**
+*/
+
+#ifndef __WORKERTHREADS_H
+#define __WORKERTHREADS_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+// Runs jobs in the background on a fixed number of threads. Jobs must not
+// touch the playsim, the console or anything else that isn't thread safe,
+// and must not throw.
+//
+// Jobs the current frame waits for are submitted as urgent. Workers take
+// them before any normal job, and the thread that waits for them should
+// call RunUrgentJobs first, so that workers busy with long background jobs
+// can't hold up the frame.
+class FWorkerThreads
+{
+public:
+	FWorkerThreads (int numthreads);
+	~FWorkerThreads ();
+
+	void Submit (std::function<void()> job);
+	void SubmitUrgent (std::function<void()> job);
+	void RunUrgentJobs ();
+	void Wait ();
+	int NumThreads () const { return (int)Threads.size(); }
+
+	// Jobs that split their work up themselves should do it all on the
+	// calling thread when this is true, since waiting for other jobs from
+	// inside a job can deadlock the pool.
+	static bool IsWorkerThread ();
+
+	// The shared pool. It is started the first time it's needed.
+	static FWorkerThreads &Get ();
+
+private:
+	void WorkerLoop ();
+
+	std::vector<std::thread> Threads;
+	std::deque<std::function<void()> > UrgentJobs;
+	std::deque<std::function<void()> > Jobs;
+	std::mutex Mutex;
+	std::condition_variable JobReady;
+	std::condition_variable JobsDone;
+	int Running;
+	bool Quit;
+};
+
+#endif